@@ -0,0 +1,388 @@
+/*
+ * Benchmarks.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/*
+ * @file  Benchmarks.cc
+ * @brief Microbenchmarks of the phases of a simulation step: building the
+ *        agent k-D tree, the agent and obstacle neighbor queries, the
+ *        computation of new velocities by the linear programs, processing of
+ *        obstacles, and visibility queries. Each benchmark isolates its phase
+ *        through the scenario it sets up.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "RVOSimulator.h"
+#include "Scenario.h"
+#include "Vector2.h"
+
+namespace {
+/**
+ * @brief The seed of the random number generator of each benchmark.
+ */
+const unsigned long RVO_BENCHMARK_SEED = 42UL;
+
+/**
+ * @brief The radius of an agent.
+ */
+const float RVO_BENCHMARK_AGENT_RADIUS = 0.4F;
+
+/**
+ * @brief The side length of a square obstacle.
+ */
+const float RVO_BENCHMARK_OBSTACLE_SIZE = 1.0F;
+
+/**
+ * @brief The distance between the centers of neighboring square obstacles in
+ *        a lattice.
+ */
+const float RVO_BENCHMARK_OBSTACLE_SPACING = 4.0F;
+
+/**
+ * @brief     Adds agents on a jittered square grid centered on the origin.
+ * @param[in] simulator  The simulator to which to add the agents.
+ * @param[in] numAgents  The count of agents to add.
+ * @param[in] density    The count of agents per 100 square units of area.
+ * @param[in] random     The random number generator for the jitter.
+ */
+void addAgentGrid(
+    RVO::RVOSimulator *simulator, std::size_t numAgents, float density,
+    RVO::ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const std::size_t side = static_cast<std::size_t>(
+      std::ceil(std::sqrt(static_cast<float>(numAgents))));
+  const float spacing = 10.0F / std::sqrt(density);
+  const float offset = -0.5F * spacing * static_cast<float>(side);
+  const float jitter = 0.25F * spacing;
+
+  for (std::size_t i = 0U; i < numAgents; ++i) {
+    simulator->addAgent(RVO::Vector2(
+        offset + spacing * static_cast<float>(i % side) +
+            random.uniform(-jitter, jitter),
+        offset + spacing * static_cast<float>(i / side) +
+            random.uniform(-jitter, jitter)));
+  }
+}
+
+/**
+ * @brief     Makes a square obstacle.
+ * @param[in] center The center of the obstacle.
+ * @param[in] size   The side length of the obstacle.
+ * @return    The vertices of the obstacle in counterclockwise order.
+ */
+std::vector<RVO::Vector2> makeSquare(const RVO::Vector2 &center, float size) {
+  std::vector<RVO::Vector2> vertices;
+  vertices.push_back(center + 0.5F * RVO::Vector2(-size, -size));
+  vertices.push_back(center + 0.5F * RVO::Vector2(size, -size));
+  vertices.push_back(center + 0.5F * RVO::Vector2(size, size));
+  vertices.push_back(center + 0.5F * RVO::Vector2(-size, size));
+
+  return vertices;
+}
+
+/**
+ * @brief     Adds a square lattice of square obstacles centered on the origin
+ *            and processes them.
+ * @param[in] simulator    The simulator to which to add the obstacles.
+ * @param[in] numObstacles The count of obstacles to add.
+ * @return    The half-width of the lattice.
+ */
+float addObstacleLattice(RVO::RVOSimulator *simulator,
+                         std::size_t numObstacles) {
+  const std::size_t side = static_cast<std::size_t>(
+      std::ceil(std::sqrt(static_cast<float>(numObstacles))));
+  const float halfWidth =
+      0.5F * RVO_BENCHMARK_OBSTACLE_SPACING * static_cast<float>(side);
+
+  for (std::size_t i = 0U; i < numObstacles; ++i) {
+    simulator->addObstacle(makeSquare(
+        RVO::Vector2(-halfWidth + RVO_BENCHMARK_OBSTACLE_SPACING *
+                                      (static_cast<float>(i % side) + 0.5F),
+                     -halfWidth + RVO_BENCHMARK_OBSTACLE_SPACING *
+                                      (static_cast<float>(i / side) + 0.5F)),
+        RVO_BENCHMARK_OBSTACLE_SIZE));
+  }
+
+  simulator->processObstacles();
+
+  return halfWidth;
+}
+
+/**
+ * @brief     Sets the preferred velocities of all agents to unit vectors in
+ *            roughly the same direction, so that the agents flow without the
+ *            density of the crowd changing much.
+ * @param[in] simulator The simulator whose agents to modify.
+ * @param[in] random    The random number generator for the directions.
+ */
+void setFlowPrefVelocities(
+    RVO::RVOSimulator *simulator,
+    RVO::ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  std::vector<RVO::Vector2> prefVelocities(simulator->getNumAgents());
+
+  for (std::size_t i = 0U; i < prefVelocities.size(); ++i) {
+    const RVO::Real angle = random.uniform(-0.25F, 0.25F);
+    prefVelocities[i] = RVO::Vector2(std::cos(angle), std::sin(angle));
+  }
+
+  if (!prefVelocities.empty()) {
+    simulator->setAgentPrefVelocities(&prefVelocities[0],
+                                      prefVelocities.size());
+  }
+}
+
+/* Building the agent k-D tree. The agents have no agent neighbors, so the
+ * remainder of each step is negligible. Arguments: agent count. */
+void BM_BuildAgentTree(benchmark::State &state) { /* NOLINT */
+  const std::size_t numAgents = static_cast<std::size_t>(state.range(0));
+  RVO::ScenarioRandom random(RVO_BENCHMARK_SEED);
+  RVO::RVOSimulator simulator(0.25F, 0.0F, 0U, 5.0F, 5.0F,
+                              RVO_BENCHMARK_AGENT_RADIUS, 1.5F);
+  addAgentGrid(&simulator, numAgents, 25.0F, random);
+  setFlowPrefVelocities(&simulator, random);
+
+  for (auto _ : state) {
+    simulator.doStep();
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<benchmark::IterationCount>(numAgents));
+}
+
+/* The agent neighbor queries and the computation of new velocities by the
+ * first and second linear programs in a flowing crowd. Arguments: agent count,
+ * agents per 100 square units, and maximum count of agent neighbors. */
+void BM_ComputeNewVelocity(benchmark::State &state) { /* NOLINT */
+  const std::size_t numAgents = static_cast<std::size_t>(state.range(0));
+  RVO::ScenarioRandom random(RVO_BENCHMARK_SEED);
+  RVO::RVOSimulator simulator(0.25F, 5.0F,
+                              static_cast<std::size_t>(state.range(2)), 5.0F,
+                              5.0F, RVO_BENCHMARK_AGENT_RADIUS, 1.5F);
+  addAgentGrid(&simulator, numAgents, static_cast<float>(state.range(1)),
+               random);
+  setFlowPrefVelocities(&simulator, random);
+
+  for (auto _ : state) {
+    simulator.doStep();
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<benchmark::IterationCount>(numAgents));
+}
+
+/* The computation of new velocities in a crowd of overlapping agents pushing
+ * toward a common goal, for which the second linear program mostly fails and
+ * the third linear program runs. Arguments: agent count and maximum count of
+ * agent neighbors. */
+void BM_ComputeNewVelocityCongested(benchmark::State &state) { /* NOLINT */
+  const std::size_t numAgents = static_cast<std::size_t>(state.range(0));
+  RVO::ScenarioRandom random(RVO_BENCHMARK_SEED);
+  RVO::RVOSimulator simulator(0.25F, 5.0F,
+                              static_cast<std::size_t>(state.range(1)), 5.0F,
+                              5.0F, RVO_BENCHMARK_AGENT_RADIUS, 1.5F);
+  addAgentGrid(&simulator, numAgents, 200.0F, random);
+
+  for (std::size_t i = 0U; i < numAgents; ++i) {
+    simulator.setAgentGoal(i, RVO::Vector2(0.0F, 0.0F), 1.0F, 0.0F);
+  }
+
+  for (auto _ : state) {
+    simulator.doStep();
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<benchmark::IterationCount>(numAgents));
+}
+
+/* The obstacle neighbor queries and obstacle ORCA lines of agents moving
+ * through a lattice of obstacles. The agents have no agent neighbors.
+ * Arguments: agent count and obstacle count. */
+void BM_ComputeObstacleNeighbors(benchmark::State &state) { /* NOLINT */
+  const std::size_t numAgents = static_cast<std::size_t>(state.range(0));
+  RVO::ScenarioRandom random(RVO_BENCHMARK_SEED);
+  RVO::RVOSimulator simulator(0.25F, 0.0F, 0U, 5.0F, 5.0F,
+                              RVO_BENCHMARK_AGENT_RADIUS, 1.5F);
+  const float halfWidth = addObstacleLattice(
+      &simulator, static_cast<std::size_t>(state.range(1)));
+  const float density = 100.0F * static_cast<float>(numAgents) /
+                        (4.0F * halfWidth * halfWidth);
+  addAgentGrid(&simulator, numAgents, density, random);
+  setFlowPrefVelocities(&simulator, random);
+
+  for (auto _ : state) {
+    simulator.doStep();
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<benchmark::IterationCount>(numAgents));
+}
+
+/* Processing randomly placed, possibly overlapping square obstacles into the
+ * obstacle k-D tree. Arguments: obstacle count. */
+void BM_ProcessObstacles(benchmark::State &state) { /* NOLINT */
+  const std::size_t numObstacles = static_cast<std::size_t>(state.range(0));
+  const float halfWidth = 0.5F * RVO_BENCHMARK_OBSTACLE_SPACING *
+                          std::sqrt(static_cast<float>(numObstacles));
+  RVO::ScenarioRandom random(RVO_BENCHMARK_SEED);
+  std::vector<std::vector<RVO::Vector2> > obstacles;
+
+  for (std::size_t i = 0U; i < numObstacles; ++i) {
+    obstacles.push_back(makeSquare(
+        RVO::Vector2(random.uniform(-halfWidth, halfWidth),
+                     random.uniform(-halfWidth, halfWidth)),
+        RVO_BENCHMARK_OBSTACLE_SIZE));
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    RVO::RVOSimulator *simulator = new RVO::RVOSimulator();
+
+    for (std::size_t i = 0U; i < obstacles.size(); ++i) {
+      simulator->addObstacle(obstacles[i]);
+    }
+
+    state.ResumeTiming();
+    simulator->processObstacles();
+    state.PauseTiming();
+    delete simulator;
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<benchmark::IterationCount>(numObstacles));
+}
+
+/* Visibility queries between random points in a lattice of obstacles.
+ * Arguments: obstacle count and radius of the queries in hundredths. */
+void BM_QueryVisibility(benchmark::State &state) { /* NOLINT */
+  const std::size_t numQueries = 1024U;
+  const float radius = 0.01F * static_cast<float>(state.range(1));
+  RVO::ScenarioRandom random(RVO_BENCHMARK_SEED);
+  RVO::RVOSimulator simulator;
+  const float halfWidth = addObstacleLattice(
+      &simulator, static_cast<std::size_t>(state.range(0)));
+  std::vector<RVO::Vector2> points;
+
+  for (std::size_t i = 0U; i < 2U * numQueries; ++i) {
+    points.push_back(RVO::Vector2(random.uniform(-halfWidth, halfWidth),
+                                  random.uniform(-halfWidth, halfWidth)));
+  }
+
+  for (auto _ : state) {
+    std::size_t numVisible = 0U;
+
+    for (std::size_t i = 0U; i < numQueries; ++i) {
+      if (simulator.queryVisibility(points[2U * i], points[2U * i + 1U],
+                                    radius)) {
+        ++numVisible;
+      }
+    }
+
+    benchmark::DoNotOptimize(numVisible);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<benchmark::IterationCount>(numQueries));
+}
+
+/* End-to-end simulation steps of the generated scenarios. Arguments: scenario
+ * number, agent count, and obstacle count. */
+void BM_Scenario(benchmark::State &state) { /* NOLINT */
+  const std::size_t scenarioNo = static_cast<std::size_t>(state.range(0));
+  RVO::ScenarioParameters parameters;
+  parameters.numAgents = static_cast<std::size_t>(state.range(1));
+  parameters.numObstacles = static_cast<std::size_t>(state.range(2));
+  parameters.seed = RVO_BENCHMARK_SEED;
+  RVO::RVOSimulator simulator;
+  RVO::setupScenario(&simulator, RVO::getScenarioName(scenarioNo), parameters);
+  state.SetLabel(RVO::getScenarioName(scenarioNo));
+
+  for (auto _ : state) {
+    simulator.doStep();
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() *
+      static_cast<benchmark::IterationCount>(parameters.numAgents));
+}
+} /* namespace */
+
+BENCHMARK(BM_BuildAgentTree)
+    ->ArgName("agents")
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 1 << 20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_ComputeNewVelocity)
+    ->ArgNames({"agents", "density", "maxNeighbors"})
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 17, 1 << 20}, {5, 25, 100},
+                   {5, 10, 20}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_ComputeNewVelocityCongested)
+    ->ArgNames({"agents", "maxNeighbors"})
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 17, 1 << 20}, {5, 10, 20}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_ComputeObstacleNeighbors)
+    ->ArgNames({"agents", "obstacles"})
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 17}, {1 << 8, 1 << 12}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_ProcessObstacles)
+    ->ArgName("obstacles")
+    ->RangeMultiplier(8)
+    ->Range(1 << 6, 1 << 15)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_QueryVisibility)
+    ->ArgNames({"obstacles", "radius"})
+    ->ArgsProduct({{1 << 8, 1 << 12, 1 << 16}, {0, 50}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_Scenario)
+    ->ArgNames({"scenario", "agents", "obstacles"})
+    ->ArgsProduct({benchmark::CreateDenseRange(
+                       0, static_cast<int>(RVO::getNumScenarios()) - 1, 1),
+                   {1 << 12, 1 << 16}, {1 << 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,464 @@
+/*
+ * Scenario.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  Scenario.cc
+ * @brief Defines the scenario generator used by the benchmarks and the
+ *        throughput harness.
+ */
+
+#include "Scenario.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "RVOSimulator.h"
+#include "Vector2.h"
+
+namespace RVO {
+namespace {
+/**
+ * @brief The radius of an agent.
+ */
+const Real RVO_SCENARIO_AGENT_RADIUS = 0.5F;
+
+/**
+ * @brief The distance between neighboring agents in a block of agents.
+ */
+const Real RVO_SCENARIO_AGENT_SPACING = 2.0F;
+
+/**
+ * @brief The distance from the goal of an agent within which the goal is
+ *        reached.
+ */
+const Real RVO_SCENARIO_ARRIVAL_RADIUS = 0.5F;
+
+/**
+ * @brief The preferred speed of an agent toward its goal.
+ */
+const Real RVO_SCENARIO_GOAL_SPEED = 1.5F;
+
+/**
+ * @brief The maximum speed of an agent.
+ */
+const Real RVO_SCENARIO_MAX_SPEED = 2.0F;
+
+/**
+ * @brief The side length of a randomly placed square obstacle.
+ */
+const Real RVO_SCENARIO_OBSTACLE_SIZE = 2.0F;
+
+/**
+ * @brief The width of a street of the city scenario.
+ */
+const Real RVO_SCENARIO_STREET_WIDTH = 6.0F;
+
+/**
+ * @brief The constant two times pi.
+ */
+const Real RVO_TWO_PI = static_cast<Real>(6.28318530717958647692);
+
+/**
+ * @brief     Adds an axis-aligned rectangular obstacle.
+ * @param[in] simulator The simulator to which to add the obstacle.
+ * @param[in] minX      The minimum x-coordinate of the obstacle.
+ * @param[in] minY      The minimum y-coordinate of the obstacle.
+ * @param[in] maxX      The maximum x-coordinate of the obstacle.
+ * @param[in] maxY      The maximum y-coordinate of the obstacle.
+ */
+void addRectangle(RVOSimulator *simulator, Real minX, Real minY, Real maxX,
+                  Real maxY) {
+  std::vector<Vector2> vertices;
+  vertices.push_back(Vector2(minX, minY));
+  vertices.push_back(Vector2(maxX, minY));
+  vertices.push_back(Vector2(maxX, maxY));
+  vertices.push_back(Vector2(minX, maxY));
+  simulator->addObstacle(vertices);
+}
+
+/**
+ * @brief     Adds square obstacles at random positions in a square region.
+ * @param[in] simulator    The simulator to which to add the obstacles.
+ * @param[in] numObstacles The count of obstacles to add.
+ * @param[in] center       The center of the region.
+ * @param[in] halfWidth    The half-width of the region.
+ * @param[in] random       The random number generator.
+ */
+void addRandomObstacles(
+    RVOSimulator *simulator, std::size_t numObstacles, const Vector2 &center,
+    Real halfWidth,
+    ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const Real halfSize = 0.5F * RVO_SCENARIO_OBSTACLE_SIZE;
+
+  for (std::size_t i = 0U; i < numObstacles; ++i) {
+    const Vector2 position =
+        center + Vector2(random.uniform(-halfWidth, halfWidth),
+                         random.uniform(-halfWidth, halfWidth));
+    addRectangle(simulator, position.x() - halfSize, position.y() - halfSize,
+                 position.x() + halfSize, position.y() + halfSize);
+  }
+}
+
+/**
+ * @brief     Adds a square block of agents whose goals are offset from their
+ *            start positions.
+ * @param[in] simulator  The simulator to which to add the agents.
+ * @param[in] numAgents  The count of agents to add.
+ * @param[in] center     The center of the block.
+ * @param[in] goalOffset The offset of the goal of each agent from its start
+ *                       position.
+ * @param[in] random     The random number generator.
+ */
+void addAgentBlock(RVOSimulator *simulator, std::size_t numAgents,
+                   const Vector2 &center, const Vector2 &goalOffset,
+                   ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const std::size_t side = static_cast<std::size_t>(
+      std::ceil(std::sqrt(static_cast<Real>(numAgents))));
+  const Real offset =
+      -0.5F * RVO_SCENARIO_AGENT_SPACING * static_cast<Real>(side - 1U);
+  const Real jitter = 0.1F * RVO_SCENARIO_AGENT_SPACING;
+
+  for (std::size_t i = 0U; i < numAgents; ++i) {
+    const Vector2 position =
+        center +
+        Vector2(offset +
+                    RVO_SCENARIO_AGENT_SPACING * static_cast<Real>(i % side) +
+                    random.uniform(-jitter, jitter),
+                offset +
+                    RVO_SCENARIO_AGENT_SPACING * static_cast<Real>(i / side) +
+                    random.uniform(-jitter, jitter));
+    const std::size_t agentNo = simulator->addAgent(position);
+    simulator->setAgentGoal(agentNo, position + goalOffset,
+                            RVO_SCENARIO_GOAL_SPEED,
+                            RVO_SCENARIO_ARRIVAL_RADIUS);
+  }
+}
+
+/**
+ * @brief     Returns the half-width of a square block of agents.
+ * @param[in] numAgents The count of agents in the block.
+ * @return    The half-width of the block.
+ */
+Real getBlockHalfWidth(std::size_t numAgents) {
+  return 0.5F * RVO_SCENARIO_AGENT_SPACING *
+         std::ceil(std::sqrt(static_cast<Real>(numAgents)));
+}
+
+void setupBottleneck(RVOSimulator *simulator,
+                     const ScenarioParameters &parameters,
+                     ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const Real halfWidth = getBlockHalfWidth(parameters.numAgents);
+  const Real halfHeight = halfWidth + 10.0F;
+  const Real halfGap = std::max<Real>(2.0F, 0.1F * halfWidth);
+
+  addRectangle(simulator, -0.5F, halfGap, 0.5F, halfHeight);
+  addRectangle(simulator, -0.5F, -halfHeight, 0.5F, -halfGap);
+  addRandomObstacles(simulator, parameters.numObstacles,
+                     Vector2(-0.25F * halfWidth - 4.0F, 0.0F),
+                     0.25F * halfWidth + 2.0F, random);
+
+  const Vector2 center(-2.0F * halfWidth - 10.0F, 0.0F);
+  const Vector2 exit(halfWidth + 10.0F, 0.0F);
+  const std::size_t firstAgentNo = simulator->getNumAgents();
+  addAgentBlock(simulator, parameters.numAgents, center, Vector2(), random);
+
+  /* Funnel the agents toward a short line behind the gap. */
+  for (std::size_t i = firstAgentNo; i < simulator->getNumAgents(); ++i) {
+    simulator->setAgentGoal(
+        i, exit + Vector2(0.0F, 0.25F * simulator->getAgentPosition(i).y()),
+        RVO_SCENARIO_GOAL_SPEED, RVO_SCENARIO_ARRIVAL_RADIUS);
+  }
+}
+
+void setupCircle(RVOSimulator *simulator, const ScenarioParameters &parameters,
+                 ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const Real radius = std::max<Real>(
+      10.0F, static_cast<Real>(parameters.numAgents) *
+                 RVO_SCENARIO_AGENT_SPACING / RVO_TWO_PI);
+
+  addRandomObstacles(simulator, parameters.numObstacles, Vector2(),
+                     0.5F * radius, random);
+
+  for (std::size_t i = 0U; i < parameters.numAgents; ++i) {
+    const Real angle = static_cast<Real>(i) * RVO_TWO_PI /
+                       static_cast<Real>(parameters.numAgents);
+    const Vector2 position =
+        radius * Vector2(std::cos(angle), std::sin(angle)) +
+        Vector2(random.uniform(-0.01F, 0.01F), random.uniform(-0.01F, 0.01F));
+    const std::size_t agentNo = simulator->addAgent(position);
+    simulator->setAgentGoal(agentNo, -position, RVO_SCENARIO_GOAL_SPEED,
+                            RVO_SCENARIO_ARRIVAL_RADIUS);
+  }
+}
+
+void setupCity(RVOSimulator *simulator, const ScenarioParameters &parameters,
+               ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const std::size_t side = static_cast<std::size_t>(std::ceil(
+      std::sqrt(static_cast<Real>(std::max<std::size_t>(
+          parameters.numObstacles, 1U)))));
+
+  /* Make the streets long enough to hold the agents at half the density of a
+   * block of agents. */
+  const Real pitch = std::max(
+      RVO_SCENARIO_STREET_WIDTH + 20.0F,
+      2.0F * static_cast<Real>(parameters.numAgents) *
+          RVO_SCENARIO_AGENT_SPACING * RVO_SCENARIO_AGENT_SPACING /
+          (2.0F * RVO_SCENARIO_STREET_WIDTH * static_cast<Real>(side) *
+           static_cast<Real>(side + 1U)));
+  const Real halfWidth = 0.5F * pitch * static_cast<Real>(side) +
+                         0.5F * RVO_SCENARIO_STREET_WIDTH;
+  const Real blockSize = pitch - RVO_SCENARIO_STREET_WIDTH;
+
+  for (std::size_t i = 0U; i < parameters.numObstacles; ++i) {
+    const Real minX = -halfWidth + RVO_SCENARIO_STREET_WIDTH +
+                      pitch * static_cast<Real>(i % side);
+    const Real minY = -halfWidth + RVO_SCENARIO_STREET_WIDTH +
+                      pitch * static_cast<Real>(i / side);
+    addRectangle(simulator, minX, minY, minX + blockSize, minY + blockSize);
+  }
+
+  const Real halfStreet =
+      0.5F * RVO_SCENARIO_STREET_WIDTH - RVO_SCENARIO_AGENT_RADIUS;
+
+  for (std::size_t i = 0U; i < parameters.numAgents; ++i) {
+    /* Place the agent on a random street and head for a random
+     * intersection. */
+    const Real street =
+        -halfWidth + 0.5F * RVO_SCENARIO_STREET_WIDTH +
+        pitch * static_cast<Real>(random.index(side + 1U)) +
+        random.uniform(-halfStreet, halfStreet);
+    const Real along = random.uniform(-halfWidth, halfWidth);
+    const Vector2 position = random.index(2U) == 0U ? Vector2(along, street)
+                                                    : Vector2(street, along);
+    const Vector2 goal(
+        -halfWidth + 0.5F * RVO_SCENARIO_STREET_WIDTH +
+            pitch * static_cast<Real>(random.index(side + 1U)),
+        -halfWidth + 0.5F * RVO_SCENARIO_STREET_WIDTH +
+            pitch * static_cast<Real>(random.index(side + 1U)));
+    const std::size_t agentNo = simulator->addAgent(position);
+    simulator->setAgentGoal(agentNo, goal, RVO_SCENARIO_GOAL_SPEED,
+                            RVO_SCENARIO_ARRIVAL_RADIUS);
+  }
+}
+
+void setupCrossing(RVOSimulator *simulator,
+                   const ScenarioParameters &parameters,
+                   ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const std::size_t numAgents1 = parameters.numAgents / 2U;
+  const std::size_t numAgents2 = parameters.numAgents - numAgents1;
+  const Real halfWidth = getBlockHalfWidth(numAgents2);
+  const Real distance = 2.0F * halfWidth + 10.0F;
+
+  addRandomObstacles(simulator, parameters.numObstacles, Vector2(), halfWidth,
+                     random);
+  addAgentBlock(simulator, numAgents1, Vector2(-distance, 0.0F),
+                Vector2(2.0F * distance, 0.0F), random);
+  addAgentBlock(simulator, numAgents2, Vector2(0.0F, -distance),
+                Vector2(0.0F, 2.0F * distance), random);
+}
+
+/**
+ * @brief Defines the lattice of obstacles of the lattice scenario.
+ */
+struct Lattice {
+  /**
+   * @brief The half-width of the lattice.
+   */
+  Real halfWidth;
+
+  /**
+   * @brief The distance between neighboring obstacles.
+   */
+  Real pitch;
+
+  /**
+   * @brief The count of obstacles in a row of the lattice.
+   */
+  std::size_t side;
+
+  /**
+   * @brief The count of obstacles.
+   */
+  std::size_t numObstacles;
+};
+
+/**
+ * @brief     Returns a random point of the lattice scenario that does not lie
+ *            within the radius of an agent of an obstacle.
+ * @param[in] lattice The lattice of obstacles.
+ * @param[in] random  The random number generator.
+ * @return    The random point.
+ */
+Vector2 getLatticePoint(
+    const Lattice &lattice,
+    ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  const Real min = 0.25F * lattice.pitch - RVO_SCENARIO_AGENT_RADIUS;
+  const Real max = 0.75F * lattice.pitch + RVO_SCENARIO_AGENT_RADIUS;
+
+  while (true) {
+    const Vector2 point(random.uniform(-lattice.halfWidth, lattice.halfWidth),
+                        random.uniform(-lattice.halfWidth, lattice.halfWidth));
+    const std::size_t cellX = std::min(
+        static_cast<std::size_t>((point.x() + lattice.halfWidth) /
+                                 lattice.pitch),
+        lattice.side - 1U);
+    const std::size_t cellY = std::min(
+        static_cast<std::size_t>((point.y() + lattice.halfWidth) /
+                                 lattice.pitch),
+        lattice.side - 1U);
+    const Real x = point.x() + lattice.halfWidth -
+                   lattice.pitch * static_cast<Real>(cellX);
+    const Real y = point.y() + lattice.halfWidth -
+                   lattice.pitch * static_cast<Real>(cellY);
+
+    if (cellY * lattice.side + cellX >= lattice.numObstacles || x <= min ||
+        x >= max || y <= min || y >= max) {
+      return point;
+    }
+  }
+}
+
+void setupLattice(RVOSimulator *simulator,
+                  const ScenarioParameters &parameters,
+                  ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  Lattice lattice;
+  lattice.numObstacles = parameters.numObstacles;
+  lattice.side = static_cast<std::size_t>(std::ceil(std::sqrt(
+      static_cast<Real>(std::max<std::size_t>(parameters.numObstacles, 1U)))));
+
+  /* Leave three quarters of the area to the agents at half the density of a
+   * block of agents. */
+  lattice.halfWidth =
+      std::max(2.0F * static_cast<Real>(lattice.side),
+               1.6F * getBlockHalfWidth(parameters.numAgents));
+  lattice.pitch = 2.0F * lattice.halfWidth / static_cast<Real>(lattice.side);
+
+  for (std::size_t i = 0U; i < parameters.numObstacles; ++i) {
+    const Real minX = -lattice.halfWidth +
+                      lattice.pitch *
+                          (static_cast<Real>(i % lattice.side) + 0.25F);
+    const Real minY = -lattice.halfWidth +
+                      lattice.pitch *
+                          (static_cast<Real>(i / lattice.side) + 0.25F);
+    addRectangle(simulator, minX, minY, minX + 0.5F * lattice.pitch,
+                 minY + 0.5F * lattice.pitch);
+  }
+
+  for (std::size_t i = 0U; i < parameters.numAgents; ++i) {
+    const std::size_t agentNo =
+        simulator->addAgent(getLatticePoint(lattice, random));
+    simulator->setAgentGoal(agentNo, getLatticePoint(lattice, random),
+                            RVO_SCENARIO_GOAL_SPEED,
+                            RVO_SCENARIO_ARRIVAL_RADIUS);
+  }
+}
+
+void setupRandom(RVOSimulator *simulator, const ScenarioParameters &parameters,
+                 ScenarioRandom &random) { /* NOLINT(runtime/references) */
+  /* Spread the agents at half the density of a block of agents. */
+  const Real halfWidth = 1.4F * getBlockHalfWidth(parameters.numAgents);
+
+  addRandomObstacles(simulator, parameters.numObstacles, Vector2(), halfWidth,
+                     random);
+
+  for (std::size_t i = 0U; i < parameters.numAgents; ++i) {
+    const std::size_t agentNo = simulator->addAgent(
+        Vector2(random.uniform(-halfWidth, halfWidth),
+                random.uniform(-halfWidth, halfWidth)));
+    simulator->setAgentGoal(agentNo,
+                            Vector2(random.uniform(-halfWidth, halfWidth),
+                                    random.uniform(-halfWidth, halfWidth)),
+                            RVO_SCENARIO_GOAL_SPEED,
+                            RVO_SCENARIO_ARRIVAL_RADIUS);
+  }
+}
+
+/**
+ * @brief Defines a function that generates a scenario.
+ */
+typedef void (*ScenarioFunction)(RVOSimulator *simulator,
+                                 const ScenarioParameters &parameters,
+                                 ScenarioRandom &random);
+
+/**
+ * @brief Defines a named scenario.
+ */
+struct ScenarioEntry {
+  /**
+   * @brief The name of the scenario.
+   */
+  const char *name;
+
+  /**
+   * @brief The function that generates the scenario.
+   */
+  ScenarioFunction function;
+};
+
+/**
+ * @brief The scenarios that can be generated.
+ */
+const ScenarioEntry RVO_SCENARIOS[] = {
+    {"circle", &setupCircle},         {"crossing", &setupCrossing},
+    {"bottleneck", &setupBottleneck}, {"random", &setupRandom},
+    {"lattice", &setupLattice},       {"city", &setupCity}};
+} /* namespace */
+
+std::size_t getNumScenarios() {
+  return sizeof(RVO_SCENARIOS) / sizeof(RVO_SCENARIOS[0]);
+}
+
+const char *getScenarioName(std::size_t scenarioNo) {
+  return RVO_SCENARIOS[scenarioNo].name;
+}
+
+bool setupScenario(RVOSimulator *simulator, const std::string &name,
+                   const ScenarioParameters &parameters) {
+  for (std::size_t i = 0U; i < getNumScenarios(); ++i) {
+    if (name == RVO_SCENARIOS[i].name) {
+      ScenarioRandom random(parameters.seed);
+      simulator->setTimeStep(0.25F);
+      simulator->setAgentDefaults(5.0F, 10U, 5.0F, 5.0F,
+                                  RVO_SCENARIO_AGENT_RADIUS,
+                                  RVO_SCENARIO_MAX_SPEED);
+      RVO_SCENARIOS[i].function(simulator, parameters, random);
+      simulator->processObstacles();
+
+      return true;
+    }
+  }
+
+  return false;
+}
+} /* namespace RVO */
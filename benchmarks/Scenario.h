@@ -0,0 +1,162 @@
+/*
+ * Scenario.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_SCENARIO_H_
+#define RVO_SCENARIO_H_
+
+/**
+ * @file  Scenario.h
+ * @brief Declares the scenario generator used by the benchmarks and the
+ *        throughput harness.
+ */
+
+#include <cstddef>
+#include <string>
+
+#include "Real.h"
+
+namespace RVO {
+class RVOSimulator;
+
+/**
+ * @brief Defines a linear congruential random number generator, so that the
+ *        generated scenarios are the same on every platform and standard
+ *        library.
+ */
+class ScenarioRandom {
+ public:
+  /**
+   * @brief     Constructs a random number generator instance.
+   * @param[in] seed The seed of the random number generator.
+   */
+  explicit ScenarioRandom(unsigned long seed) : state_(seed & 0xFFFFFFFFUL) {}
+
+  /**
+   * @brief     Returns a random index uniformly distributed in a range.
+   * @param[in] count The count of indices in the range. Must be positive.
+   * @return    The random index, less than the count.
+   */
+  std::size_t index(std::size_t count) {
+    return static_cast<std::size_t>(uniform(0.0F, 1.0F) *
+                                    static_cast<Real>(count)) %
+           count;
+  }
+
+  /**
+   * @brief     Returns a random number uniformly distributed in a range.
+   * @param[in] min The lower bound of the range.
+   * @param[in] max The upper bound of the range.
+   * @return    The random number.
+   */
+  Real uniform(Real min, Real max) {
+    state_ = (state_ * 1664525UL + 1013904223UL) & 0xFFFFFFFFUL;
+
+    return min + (max - min) * static_cast<Real>(state_ >> 8U) /
+                     static_cast<Real>(0x1000000UL);
+  }
+
+ private:
+  unsigned long state_;
+};
+
+/**
+ * @brief Defines the parameters of a generated scenario.
+ */
+class ScenarioParameters {
+ public:
+  /**
+   * @brief Constructs a scenario parameters instance with 1000 agents, no
+   *        obstacles, and a seed of 42.
+   */
+  ScenarioParameters() : numAgents(1000U), numObstacles(0U), seed(42UL) {}
+
+  /**
+   * @brief The count of agents.
+   */
+  std::size_t numAgents;
+
+  /**
+   * @brief The count of obstacles, in addition to the walls of the bottleneck
+   *        scenario.
+   */
+  std::size_t numObstacles;
+
+  /**
+   * @brief The seed of the random number generator.
+   */
+  unsigned long seed;
+};
+
+/**
+ * @brief  Returns the count of scenarios that can be generated.
+ * @return The count of scenarios.
+ */
+std::size_t getNumScenarios();
+
+/**
+ * @brief     Returns the name of a specified scenario.
+ * @param[in] scenarioNo The number of the scenario. Must be less than
+ *                       getNumScenarios().
+ * @return    The name of the scenario.
+ */
+const char *getScenarioName(std::size_t scenarioNo);
+
+/**
+ * @brief     Generates a named scenario in a simulator. The agents are given
+ *            goals, so that each simulation step needs only a call to
+ *            RVOSimulator::doStep(), and the obstacles are processed. The
+ *            scenarios are:
+ *            - @c circle: the agents start evenly distributed on a circle and
+ *              head for the antipodal positions, around obstacles randomly
+ *              placed inside the circle.
+ *            - @c crossing: two perpendicular flows of agents cross each
+ *              other among randomly placed obstacles.
+ *            - @c bottleneck: a block of agents funnels through a gap in a
+ *              wall past randomly placed pillars.
+ *            - @c random: the agents head from random positions to random
+ *              goals among randomly placed obstacles.
+ *            - @c lattice: the agents head from random positions to random
+ *              goals through a square lattice of obstacles.
+ *            - @c city: the agents walk along the streets of a grid of city
+ *              blocks to random intersections.
+ * @param[in] simulator  The simulator, to which no agents or obstacles have
+ *                       been added.
+ * @param[in] name       The name of the scenario.
+ * @param[in] parameters The parameters of the scenario.
+ * @return    Whether the scenario exists.
+ */
+bool setupScenario(RVOSimulator *simulator, const std::string &name,
+                   const ScenarioParameters &parameters);
+} /* namespace RVO */
+
+#endif /* RVO_SCENARIO_H_ */
@@ -0,0 +1,234 @@
+/*
+ * Throughput.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/*
+ * @file  Throughput.cc
+ * @brief Command-line harness that generates scenarios at arbitrary counts of
+ *        agents and obstacles, and reports the end-to-end throughput of the
+ *        simulation in steps and agent steps per second for each count of
+ *        threads.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Executor.h"
+#include "RVOSimulator.h"
+#include "Scenario.h"
+
+namespace {
+void printUsage(const char *program) {
+  std::cerr
+      << "Usage: " << program << " [options]\n"
+      << "  --scenario NAME   scenario to run, or all (default: all)\n"
+      << "  --agents N        count of agents (default: 1000)\n"
+      << "  --obstacles N     count of obstacles (default: 0)\n"
+      << "  --seed N          seed of the random number generator "
+         "(default: 42)\n"
+      << "  --steps N         count of timed simulation steps (default: 100)\n"
+      << "  --warmup N        count of untimed simulation steps before "
+         "(default: 10)\n"
+      << "  --threads N[,N]   counts of threads (default: 1)\n"
+      << "  --orca-lines MODE scalar or vectorized ORCA lines (default: "
+         "scalar)\n"
+      << "  --list            list the scenarios and exit\n";
+}
+
+bool parseCount(const char *text, unsigned long *value) {
+  char *end = NULL;
+  *value = std::strtoul(text, &end, 10);
+
+  return end != text && *end == '\0';
+}
+
+bool parseThreads(const std::string &text, std::vector<std::size_t> *threads) {
+  std::size_t begin = 0U;
+
+  while (begin <= text.size()) {
+    std::size_t end = text.find(',', begin);
+
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+
+    unsigned long value = 0UL;
+
+    if (!parseCount(text.substr(begin, end - begin).c_str(), &value) ||
+        value == 0UL) {
+      return false;
+    }
+
+    threads->push_back(static_cast<std::size_t>(value));
+    begin = end + 1U;
+  }
+
+  return true;
+}
+
+void runScenario(const std::string &name,
+                 const RVO::ScenarioParameters &parameters,
+                 std::size_t numWarmupSteps, std::size_t numSteps,
+                 std::size_t numThreads, bool vectorizeORCALines) {
+  /* The executor outlives the simulator, which does not own it. */
+  RVO::DefaultExecutor executor(numThreads);
+  RVO::RVOSimulator *simulator = new RVO::RVOSimulator();
+  simulator->setExecutor(&executor);
+  RVO::setupScenario(simulator, name, parameters);
+  simulator->setVectorizeORCALines(vectorizeORCALines);
+
+  for (std::size_t i = 0U; i < numWarmupSteps; ++i) {
+    simulator->doStep();
+  }
+
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  for (std::size_t i = 0U; i < numSteps; ++i) {
+    simulator->doStep();
+  }
+
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  const double stepsPerSecond =
+      seconds > 0.0 ? static_cast<double>(numSteps) / seconds : 0.0;
+
+  std::cout << std::left << std::setw(12) << name << std::right
+            << std::setw(10) << simulator->getNumAgents() << std::setw(10)
+            << parameters.numObstacles << std::setw(8) << numThreads
+            << std::setw(8) << numSteps << std::fixed << std::setprecision(3)
+            << std::setw(12) << seconds << std::setprecision(1)
+            << std::setw(12) << stepsPerSecond << std::setprecision(0)
+            << std::setw(16)
+            << stepsPerSecond * static_cast<double>(simulator->getNumAgents())
+            << std::endl;
+
+  delete simulator;
+}
+} /* namespace */
+
+int main(int argc, char *argv[]) {
+  RVO::ScenarioParameters parameters;
+  std::string scenario = "all";
+  unsigned long numSteps = 100UL;
+  unsigned long numWarmupSteps = 10UL;
+  std::vector<std::size_t> threads;
+  bool vectorizeORCALines = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string option = argv[i];
+    unsigned long value = 0UL;
+
+    if (option == "--list") {
+      for (std::size_t j = 0U; j < RVO::getNumScenarios(); ++j) {
+        std::cout << RVO::getScenarioName(j) << std::endl;
+      }
+
+      return 0;
+    }
+
+    if (i + 1 == argc) {
+      printUsage(argv[0]);
+
+      return 1;
+    }
+
+    const char *argument = argv[++i];
+
+    if (option == "--scenario") {
+      scenario = argument;
+    } else if (option == "--agents" && parseCount(argument, &value)) {
+      parameters.numAgents = static_cast<std::size_t>(value);
+    } else if (option == "--obstacles" && parseCount(argument, &value)) {
+      parameters.numObstacles = static_cast<std::size_t>(value);
+    } else if (option == "--seed" && parseCount(argument, &value)) {
+      parameters.seed = value;
+    } else if (option == "--steps" && parseCount(argument, &value)) {
+      numSteps = value;
+    } else if (option == "--warmup" && parseCount(argument, &value)) {
+      numWarmupSteps = value;
+    } else if (option == "--orca-lines" &&
+               (std::strcmp(argument, "scalar") == 0 ||
+                std::strcmp(argument, "vectorized") == 0)) {
+      vectorizeORCALines = std::strcmp(argument, "vectorized") == 0;
+    } else if (option != "--threads" || !parseThreads(argument, &threads)) {
+      printUsage(argv[0]);
+
+      return 1;
+    }
+  }
+
+  if (threads.empty()) {
+    threads.push_back(1U);
+  }
+
+  std::vector<std::string> scenarios;
+
+  for (std::size_t j = 0U; j < RVO::getNumScenarios(); ++j) {
+    if (scenario == "all" || scenario == RVO::getScenarioName(j)) {
+      scenarios.push_back(RVO::getScenarioName(j));
+    }
+  }
+
+  if (scenarios.empty()) {
+    std::cerr << "Unknown scenario: " << scenario << std::endl;
+
+    return 1;
+  }
+
+  std::cout << "precision: "
+            << (sizeof(RVO::Real) == sizeof(double) ? "double" : "float")
+            << std::endl;
+  std::cout << std::left << std::setw(12) << "scenario" << std::right
+            << std::setw(10) << "agents" << std::setw(10) << "obstacles"
+            << std::setw(8) << "threads" << std::setw(8) << "steps"
+            << std::setw(12) << "seconds" << std::setw(12) << "steps/s"
+            << std::setw(16) << "agent-steps/s" << std::endl;
+
+  for (std::size_t j = 0U; j < scenarios.size(); ++j) {
+    for (std::size_t k = 0U; k < threads.size(); ++k) {
+      runScenario(scenarios[j], parameters,
+                  static_cast<std::size_t>(numWarmupSteps),
+                  static_cast<std::size_t>(numSteps), threads[k],
+                  vectorizeORCALines);
+    }
+  }
+
+  return 0;
+}
@@ -155,7 +155,7 @@ void updateVisualization(RVO::RVOSimulator *simulator) {
     std::cout << " " << simulator->getAgentPosition(i);
   }
 
-  std::cout << std::endl;
+  std::cout << '\n';
 }
 #endif /* RVO_OUTPUT_TIME_AND_POSITIONS */
 
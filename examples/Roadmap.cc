@@ -77,7 +77,7 @@ class RoadmapVertex {
  public:
   RVO::Vector2 position;
   std::vector<std::size_t> neighbors;
-  std::vector<float> distToGoal;
+  std::vector<RVO::Real> distToGoal;
 };
 
 void setupScenario(
@@ -209,7 +209,7 @@ void updateVisualization(RVO::RVOSimulator *simulator) {
     std::cout << " " << simulator->getAgentPosition(i);
   }
 
-  std::cout << std::endl;
+  std::cout << '\n';
 }
 #endif /* RVO_OUTPUT_TIME_AND_POSITIONS */
 
@@ -229,7 +229,8 @@ void buildRoadmap(
     }
 
     /* Initialize the distance to each of the four goal vertices at infinity. */
-    roadmap[i].distToGoal.resize(4U, std::numeric_limits<float>::infinity());
+    roadmap[i].distToGoal.resize(4U,
+                                 std::numeric_limits<RVO::Real>::infinity());
   }
 
   /* Compute the distance to each of the four goals (the first four vertices)
@@ -238,9 +239,9 @@ void buildRoadmap(
 #pragma omp parallel for
 #endif /* _OPENMP */
   for (std::size_t i = 0U; i < 4U; ++i) {
-    std::multimap<float, std::size_t> Q;
-    std::vector<std::multimap<float, std::size_t>::iterator> posInQ(roadmap.size(),
-                                                                    Q.end());
+    std::multimap<RVO::Real, std::size_t> Q;
+    std::vector<std::multimap<RVO::Real, std::size_t>::iterator> posInQ(
+        roadmap.size(), Q.end());
 
     roadmap[i].distToGoal[i] = 0.0F;
     posInQ[i] = Q.insert(std::make_pair(0.0F, i));
@@ -252,7 +253,7 @@ void buildRoadmap(
 
       for (std::size_t j = 0U; j < roadmap[u].neighbors.size(); ++j) {
         const std::size_t v = roadmap[u].neighbors[j];
-        const float distUV =
+        const RVO::Real distUV =
             RVO::abs(roadmap[v].position - roadmap[u].position);
 
         if (roadmap[v].distToGoal[i] > roadmap[u].distToGoal[i] + distUV) {
@@ -280,7 +281,7 @@ void setPreferredVelocities(RVO::RVOSimulator *simulator,
 #pragma omp parallel for
 #endif /* _OPENMP */
   for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
-    float minDist = std::numeric_limits<float>::infinity();
+    RVO::Real minDist = std::numeric_limits<RVO::Real>::infinity();
     std::size_t minVertex = std::numeric_limits<std::size_t>::max();
 
     for (std::size_t j = 0U; j < roadmap.size(); ++j) {
@@ -41,12 +41,539 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <utility>
 
+#include "AgentStore.h"
 #include "KdTree.h"
 #include "Obstacle.h"
+#include "Vector2.h"
+
+#if RVO_ENABLE_STATISTICS
+#include "Clock.h"
+#include "StepStatistics.h"
+#endif /* RVO_ENABLE_STATISTICS */
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define RVO_SIMD_AVX512 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define RVO_SIMD_AVX 1
+#elif RVO_USE_DOUBLE
+/* Double-precision vectors require SSE2, or NEON on AArch64. */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RVO_SIMD_SSE 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RVO_SIMD_NEON 1
+#endif /* __SSE2__ */
+#elif defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RVO_SIMD_SSE 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+/* Divisions and square roots of NEON vectors require AArch64. */
+#include <arm_neon.h>
+#define RVO_SIMD_NEON 1
+#endif /* __AVX512F__ */
 
 namespace RVO {
 namespace {
+/**
+ * @relates Agent
+ * @brief   The maximum count of neighbors that are kept sorted by insertion
+ *          while they are collected. Larger sets of neighbors are collected in
+ *          a heap, or unsorted, and sorted once collected.
+ */
+const std::size_t RVO_MAX_INSERTION_SORT_NEIGHBORS = 16U;
+
+/**
+ * @relates Agent
+ * @brief   The constant two times pi.
+ */
+const Real RVO_TWO_PI = static_cast<Real>(6.283185307179586);
+
+/**
+ * @relates   Agent
+ * @brief     Hashes the specified number to 32 pseudorandom bits.
+ * @param[in] value The number to be hashed.
+ * @return    The 32 pseudorandom bits.
+ */
+inline unsigned long hashBits(unsigned long value) {
+  value = ((value ^ (value >> 16U)) * 0x7FEB352DUL) & 0xFFFFFFFFUL;
+  value = ((value ^ (value >> 15U)) * 0x846CA68BUL) & 0xFFFFFFFFUL;
+
+  return value ^ (value >> 16U);
+}
+
+/**
+ * @relates   Agent
+ * @brief     Computes the unit vector at a specified angle.
+ * @param[in] angle The angle in radians, between zero and two times pi.
+ * @return    The unit vector at the angle.
+ */
+inline Vector2 unitVector(Real angle) {
+#if RVO_DETERMINISTIC
+  /* The sine and cosine of the C library may differ in the last bit between
+   * hosts, so they are evaluated instead by polynomials in double precision,
+   * which give the same result on any host with IEEE 754 arithmetic. The
+   * angle is reduced to [-pi / 4, pi / 4] about a multiple of pi / 2. */
+  const double halfPi = 1.5707963267948966;
+  const int quadrant =
+      static_cast<int>(static_cast<double>(angle) / halfPi + 0.5);
+  const double x = static_cast<double>(angle) - quadrant * halfPi;
+  const double xSq = x * x;
+
+  const double sine =
+      x + x * xSq *
+              (-1.0 / 6.0 +
+               xSq * (1.0 / 120.0 +
+                      xSq * (-1.0 / 5040.0 +
+                             xSq * (1.0 / 362880.0 +
+                                    xSq * (-1.0 / 39916800.0)))));
+  const double cosine =
+      1.0 +
+      xSq * (-1.0 / 2.0 +
+             xSq * (1.0 / 24.0 +
+                    xSq * (-1.0 / 720.0 +
+                           xSq * (1.0 / 40320.0 +
+                                  xSq * (-1.0 / 3628800.0 +
+                                         xSq * (1.0 / 479001600.0))))));
+  const Real s = static_cast<Real>(sine);
+  const Real c = static_cast<Real>(cosine);
+
+  switch (quadrant & 3) {
+    case 1:
+      return Vector2(-s, c);
+    case 2:
+      return Vector2(-c, -s);
+    case 3:
+      return Vector2(s, -c);
+    default:
+      return Vector2(c, s);
+  }
+#else
+  return Vector2(std::cos(angle), std::sin(angle));
+#endif /* RVO_DETERMINISTIC */
+}
+
+#if defined(RVO_SIMD_AVX512) || defined(RVO_SIMD_AVX) || \
+    defined(RVO_SIMD_SSE) || defined(RVO_SIMD_NEON)
+/**
+ * @relates Agent
+ * @brief   The count of agent neighbors whose ORCA lines are computed at once
+ *          when the agent ORCA lines are vectorized.
+ */
+#if defined(RVO_SIMD_AVX512)
+const std::size_t RVO_ORCA_BATCH_WIDTH = 64U / sizeof(Real);
+#elif defined(RVO_SIMD_AVX)
+const std::size_t RVO_ORCA_BATCH_WIDTH = 32U / sizeof(Real);
+#else
+const std::size_t RVO_ORCA_BATCH_WIDTH = 16U / sizeof(Real);
+#endif /* RVO_SIMD_AVX512 */
+#else
+const std::size_t RVO_ORCA_BATCH_WIDTH = 1U;
+#endif /* RVO_SIMD_AVX512 || RVO_SIMD_AVX || RVO_SIMD_SSE || RVO_SIMD_NEON */
+
+/* The lanes of a batch of reals and of the masks that select between them,
+ * with the few operations that the batched ORCA lines need. A mask selects
+ * the second of two batches in its set lanes. */
+#if defined(RVO_SIMD_AVX512) && RVO_USE_DOUBLE
+/* The unmasked maximum and square root of AVX-512 draw a spurious warning of
+ * an uninitialized value from GCC 12, so their masked forms set all lanes. */
+typedef __m512d RealBatch;
+typedef __mmask8 MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) {
+  return _mm512_add_pd(a, b);
+}
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) {
+  return static_cast<MaskBatch>(a & b);
+}
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return static_cast<MaskBatch>(a & ~b);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) {
+  return _mm512_div_pd(a, b);
+}
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ);
+}
+inline RealBatch batchLoad(const Real *values) {
+  return _mm512_loadu_pd(values);
+}
+inline RealBatch batchMax(RealBatch a, RealBatch b) {
+  return _mm512_mask_max_pd(a, 0xFF, a, b);
+}
+inline RealBatch batchMul(RealBatch a, RealBatch b) {
+  return _mm512_mul_pd(a, b);
+}
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  return _mm512_mask_blend_pd(mask, a, b);
+}
+inline RealBatch batchSet(Real value) { return _mm512_set1_pd(value); }
+inline RealBatch batchSqrt(RealBatch a) {
+  return _mm512_mask_sqrt_pd(a, 0xFF, a);
+}
+inline void batchStore(Real *values, RealBatch a) {
+  _mm512_storeu_pd(values, a);
+}
+inline RealBatch batchSub(RealBatch a, RealBatch b) {
+  return _mm512_sub_pd(a, b);
+}
+#elif defined(RVO_SIMD_AVX512)
+typedef __m512 RealBatch;
+typedef __mmask16 MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) {
+  return _mm512_add_ps(a, b);
+}
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) {
+  return static_cast<MaskBatch>(a & b);
+}
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return static_cast<MaskBatch>(a & ~b);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) {
+  return _mm512_div_ps(a, b);
+}
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+}
+inline RealBatch batchLoad(const Real *values) {
+  return _mm512_loadu_ps(values);
+}
+inline RealBatch batchMax(RealBatch a, RealBatch b) {
+  return _mm512_mask_max_ps(a, 0xFFFF, a, b);
+}
+inline RealBatch batchMul(RealBatch a, RealBatch b) {
+  return _mm512_mul_ps(a, b);
+}
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  return _mm512_mask_blend_ps(mask, a, b);
+}
+inline RealBatch batchSet(Real value) { return _mm512_set1_ps(value); }
+inline RealBatch batchSqrt(RealBatch a) {
+  return _mm512_mask_sqrt_ps(a, 0xFFFF, a);
+}
+inline void batchStore(Real *values, RealBatch a) {
+  _mm512_storeu_ps(values, a);
+}
+inline RealBatch batchSub(RealBatch a, RealBatch b) {
+  return _mm512_sub_ps(a, b);
+}
+#elif defined(RVO_SIMD_AVX) && RVO_USE_DOUBLE
+typedef __m256d RealBatch;
+typedef __m256d MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) {
+  return _mm256_add_pd(a, b);
+}
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) {
+  return _mm256_and_pd(a, b);
+}
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return _mm256_andnot_pd(b, a);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) {
+  return _mm256_div_pd(a, b);
+}
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+}
+inline RealBatch batchLoad(const Real *values) {
+  return _mm256_loadu_pd(values);
+}
+inline RealBatch batchMax(RealBatch a, RealBatch b) {
+  return _mm256_max_pd(a, b);
+}
+inline RealBatch batchMul(RealBatch a, RealBatch b) {
+  return _mm256_mul_pd(a, b);
+}
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  return _mm256_blendv_pd(a, b, mask);
+}
+inline RealBatch batchSet(Real value) { return _mm256_set1_pd(value); }
+inline RealBatch batchSqrt(RealBatch a) { return _mm256_sqrt_pd(a); }
+inline void batchStore(Real *values, RealBatch a) {
+  _mm256_storeu_pd(values, a);
+}
+inline RealBatch batchSub(RealBatch a, RealBatch b) {
+  return _mm256_sub_pd(a, b);
+}
+#elif defined(RVO_SIMD_AVX)
+typedef __m256 RealBatch;
+typedef __m256 MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) {
+  return _mm256_add_ps(a, b);
+}
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) {
+  return _mm256_and_ps(a, b);
+}
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return _mm256_andnot_ps(b, a);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) {
+  return _mm256_div_ps(a, b);
+}
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+}
+inline RealBatch batchLoad(const Real *values) {
+  return _mm256_loadu_ps(values);
+}
+inline RealBatch batchMax(RealBatch a, RealBatch b) {
+  return _mm256_max_ps(a, b);
+}
+inline RealBatch batchMul(RealBatch a, RealBatch b) {
+  return _mm256_mul_ps(a, b);
+}
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  return _mm256_blendv_ps(a, b, mask);
+}
+inline RealBatch batchSet(Real value) { return _mm256_set1_ps(value); }
+inline RealBatch batchSqrt(RealBatch a) { return _mm256_sqrt_ps(a); }
+inline void batchStore(Real *values, RealBatch a) {
+  _mm256_storeu_ps(values, a);
+}
+inline RealBatch batchSub(RealBatch a, RealBatch b) {
+  return _mm256_sub_ps(a, b);
+}
+#elif defined(RVO_SIMD_SSE) && RVO_USE_DOUBLE
+typedef __m128d RealBatch;
+typedef __m128d MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) { return _mm_add_pd(a, b); }
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) { return _mm_and_pd(a, b); }
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return _mm_andnot_pd(b, a);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) { return _mm_div_pd(a, b); }
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return _mm_cmpgt_pd(a, b);
+}
+inline RealBatch batchLoad(const Real *values) { return _mm_loadu_pd(values); }
+inline RealBatch batchMax(RealBatch a, RealBatch b) { return _mm_max_pd(a, b); }
+inline RealBatch batchMul(RealBatch a, RealBatch b) { return _mm_mul_pd(a, b); }
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  /* Blends require SSE4.1. */
+  return _mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a));
+}
+inline RealBatch batchSet(Real value) { return _mm_set1_pd(value); }
+inline RealBatch batchSqrt(RealBatch a) { return _mm_sqrt_pd(a); }
+inline void batchStore(Real *values, RealBatch a) { _mm_storeu_pd(values, a); }
+inline RealBatch batchSub(RealBatch a, RealBatch b) { return _mm_sub_pd(a, b); }
+#elif defined(RVO_SIMD_SSE)
+typedef __m128 RealBatch;
+typedef __m128 MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) { return _mm_add_ps(a, b); }
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) { return _mm_and_ps(a, b); }
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return _mm_andnot_ps(b, a);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) { return _mm_div_ps(a, b); }
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return _mm_cmpgt_ps(a, b);
+}
+inline RealBatch batchLoad(const Real *values) { return _mm_loadu_ps(values); }
+inline RealBatch batchMax(RealBatch a, RealBatch b) { return _mm_max_ps(a, b); }
+inline RealBatch batchMul(RealBatch a, RealBatch b) { return _mm_mul_ps(a, b); }
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  /* Blends require SSE4.1. */
+  return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+inline RealBatch batchSet(Real value) { return _mm_set1_ps(value); }
+inline RealBatch batchSqrt(RealBatch a) { return _mm_sqrt_ps(a); }
+inline void batchStore(Real *values, RealBatch a) { _mm_storeu_ps(values, a); }
+inline RealBatch batchSub(RealBatch a, RealBatch b) { return _mm_sub_ps(a, b); }
+#elif defined(RVO_SIMD_NEON) && RVO_USE_DOUBLE
+typedef float64x2_t RealBatch;
+typedef uint64x2_t MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) { return vaddq_f64(a, b); }
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) { return vandq_u64(a, b); }
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return vbicq_u64(a, b);
+}
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  return vbslq_f64(mask, b, a);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) { return vdivq_f64(a, b); }
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return vcgtq_f64(a, b);
+}
+inline RealBatch batchLoad(const Real *values) { return vld1q_f64(values); }
+inline RealBatch batchMax(RealBatch a, RealBatch b) { return vmaxq_f64(a, b); }
+inline RealBatch batchMul(RealBatch a, RealBatch b) { return vmulq_f64(a, b); }
+inline RealBatch batchSet(Real value) { return vdupq_n_f64(value); }
+inline RealBatch batchSqrt(RealBatch a) { return vsqrtq_f64(a); }
+inline void batchStore(Real *values, RealBatch a) { vst1q_f64(values, a); }
+inline RealBatch batchSub(RealBatch a, RealBatch b) { return vsubq_f64(a, b); }
+#elif defined(RVO_SIMD_NEON)
+typedef float32x4_t RealBatch;
+typedef uint32x4_t MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) { return vaddq_f32(a, b); }
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) { return vandq_u32(a, b); }
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) {
+  return vbicq_u32(a, b);
+}
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  return vbslq_f32(mask, b, a);
+}
+inline RealBatch batchDiv(RealBatch a, RealBatch b) { return vdivq_f32(a, b); }
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) {
+  return vcgtq_f32(a, b);
+}
+inline RealBatch batchLoad(const Real *values) { return vld1q_f32(values); }
+inline RealBatch batchMax(RealBatch a, RealBatch b) { return vmaxq_f32(a, b); }
+inline RealBatch batchMul(RealBatch a, RealBatch b) { return vmulq_f32(a, b); }
+inline RealBatch batchSet(Real value) { return vdupq_n_f32(value); }
+inline RealBatch batchSqrt(RealBatch a) { return vsqrtq_f32(a); }
+inline void batchStore(Real *values, RealBatch a) { vst1q_f32(values, a); }
+inline RealBatch batchSub(RealBatch a, RealBatch b) { return vsubq_f32(a, b); }
+#else
+typedef Real RealBatch;
+typedef bool MaskBatch;
+
+inline RealBatch batchAdd(RealBatch a, RealBatch b) { return a + b; }
+inline MaskBatch batchAnd(MaskBatch a, MaskBatch b) { return a && b; }
+inline MaskBatch batchAndNot(MaskBatch a, MaskBatch b) { return a && !b; }
+inline RealBatch batchDiv(RealBatch a, RealBatch b) { return a / b; }
+inline MaskBatch batchGreater(RealBatch a, RealBatch b) { return a > b; }
+inline RealBatch batchLoad(const Real *values) { return values[0U]; }
+inline RealBatch batchMax(RealBatch a, RealBatch b) { return std::max(a, b); }
+inline RealBatch batchMul(RealBatch a, RealBatch b) { return a * b; }
+inline RealBatch batchSelect(MaskBatch mask, RealBatch a, RealBatch b) {
+  return mask ? b : a;
+}
+inline RealBatch batchSet(Real value) { return value; }
+inline RealBatch batchSqrt(RealBatch a) { return std::sqrt(a); }
+inline void batchStore(Real *values, RealBatch a) { values[0U] = a; }
+inline RealBatch batchSub(RealBatch a, RealBatch b) { return a - b; }
+#endif /* RVO_SIMD_AVX512 */
+
+/**
+ * @relates    Agent
+ * @brief      Computes the ORCA lines induced on an agent by
+ *             RVO_ORCA_BATCH_WIDTH of its agent neighbors. The cut-off circle,
+ *             the legs, and the collision are computed for every neighbor, and
+ *             the results of the case that holds for each are selected by
+ *             masks. The arithmetic is that of the scalar construction in
+ *             Agent::computeNewVelocity(), in the same order.
+ * @param[in]  relativePositionsX  The x-coordinates of the positions of the
+ *                                 neighbors relative to the agent.
+ * @param[in]  relativePositionsY  The y-coordinates of the positions of the
+ *                                 neighbors relative to the agent.
+ * @param[in]  relativeVelocitiesX The x-coordinates of the velocity of the
+ *                                 agent relative to the neighbors.
+ * @param[in]  relativeVelocitiesY The y-coordinates of the velocity of the
+ *                                 agent relative to the neighbors.
+ * @param[in]  combinedRadii       The sums of the radii of the agent and of
+ *                                 the neighbors.
+ * @param[in]  invTimeHorizon      The inverse of the time horizon of the
+ *                                 agent.
+ * @param[in]  invTimeStep         The inverse of the time step.
+ * @param[out] directionsX         The x-coordinates of the directions of the
+ *                                 ORCA lines.
+ * @param[out] directionsY         The y-coordinates of the directions of the
+ *                                 ORCA lines.
+ * @param[out] uX                  The x-coordinates of the smallest changes
+ *                                 of the relative velocity that avoid the
+ *                                 neighbors.
+ * @param[out] uY                  The y-coordinates of the smallest changes
+ *                                 of the relative velocity that avoid the
+ *                                 neighbors.
+ */
+inline void computeORCALineBatch(
+    const Real *relativePositionsX, const Real *relativePositionsY,
+    const Real *relativeVelocitiesX, const Real *relativeVelocitiesY,
+    const Real *combinedRadii, Real invTimeHorizon, Real invTimeStep,
+    Real *directionsX, Real *directionsY, Real *uX, Real *uY) {
+  const RealBatch zero = batchSet(0.0F);
+  const RealBatch relativePositionX = batchLoad(relativePositionsX);
+  const RealBatch relativePositionY = batchLoad(relativePositionsY);
+  const RealBatch relativeVelocityX = batchLoad(relativeVelocitiesX);
+  const RealBatch relativeVelocityY = batchLoad(relativeVelocitiesY);
+  const RealBatch combinedRadius = batchLoad(combinedRadii);
+
+  const RealBatch distSq =
+      batchAdd(batchMul(relativePositionX, relativePositionX),
+               batchMul(relativePositionY, relativePositionY));
+  const RealBatch combinedRadiusSq = batchMul(combinedRadius, combinedRadius);
+  const MaskBatch noCollision = batchGreater(distSq, combinedRadiusSq);
+
+  /* The cut-off circle is that of the time horizon if there is no collision,
+   * and that of time timeStep otherwise. */
+  const RealBatch invTime =
+      batchSelect(noCollision, batchSet(invTimeStep), batchSet(invTimeHorizon));
+
+  /* Vector from cutoff center to relative velocity. */
+  const RealBatch wX =
+      batchSub(relativeVelocityX, batchMul(invTime, relativePositionX));
+  const RealBatch wY =
+      batchSub(relativeVelocityY, batchMul(invTime, relativePositionY));
+  const RealBatch wLengthSq = batchAdd(batchMul(wX, wX), batchMul(wY, wY));
+  const RealBatch dotProduct = batchAdd(batchMul(wX, relativePositionX),
+                                        batchMul(wY, relativePositionY));
+
+  /* Project on legs if there is no collision and the relative velocity is
+   * not closest to the cut-off circle. */
+  const MaskBatch onCutoff =
+      batchAnd(batchGreater(zero, dotProduct),
+               batchGreater(batchMul(dotProduct, dotProduct),
+                            batchMul(combinedRadiusSq, wLengthSq)));
+  const MaskBatch onLegs = batchAndNot(noCollision, onCutoff);
+
+  /* Project on cut-off circle. */
+  const RealBatch minusOne = batchSet(-1.0F);
+  const RealBatch wLength = batchSqrt(wLengthSq);
+  const RealBatch invWLength = batchDiv(batchSet(1.0F), wLength);
+  const RealBatch unitWX = batchMul(wX, invWLength);
+  const RealBatch unitWY = batchMul(wY, invWLength);
+  const RealBatch cutoffScale =
+      batchSub(batchMul(combinedRadius, invTime), wLength);
+
+  /* Project on left leg or right leg. The difference under the root is only
+   * negative for a collision, whose leg is discarded. */
+  const RealBatch leg =
+      batchSqrt(batchMax(batchSub(distSq, combinedRadiusSq), zero));
+  const RealBatch invDistSq = batchDiv(batchSet(1.0F), distSq);
+  const MaskBatch onLeftLeg =
+      batchGreater(batchSub(batchMul(relativePositionX, wY),
+                            batchMul(relativePositionY, wX)),
+                   zero);
+  const RealBatch legX = batchMul(relativePositionX, leg);
+  const RealBatch legY = batchMul(relativePositionY, leg);
+  const RealBatch radiusX = batchMul(relativePositionX, combinedRadius);
+  const RealBatch radiusY = batchMul(relativePositionY, combinedRadius);
+  const RealBatch legDirectionX = batchSelect(
+      onLeftLeg,
+      batchMul(batchMul(minusOne, batchAdd(legX, radiusY)), invDistSq),
+      batchMul(batchSub(legX, radiusY), invDistSq));
+  const RealBatch legDirectionY = batchSelect(
+      onLeftLeg,
+      batchMul(batchMul(minusOne, batchSub(legY, radiusX)), invDistSq),
+      batchMul(batchAdd(radiusX, legY), invDistSq));
+  const RealBatch legDotProduct =
+      batchAdd(batchMul(relativeVelocityX, legDirectionX),
+               batchMul(relativeVelocityY, legDirectionY));
+
+  batchStore(directionsX, batchSelect(onLegs, unitWY, legDirectionX));
+  batchStore(directionsY,
+             batchSelect(onLegs, batchMul(minusOne, unitWX), legDirectionY));
+  batchStore(uX, batchSelect(onLegs, batchMul(cutoffScale, unitWX),
+                             batchSub(batchMul(legDotProduct, legDirectionX),
+                                      relativeVelocityX)));
+  batchStore(uY, batchSelect(onLegs, batchMul(cutoffScale, unitWY),
+                             batchSub(batchMul(legDotProduct, legDirectionY),
+                                      relativeVelocityY)));
+}
+
 /**
  * @relates        Agent
  * @brief          Solves a one-dimensional linear program on a specified line
@@ -61,10 +588,10 @@ namespace {
  * @return         True if successful.
  */
 bool linearProgram1(const std::vector<Line> &lines, std::size_t lineNo,
-                    float radius, const Vector2 &optVelocity, bool directionOpt,
+                    Real radius, const Vector2 &optVelocity, bool directionOpt,
                     Vector2 &result) { /* NOLINT(runtime/references) */
-  const float dotProduct = lines[lineNo].point * lines[lineNo].direction;
-  const float discriminant =
+  const Real dotProduct = lines[lineNo].point * lines[lineNo].direction;
+  const Real discriminant =
       dotProduct * dotProduct + radius * radius - absSq(lines[lineNo].point);
 
   if (discriminant < 0.0F) {
@@ -72,13 +599,13 @@ bool linearProgram1(const std::vector<Line> &lines, std::size_t lineNo,
     return false;
   }
 
-  const float sqrtDiscriminant = std::sqrt(discriminant);
-  float tLeft = -dotProduct - sqrtDiscriminant;
-  float tRight = -dotProduct + sqrtDiscriminant;
+  const Real sqrtDiscriminant = std::sqrt(discriminant);
+  Real tLeft = -dotProduct - sqrtDiscriminant;
+  Real tRight = -dotProduct + sqrtDiscriminant;
 
   for (std::size_t i = 0U; i < lineNo; ++i) {
-    const float denominator = det(lines[lineNo].direction, lines[i].direction);
-    const float numerator =
+    const Real denominator = det(lines[lineNo].direction, lines[i].direction);
+    const Real numerator =
         det(lines[i].direction, lines[lineNo].point - lines[i].point);
 
     if (std::fabs(denominator) <= RVO_EPSILON) {
@@ -90,7 +617,7 @@ bool linearProgram1(const std::vector<Line> &lines, std::size_t lineNo,
       continue;
     }
 
-    const float t = numerator / denominator;
+    const Real t = numerator / denominator;
 
     if (denominator >= 0.0F) {
       /* Line i bounds line lineNo on the right. */
@@ -116,7 +643,7 @@ bool linearProgram1(const std::vector<Line> &lines, std::size_t lineNo,
     }
   } else {
     /* Optimize closest point. */
-    const float t =
+    const Real t =
         lines[lineNo].direction * (optVelocity - lines[lineNo].point);
 
     if (t < tLeft) {
@@ -143,7 +670,7 @@ bool linearProgram1(const std::vector<Line> &lines, std::size_t lineNo,
  * @return         The number of the line it fails on, and the number of lines
  *                 if successful.
  */
-std::size_t linearProgram2(const std::vector<Line> &lines, float radius,
+std::size_t linearProgram2(const std::vector<Line> &lines, Real radius,
                            const Vector2 &optVelocity, bool directionOpt,
                            Vector2 &result) { /* NOLINT(runtime/references) */
   if (directionOpt) {
@@ -184,24 +711,34 @@ std::size_t linearProgram2(const std::vector<Line> &lines, float radius,
  * @param[in]      numObstLines Count of obstacle lines.
  * @param[in]      beginLine    The line on which the 2-d linear program failed.
  * @param[in]      radius       The radius of the circular constraint.
+ * @param[in, out] projLines    Scratch space for the projected lines. Its
+ *                              capacity is reused across calls.
  * @param[in, out] result       A reference to the result of the linear program.
  */
-void linearProgram3(const std::vector<Line> &lines, std::size_t numObstLines,
-                    std::size_t beginLine, float radius,
-                    Vector2 &result) { /* NOLINT(runtime/references) */
-  float distance = 0.0F;
+void linearProgram3(
+    const std::vector<Line> &lines, std::size_t numObstLines,
+    std::size_t beginLine, Real radius,
+    std::vector<Line> &projLines, /* NOLINT(runtime/references) */
+    Vector2 &result) {            /* NOLINT(runtime/references) */
+  Real distance = 0.0F;
+
+  /* The projected lines never outnumber the lines, so reserving them once
+   * avoids allocating while solving. Reserving the capacity of the lines
+   * rather than their count grows the scratch space geometrically with them,
+   * not at every new largest count. */
+  projLines.reserve(lines.capacity());
 
   for (std::size_t i = beginLine; i < lines.size(); ++i) {
     if (det(lines[i].direction, lines[i].point - result) > distance) {
       /* Result does not satisfy constraint of line i. */
-      std::vector<Line> projLines(
+      projLines.assign(
           lines.begin(),
           lines.begin() + static_cast<std::ptrdiff_t>(numObstLines));
 
       for (std::size_t j = numObstLines; j < i; ++j) {
         Line line;
 
-        const float determinant = det(lines[i].direction, lines[j].direction);
+        const Real determinant = det(lines[i].direction, lines[j].direction);
 
         if (std::fabs(determinant) <= RVO_EPSILON) {
           /* Line i and line j are parallel. */
@@ -242,43 +779,112 @@ void linearProgram3(const std::vector<Line> &lines, std::size_t numObstLines,
 }
 } /* namespace */
 
-Agent::Agent()
-    : id_(0U),
-      maxNeighbors_(0U),
-      maxSpeed_(0.0F),
-      neighborDist_(0.0F),
-      radius_(0.0F),
-      timeHorizon_(0.0F),
-      timeHorizonObst_(0.0F) {}
+Agent::Agent(AgentStore *store, std::size_t id)
+    : store_(store),
+      id_(id),
+      numAgentNeighborInsertions_(0U),
+      statistics_(NULL) {}
 
 Agent::~Agent() {}
 
 void Agent::computeNeighbors(const KdTree *kdTree) {
+#if RVO_ENABLE_STATISTICS
+  double time = getClockTime();
+#endif /* RVO_ENABLE_STATISTICS */
+
   obstacleNeighbors_.clear();
-  const float range = timeHorizonObst_ * maxSpeed_ + radius_;
+  const Real range = store_->timeHorizonObsts_[id_] * store_->maxSpeeds_[id_] +
+                      store_->radii_[id_];
   kdTree->computeObstacleNeighbors(this, range * range);
 
+  /* Obstacle neighbors are collected unsorted and sorted stably, which keeps
+   * equidistant neighbors in the order they were found. */
+  if (obstacleNeighbors_.size() > RVO_MAX_INSERTION_SORT_NEIGHBORS) {
+    /* Sort by distance and then by the order found, in reusable scratch
+     * space rather than the temporary buffer of a stable sort. */
+    obstacleNeighborBuffer_.clear();
+
+    for (std::size_t i = 0U; i < obstacleNeighbors_.size(); ++i) {
+      obstacleNeighborBuffer_.push_back(
+          std::make_pair(std::make_pair(obstacleNeighbors_[i].first, i),
+                         obstacleNeighbors_[i].second));
+    }
+
+    std::sort(obstacleNeighborBuffer_.begin(), obstacleNeighborBuffer_.end());
+
+    for (std::size_t i = 0U; i < obstacleNeighbors_.size(); ++i) {
+      obstacleNeighbors_[i] = std::make_pair(
+          obstacleNeighborBuffer_[i].first.first,
+          obstacleNeighborBuffer_[i].second);
+    }
+  } else {
+    for (std::size_t i = 1U; i < obstacleNeighbors_.size(); ++i) {
+      const std::pair<Real, const Obstacle *> neighbor = obstacleNeighbors_[i];
+      std::size_t j = i;
+
+      while (j != 0U && neighbor.first < obstacleNeighbors_[j - 1U].first) {
+        obstacleNeighbors_[j] = obstacleNeighbors_[j - 1U];
+        --j;
+      }
+
+      obstacleNeighbors_[j] = neighbor;
+    }
+  }
+
+#if RVO_ENABLE_STATISTICS
+  statistics_->numObstacleNeighbors += obstacleNeighbors_.size();
+  statistics_->obstacleNeighborsTime += lapClockTime(&time);
+#endif /* RVO_ENABLE_STATISTICS */
+
   agentNeighbors_.clear();
+  agentNeighborHeap_.clear();
+  numAgentNeighborInsertions_ = 0U;
 
-  if (maxNeighbors_ > 0U) {
-    float rangeSq = neighborDist_ * neighborDist_;
+  if (store_->maxNeighbors_[id_] > 0U) {
+    Real rangeSq = store_->neighborDists_[id_] * store_->neighborDists_[id_];
     kdTree->computeAgentNeighbors(this, rangeSq);
   }
+
+  if (!agentNeighborHeap_.empty()) {
+    /* Ordering the heap by insertion after distance sorts equidistant
+     * neighbors in the order they were found, as insertion sort does. */
+    std::sort_heap(agentNeighborHeap_.begin(), agentNeighborHeap_.end());
+
+    for (std::size_t i = 0U; i < agentNeighborHeap_.size(); ++i) {
+      agentNeighbors_.push_back(std::make_pair(
+          agentNeighborHeap_[i].first.first, agentNeighborHeap_[i].second));
+    }
+  }
+
+#if RVO_ENABLE_STATISTICS
+  statistics_->maxAgentNeighbors =
+      std::max(statistics_->maxAgentNeighbors, agentNeighbors_.size());
+  statistics_->numAgentNeighbors += agentNeighbors_.size();
+  statistics_->agentNeighborsTime += lapClockTime(&time);
+#endif /* RVO_ENABLE_STATISTICS */
 }
 
 /* Search for the best new velocity. */
-void Agent::computeNewVelocity(float timeStep) {
+void Agent::computeNewVelocity(Real timeStep, bool vectorizeORCALines) {
+#if RVO_ENABLE_STATISTICS
+  double time = getClockTime();
+#endif /* RVO_ENABLE_STATISTICS */
+
   orcaLines_.clear();
 
-  const float invTimeHorizonObst = 1.0F / timeHorizonObst_;
+  const Vector2 position = store_->positions_[id_];
+  const Vector2 velocity = store_->velocities_[id_];
+  const Real radius = store_->radii_[id_];
+
+  const Real invTimeHorizonObst = 1.0F / store_->timeHorizonObsts_[id_];
 
   /* Create obstacle ORCA lines. */
   for (std::size_t i = 0U; i < obstacleNeighbors_.size(); ++i) {
     const Obstacle *obstacle1 = obstacleNeighbors_[i].second;
     const Obstacle *obstacle2 = obstacle1->next_;
 
-    const Vector2 relativePosition1 = obstacle1->point_ - position_;
-    const Vector2 relativePosition2 = obstacle2->point_ - position_;
+    const Vector2 relativePosition1 = obstacle1->point_ - position;
+    const Vector2 relativePosition2 = obstacle2->point_ - position;
 
     /* Check if velocity obstacle of obstacle is already taken care of by
      * previously constructed obstacle ORCA lines. */
@@ -287,11 +893,11 @@ void Agent::computeNewVelocity(float timeStep) {
     for (std::size_t j = 0U; j < orcaLines_.size(); ++j) {
       if (det(invTimeHorizonObst * relativePosition1 - orcaLines_[j].point,
               orcaLines_[j].direction) -
-                  invTimeHorizonObst * radius_ >=
+                  invTimeHorizonObst * radius >=
               -RVO_EPSILON &&
           det(invTimeHorizonObst * relativePosition2 - orcaLines_[j].point,
               orcaLines_[j].direction) -
-                  invTimeHorizonObst * radius_ >=
+                  invTimeHorizonObst * radius >=
               -RVO_EPSILON) {
         alreadyCovered = true;
         break;
@@ -303,15 +909,15 @@ void Agent::computeNewVelocity(float timeStep) {
     }
 
     /* Not yet covered. Check for collisions. */
-    const float distSq1 = absSq(relativePosition1);
-    const float distSq2 = absSq(relativePosition2);
+    const Real distSq1 = absSq(relativePosition1);
+    const Real distSq2 = absSq(relativePosition2);
 
-    const float radiusSq = radius_ * radius_;
+    const Real radiusSq = radius * radius;
 
     const Vector2 obstacleVector = obstacle2->point_ - obstacle1->point_;
-    const float s =
+    const Real s =
         (-relativePosition1 * obstacleVector) / absSq(obstacleVector);
-    const float distSqLine = absSq(-relativePosition1 - s * obstacleVector);
+    const Real distSqLine = absSq(-relativePosition1 - s * obstacleVector);
 
     Line line;
 
@@ -364,16 +970,16 @@ void Agent::computeNewVelocity(float timeStep) {
 
       obstacle2 = obstacle1;
 
-      const float leg1 = std::sqrt(distSq1 - radiusSq);
+      const Real leg1 = std::sqrt(distSq1 - radiusSq);
       leftLegDirection =
           Vector2(
-              relativePosition1.x() * leg1 - relativePosition1.y() * radius_,
-              relativePosition1.x() * radius_ + relativePosition1.y() * leg1) /
+              relativePosition1.x() * leg1 - relativePosition1.y() * radius,
+              relativePosition1.x() * radius + relativePosition1.y() * leg1) /
           distSq1;
       rightLegDirection =
           Vector2(
-              relativePosition1.x() * leg1 + relativePosition1.y() * radius_,
-              -relativePosition1.x() * radius_ + relativePosition1.y() * leg1) /
+              relativePosition1.x() * leg1 + relativePosition1.y() * radius,
+              -relativePosition1.x() * radius + relativePosition1.y() * leg1) /
           distSq1;
     } else if (s > 1.0F && distSqLine <= radiusSq) {
       /* Obstacle viewed obliquely so that right vertex defines velocity
@@ -385,24 +991,24 @@ void Agent::computeNewVelocity(float timeStep) {
 
       obstacle1 = obstacle2;
 
-      const float leg2 = std::sqrt(distSq2 - radiusSq);
+      const Real leg2 = std::sqrt(distSq2 - radiusSq);
       leftLegDirection =
           Vector2(
-              relativePosition2.x() * leg2 - relativePosition2.y() * radius_,
-              relativePosition2.x() * radius_ + relativePosition2.y() * leg2) /
+              relativePosition2.x() * leg2 - relativePosition2.y() * radius,
+              relativePosition2.x() * radius + relativePosition2.y() * leg2) /
           distSq2;
       rightLegDirection =
           Vector2(
-              relativePosition2.x() * leg2 + relativePosition2.y() * radius_,
-              -relativePosition2.x() * radius_ + relativePosition2.y() * leg2) /
+              relativePosition2.x() * leg2 + relativePosition2.y() * radius,
+              -relativePosition2.x() * radius + relativePosition2.y() * leg2) /
           distSq2;
     } else {
       /* Usual situation. */
       if (obstacle1->isConvex_) {
-        const float leg1 = std::sqrt(distSq1 - radiusSq);
+        const Real leg1 = std::sqrt(distSq1 - radiusSq);
         leftLegDirection = Vector2(relativePosition1.x() * leg1 -
-                                       relativePosition1.y() * radius_,
-                                   relativePosition1.x() * radius_ +
+                                       relativePosition1.y() * radius,
+                                   relativePosition1.x() * radius +
                                        relativePosition1.y() * leg1) /
                            distSq1;
       } else {
@@ -411,10 +1017,10 @@ void Agent::computeNewVelocity(float timeStep) {
       }
 
       if (obstacle2->isConvex_) {
-        const float leg2 = std::sqrt(distSq2 - radiusSq);
+        const Real leg2 = std::sqrt(distSq2 - radiusSq);
         rightLegDirection = Vector2(relativePosition2.x() * leg2 +
-                                        relativePosition2.y() * radius_,
-                                    -relativePosition2.x() * radius_ +
+                                        relativePosition2.y() * radius,
+                                    -relativePosition2.x() * radius +
                                         relativePosition2.y() * leg2) /
                             distSq2;
       } else {
@@ -447,62 +1053,62 @@ void Agent::computeNewVelocity(float timeStep) {
 
     /* Compute cut-off centers. */
     const Vector2 leftCutoff =
-        invTimeHorizonObst * (obstacle1->point_ - position_);
+        invTimeHorizonObst * (obstacle1->point_ - position);
     const Vector2 rightCutoff =
-        invTimeHorizonObst * (obstacle2->point_ - position_);
+        invTimeHorizonObst * (obstacle2->point_ - position);
     const Vector2 cutoffVector = rightCutoff - leftCutoff;
 
     /* Project current velocity on velocity obstacle. */
 
     /* Check if current velocity is projected on cutoff circles. */
-    const float t =
+    const Real t =
         obstacle1 == obstacle2
             ? 0.5F
-            : (velocity_ - leftCutoff) * cutoffVector / absSq(cutoffVector);
-    const float tLeft = (velocity_ - leftCutoff) * leftLegDirection;
-    const float tRight = (velocity_ - rightCutoff) * rightLegDirection;
+            : (velocity - leftCutoff) * cutoffVector / absSq(cutoffVector);
+    const Real tLeft = (velocity - leftCutoff) * leftLegDirection;
+    const Real tRight = (velocity - rightCutoff) * rightLegDirection;
 
     if ((t < 0.0F && tLeft < 0.0F) ||
         (obstacle1 == obstacle2 && tLeft < 0.0F && tRight < 0.0F)) {
       /* Project on left cut-off circle. */
-      const Vector2 unitW = normalize(velocity_ - leftCutoff);
+      const Vector2 unitW = normalize(velocity - leftCutoff);
 
       line.direction = Vector2(unitW.y(), -unitW.x());
-      line.point = leftCutoff + radius_ * invTimeHorizonObst * unitW;
+      line.point = leftCutoff + radius * invTimeHorizonObst * unitW;
       orcaLines_.push_back(line);
       continue;
     }
 
     if (t > 1.0F && tRight < 0.0F) {
       /* Project on right cut-off circle. */
-      const Vector2 unitW = normalize(velocity_ - rightCutoff);
+      const Vector2 unitW = normalize(velocity - rightCutoff);
 
       line.direction = Vector2(unitW.y(), -unitW.x());
-      line.point = rightCutoff + radius_ * invTimeHorizonObst * unitW;
+      line.point = rightCutoff + radius * invTimeHorizonObst * unitW;
       orcaLines_.push_back(line);
       continue;
     }
 
     /* Project on left leg, right leg, or cut-off line, whichever is closest to
      * velocity. */
-    const float distSqCutoff =
+    const Real distSqCutoff =
         (t < 0.0F || t > 1.0F || obstacle1 == obstacle2)
-            ? std::numeric_limits<float>::infinity()
-            : absSq(velocity_ - (leftCutoff + t * cutoffVector));
-    const float distSqLeft =
+            ? std::numeric_limits<Real>::infinity()
+            : absSq(velocity - (leftCutoff + t * cutoffVector));
+    const Real distSqLeft =
         tLeft < 0.0F
-            ? std::numeric_limits<float>::infinity()
-            : absSq(velocity_ - (leftCutoff + tLeft * leftLegDirection));
-    const float distSqRight =
+            ? std::numeric_limits<Real>::infinity()
+            : absSq(velocity - (leftCutoff + tLeft * leftLegDirection));
+    const Real distSqRight =
         tRight < 0.0F
-            ? std::numeric_limits<float>::infinity()
-            : absSq(velocity_ - (rightCutoff + tRight * rightLegDirection));
+            ? std::numeric_limits<Real>::infinity()
+            : absSq(velocity - (rightCutoff + tRight * rightLegDirection));
 
     if (distSqCutoff <= distSqLeft && distSqCutoff <= distSqRight) {
       /* Project on cut-off line. */
       line.direction = -obstacle1->direction_;
       line.point =
-          leftCutoff + radius_ * invTimeHorizonObst *
+          leftCutoff + radius * invTimeHorizonObst *
                            Vector2(-line.direction.y(), line.direction.x());
       orcaLines_.push_back(line);
       continue;
@@ -516,7 +1122,7 @@ void Agent::computeNewVelocity(float timeStep) {
 
       line.direction = leftLegDirection;
       line.point =
-          leftCutoff + radius_ * invTimeHorizonObst *
+          leftCutoff + radius * invTimeHorizonObst *
                            Vector2(-line.direction.y(), line.direction.x());
       orcaLines_.push_back(line);
       continue;
@@ -529,100 +1135,223 @@ void Agent::computeNewVelocity(float timeStep) {
 
     line.direction = -rightLegDirection;
     line.point =
-        rightCutoff + radius_ * invTimeHorizonObst *
+        rightCutoff + radius * invTimeHorizonObst *
                           Vector2(-line.direction.y(), line.direction.x());
     orcaLines_.push_back(line);
   }
 
   const std::size_t numObstLines = orcaLines_.size();
 
-  const float invTimeHorizon = 1.0F / timeHorizon_;
-
-  /* Create agent ORCA lines. */
-  for (std::size_t i = 0U; i < agentNeighbors_.size(); ++i) {
-    const Agent *const other = agentNeighbors_[i].second;
+  const Real invTimeHorizon = 1.0F / store_->timeHorizons_[id_];
+
+  if (vectorizeORCALines) {
+    /* Create agent ORCA lines RVO_ORCA_BATCH_WIDTH at a time. The lanes past
+     * the last neighbor repeat it, and their lines are discarded. */
+    const Real invTimeStep = 1.0F / timeStep;
+
+    Real relativePositionsX[RVO_ORCA_BATCH_WIDTH];
+    Real relativePositionsY[RVO_ORCA_BATCH_WIDTH];
+    Real relativeVelocitiesX[RVO_ORCA_BATCH_WIDTH];
+    Real relativeVelocitiesY[RVO_ORCA_BATCH_WIDTH];
+    Real combinedRadii[RVO_ORCA_BATCH_WIDTH];
+    Real directionsX[RVO_ORCA_BATCH_WIDTH];
+    Real directionsY[RVO_ORCA_BATCH_WIDTH];
+    Real uX[RVO_ORCA_BATCH_WIDTH];
+    Real uY[RVO_ORCA_BATCH_WIDTH];
+
+    for (std::size_t i = 0U; i < agentNeighbors_.size();
+         i += RVO_ORCA_BATCH_WIDTH) {
+      const std::size_t numLanes =
+          std::min(RVO_ORCA_BATCH_WIDTH, agentNeighbors_.size() - i);
+
+      for (std::size_t j = 0U; j < RVO_ORCA_BATCH_WIDTH; ++j) {
+        const std::size_t other =
+            agentNeighbors_[i + std::min(j, numLanes - 1U)].second;
+
+        const Vector2 relativePosition = store_->positions_[other] - position;
+        const Vector2 relativeVelocity = velocity - store_->velocities_[other];
+
+        relativePositionsX[j] = relativePosition.x();
+        relativePositionsY[j] = relativePosition.y();
+        relativeVelocitiesX[j] = relativeVelocity.x();
+        relativeVelocitiesY[j] = relativeVelocity.y();
+        combinedRadii[j] = radius + store_->radii_[other];
+      }
 
-    const Vector2 relativePosition = other->position_ - position_;
-    const Vector2 relativeVelocity = velocity_ - other->velocity_;
-    const float distSq = absSq(relativePosition);
-    const float combinedRadius = radius_ + other->radius_;
-    const float combinedRadiusSq = combinedRadius * combinedRadius;
+      computeORCALineBatch(relativePositionsX, relativePositionsY,
+                           relativeVelocitiesX, relativeVelocitiesY,
+                           combinedRadii, invTimeHorizon, invTimeStep,
+                           directionsX, directionsY, uX, uY);
 
-    Line line;
-    Vector2 u;
+      for (std::size_t j = 0U; j < numLanes; ++j) {
+        Line line;
+        line.direction = Vector2(directionsX[j], directionsY[j]);
+        line.point = velocity + 0.5F * Vector2(uX[j], uY[j]);
+        orcaLines_.push_back(line);
+      }
+    }
+  } else {
+    /* Create agent ORCA lines. */
+    for (std::size_t i = 0U; i < agentNeighbors_.size(); ++i) {
+      const std::size_t other = agentNeighbors_[i].second;
+
+      const Vector2 relativePosition = store_->positions_[other] - position;
+      const Vector2 relativeVelocity = velocity - store_->velocities_[other];
+      const Real distSq = absSq(relativePosition);
+      const Real combinedRadius = radius + store_->radii_[other];
+      const Real combinedRadiusSq = combinedRadius * combinedRadius;
+
+      Line line;
+      Vector2 u;
+
+      if (distSq > combinedRadiusSq) {
+        /* No collision. */
+        const Vector2 w = relativeVelocity - invTimeHorizon * relativePosition;
+        /* Vector from cutoff center to relative velocity. */
+        const Real wLengthSq = absSq(w);
+
+        const Real dotProduct = w * relativePosition;
+
+        if (dotProduct < 0.0F &&
+            dotProduct * dotProduct > combinedRadiusSq * wLengthSq) {
+          /* Project on cut-off circle. */
+          const Real wLength = std::sqrt(wLengthSq);
+          const Vector2 unitW = w / wLength;
+
+          line.direction = Vector2(unitW.y(), -unitW.x());
+          u = (combinedRadius * invTimeHorizon - wLength) * unitW;
+        } else {
+          /* Project on legs. */
+          const Real leg = std::sqrt(distSq - combinedRadiusSq);
+
+          if (det(relativePosition, w) > 0.0F) {
+            /* Project on left leg. */
+            line.direction = Vector2(relativePosition.x() * leg -
+                                         relativePosition.y() * combinedRadius,
+                                     relativePosition.x() * combinedRadius +
+                                         relativePosition.y() * leg) /
+                             distSq;
+          } else {
+            /* Project on right leg. */
+            line.direction = -Vector2(relativePosition.x() * leg +
+                                          relativePosition.y() * combinedRadius,
+                                      -relativePosition.x() * combinedRadius +
+                                          relativePosition.y() * leg) /
+                             distSq;
+          }
 
-    if (distSq > combinedRadiusSq) {
-      /* No collision. */
-      const Vector2 w = relativeVelocity - invTimeHorizon * relativePosition;
-      /* Vector from cutoff center to relative velocity. */
-      const float wLengthSq = absSq(w);
+          u = (relativeVelocity * line.direction) * line.direction -
+              relativeVelocity;
+        }
+      } else {
+        /* Collision. Project on cut-off circle of time timeStep. */
+        const Real invTimeStep = 1.0F / timeStep;
 
-      const float dotProduct = w * relativePosition;
+        /* Vector from cutoff center to relative velocity. */
+        const Vector2 w = relativeVelocity - invTimeStep * relativePosition;
 
-      if (dotProduct < 0.0F &&
-          dotProduct * dotProduct > combinedRadiusSq * wLengthSq) {
-        /* Project on cut-off circle. */
-        const float wLength = std::sqrt(wLengthSq);
+        const Real wLength = abs(w);
         const Vector2 unitW = w / wLength;
 
         line.direction = Vector2(unitW.y(), -unitW.x());
-        u = (combinedRadius * invTimeHorizon - wLength) * unitW;
-      } else {
-        /* Project on legs. */
-        const float leg = std::sqrt(distSq - combinedRadiusSq);
-
-        if (det(relativePosition, w) > 0.0F) {
-          /* Project on left leg. */
-          line.direction = Vector2(relativePosition.x() * leg -
-                                       relativePosition.y() * combinedRadius,
-                                   relativePosition.x() * combinedRadius +
-                                       relativePosition.y() * leg) /
-                           distSq;
-        } else {
-          /* Project on right leg. */
-          line.direction = -Vector2(relativePosition.x() * leg +
-                                        relativePosition.y() * combinedRadius,
-                                    -relativePosition.x() * combinedRadius +
-                                        relativePosition.y() * leg) /
-                           distSq;
-        }
-
-        u = (relativeVelocity * line.direction) * line.direction -
-            relativeVelocity;
+        u = (combinedRadius * invTimeStep - wLength) * unitW;
       }
-    } else {
-      /* Collision. Project on cut-off circle of time timeStep. */
-      const float invTimeStep = 1.0F / timeStep;
-
-      /* Vector from cutoff center to relative velocity. */
-      const Vector2 w = relativeVelocity - invTimeStep * relativePosition;
 
-      const float wLength = abs(w);
-      const Vector2 unitW = w / wLength;
-
-      line.direction = Vector2(unitW.y(), -unitW.x());
-      u = (combinedRadius * invTimeStep - wLength) * unitW;
+      line.point = velocity + 0.5F * u;
+      orcaLines_.push_back(line);
     }
-
-    line.point = velocity_ + 0.5F * u;
-    orcaLines_.push_back(line);
   }
 
+#if RVO_ENABLE_STATISTICS
+  statistics_->orcaLinesTime += lapClockTime(&time);
+#endif /* RVO_ENABLE_STATISTICS */
+
+  const Real maxSpeed = store_->maxSpeeds_[id_];
+  Vector2 &newVelocity = store_->newVelocities_[id_];
+
   const std::size_t lineFail =
-      linearProgram2(orcaLines_, maxSpeed_, prefVelocity_, false, newVelocity_);
+      linearProgram2(orcaLines_, maxSpeed, store_->stepPrefVelocities_[id_],
+                     false, newVelocity);
+
+#if RVO_ENABLE_STATISTICS
+  statistics_->linearProgram2Time += lapClockTime(&time);
+#endif /* RVO_ENABLE_STATISTICS */
 
   if (lineFail < orcaLines_.size()) {
-    linearProgram3(orcaLines_, numObstLines, lineFail, maxSpeed_, newVelocity_);
+    linearProgram3(orcaLines_, numObstLines, lineFail, maxSpeed, projLines_,
+                   newVelocity);
+
+#if RVO_ENABLE_STATISTICS
+    ++statistics_->numLinearProgram3Calls;
+    statistics_->linearProgram3Time += lapClockTime(&time);
+#endif /* RVO_ENABLE_STATISTICS */
   }
+
+  store_->newPositions_[id_] = position + newVelocity * timeStep;
+
+#if RVO_ENABLE_STATISTICS
+  statistics_->integrationTime += lapClockTime(&time);
+#endif /* RVO_ENABLE_STATISTICS */
 }
 
-void Agent::insertAgentNeighbor(const Agent *agent, float &rangeSq) {
-  if (this != agent) {
-    const float distSq = absSq(position_ - agent->position_);
+void Agent::computePrefVelocity(std::size_t stepNo, Real perturbation) {
+  Vector2 goalVector = store_->goals_[id_] - store_->positions_[id_];
+  const Real goalDistSq = absSq(goalVector);
+  const Real goalRadius = store_->goalRadii_[id_];
+  const Real goalSpeed = store_->goalSpeeds_[id_];
 
+  if (goalDistSq <= goalRadius * goalRadius) {
+    goalVector = Vector2();
+  } else if (goalDistSq > goalSpeed * goalSpeed) {
+    goalVector = goalSpeed * normalize(goalVector);
+  }
+
+  if (perturbation > 0.0F) {
+    /* Perturb a little to avoid deadlocks due to perfect symmetry. The
+     * perturbation depends only on the agent number and the step, so it is
+     * the same however the agents are ordered and scheduled. */
+    const unsigned long bits1 = hashBits(
+        (static_cast<unsigned long>(store_->ids_[id_]) * 2UL) ^
+        hashBits(static_cast<unsigned long>(stepNo)));
+    const unsigned long bits2 = hashBits(bits1 + 1UL);
+    const Real angle =
+        static_cast<Real>(bits1) * (RVO_TWO_PI / 4294967296.0F);
+    const Real dist =
+        static_cast<Real>(bits2) * (perturbation / 4294967296.0F);
+
+    goalVector += dist * unitVector(angle);
+  }
+
+  store_->stepPrefVelocities_[id_] = goalVector;
+}
+
+void Agent::insertAgentNeighbor(std::size_t agentNo, Real distSq,
+                                Real &rangeSq) {
+  if (id_ != agentNo) {
     if (distSq < rangeSq) {
-      if (agentNeighbors_.size() < maxNeighbors_) {
-        agentNeighbors_.push_back(std::make_pair(distSq, agent));
+      const std::size_t maxNeighbors = store_->maxNeighbors_[id_];
+
+      if (maxNeighbors > RVO_MAX_INSERTION_SORT_NEIGHBORS) {
+        /* Keep the closest neighbors in a bounded max-heap. The farthest
+         * neighbor, and of equidistant ones the last found, is evicted. */
+        if (agentNeighborHeap_.size() == maxNeighbors) {
+          std::pop_heap(agentNeighborHeap_.begin(), agentNeighborHeap_.end());
+          agentNeighborHeap_.pop_back();
+        }
+
+        agentNeighborHeap_.push_back(std::make_pair(
+            std::make_pair(distSq, numAgentNeighborInsertions_++), agentNo));
+        std::push_heap(agentNeighborHeap_.begin(), agentNeighborHeap_.end());
+
+        if (agentNeighborHeap_.size() == maxNeighbors) {
+          rangeSq = agentNeighborHeap_.front().first.first;
+        }
+
+        return;
+      }
+
+      if (agentNeighbors_.size() < maxNeighbors) {
+        agentNeighbors_.push_back(std::make_pair(distSq, agentNo));
       }
 
       std::size_t i = agentNeighbors_.size() - 1U;
@@ -632,48 +1361,35 @@ void Agent::insertAgentNeighbor(const Agent *agent, float &rangeSq) {
         --i;
       }
 
-      agentNeighbors_[i] = std::make_pair(distSq, agent);
+      agentNeighbors_[i] = std::make_pair(distSq, agentNo);
 
-      if (agentNeighbors_.size() == maxNeighbors_) {
+      if (agentNeighbors_.size() == maxNeighbors) {
         rangeSq = agentNeighbors_.back().first;
       }
     }
   }
 }
 
-void Agent::insertObstacleNeighbor(const Obstacle *obstacle, float rangeSq) {
+void Agent::insertObstacleNeighbor(const Obstacle *obstacle, Real rangeSq) {
   const Obstacle *const nextObstacle = obstacle->next_;
+  const Vector2 &position = store_->positions_[id_];
 
-  float distSq = 0.0F;
-  const float r = ((position_ - obstacle->point_) *
+  Real distSq = 0.0F;
+  const Real r = ((position - obstacle->point_) *
                    (nextObstacle->point_ - obstacle->point_)) /
                   absSq(nextObstacle->point_ - obstacle->point_);
 
   if (r < 0.0F) {
-    distSq = absSq(position_ - obstacle->point_);
+    distSq = absSq(position - obstacle->point_);
   } else if (r > 1.0F) {
-    distSq = absSq(position_ - nextObstacle->point_);
+    distSq = absSq(position - nextObstacle->point_);
   } else {
-    distSq = absSq(position_ - (obstacle->point_ +
+    distSq = absSq(position - (obstacle->point_ +
                                 r * (nextObstacle->point_ - obstacle->point_)));
   }
 
   if (distSq < rangeSq) {
     obstacleNeighbors_.push_back(std::make_pair(distSq, obstacle));
-
-    std::size_t i = obstacleNeighbors_.size() - 1U;
-
-    while (i != 0U && distSq < obstacleNeighbors_[i - 1U].first) {
-      obstacleNeighbors_[i] = obstacleNeighbors_[i - 1U];
-      --i;
-    }
-
-    obstacleNeighbors_[i] = std::make_pair(distSq, obstacle);
   }
 }
-
-void Agent::update(float timeStep) {
-  velocity_ = newVelocity_;
-  position_ += velocity_ * timeStep;
-}
 } /* namespace RVO */
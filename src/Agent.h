@@ -44,11 +44,13 @@
 #include <vector>
 
 #include "Line.h"
-#include "Vector2.h"
+#include "Real.h"
 
 namespace RVO {
+class AgentStore;
 class KdTree;
 class Obstacle;
+class StepStatistics;
 
 /**
  * @brief Defines an agent in the simulation.
@@ -56,9 +58,12 @@ class Obstacle;
 class Agent {
  private:
   /**
-   * @brief Constructs an agent instance.
+   * @brief     Constructs an agent instance.
+   * @param[in] store The agent store that holds the state and parameters of
+   *                  this agent.
+   * @param[in] id    The number of this agent in the agent store.
    */
-  Agent();
+  Agent(AgentStore *store, std::size_t id);
 
   /**
    * @brief Destroys this agent instance.
@@ -73,19 +78,34 @@ class Agent {
   void computeNeighbors(const KdTree *kdTree);
 
   /**
-   * @brief     Computes the new velocity of this agent.
-   * @param[in] timeStep The time step of the simulation.
+   * @brief     Computes the new velocity of this agent and integrates its new
+   *            position.
+   * @param[in] timeStep           The time step of the simulation.
+   * @param[in] vectorizeORCALines True if the ORCA lines induced by the agent
+   *                               neighbors are to be computed in batches of
+   *                               vector lanes.
    */
-  void computeNewVelocity(float timeStep);
+  void computeNewVelocity(Real timeStep, bool vectorizeORCALines);
+
+  /**
+   * @brief     Computes the preferred velocity of this agent toward its goal
+   *            for the present simulation step.
+   * @param[in] stepNo       The number of the simulation step.
+   * @param[in] perturbation The maximum magnitude of the random perturbation
+   *                         of the preferred velocity.
+   */
+  void computePrefVelocity(std::size_t stepNo, Real perturbation);
 
   /**
    * @brief          Inserts an agent neighbor into the set of neighbors of this
    *                 agent.
-   * @param[in]      agent   A pointer to the agent to be inserted.
+   * @param[in]      agentNo The number of the agent to be inserted.
+   * @param[in]      distSq  The squared distance from this agent to the agent
+   *                         to be inserted.
    * @param[in, out] rangeSq The squared range around this agent.
    */
-  void insertAgentNeighbor(const Agent *agent,
-                           float &rangeSq); /* NOLINT(runtime/references) */
+  void insertAgentNeighbor(std::size_t agentNo, Real distSq,
+                           Real &rangeSq); /* NOLINT(runtime/references) */
 
   /**
    * @brief          Inserts a static obstacle neighbor into the set of
@@ -93,14 +113,7 @@ class Agent {
    * @param[in]      obstacle The number of the static obstacle to be inserted.
    * @param[in, out] rangeSq  The squared range around this agent.
    */
-  void insertObstacleNeighbor(const Obstacle *obstacle, float rangeSq);
-
-  /**
-   * @brief     Updates the two-dimensional position and two-dimensional
-   *            velocity of this agent.
-   * @param[in] timeStep The time step of the simulation.
-   */
-  void update(float timeStep);
+  void insertObstacleNeighbor(const Obstacle *obstacle, Real rangeSq);
 
   /* Not implemented. */
   Agent(const Agent &other);
@@ -108,20 +121,18 @@ class Agent {
   /* Not implemented. */
   Agent &operator=(const Agent &other);
 
-  std::vector<std::pair<float, const Agent *> > agentNeighbors_;
-  std::vector<std::pair<float, const Obstacle *> > obstacleNeighbors_;
+  std::vector<std::pair<Real, std::size_t> > agentNeighbors_;
+  std::vector<std::pair<std::pair<Real, std::size_t>, std::size_t> >
+      agentNeighborHeap_;
+  std::vector<std::pair<Real, const Obstacle *> > obstacleNeighbors_;
+  std::vector<std::pair<std::pair<Real, std::size_t>, const Obstacle *> >
+      obstacleNeighborBuffer_;
   std::vector<Line> orcaLines_;
-  Vector2 newVelocity_;
-  Vector2 position_;
-  Vector2 prefVelocity_;
-  Vector2 velocity_;
+  std::vector<Line> projLines_;
+  AgentStore *store_;
   std::size_t id_;
-  std::size_t maxNeighbors_;
-  float maxSpeed_;
-  float neighborDist_;
-  float radius_;
-  float timeHorizon_;
-  float timeHorizonObst_;
+  std::size_t numAgentNeighborInsertions_;
+  StepStatistics *statistics_;
 
   friend class KdTree;
   friend class RVOSimulator;
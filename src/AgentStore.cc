@@ -0,0 +1,337 @@
+/*
+ * AgentStore.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  AgentStore.cc
+ * @brief Defines the AgentStore class.
+ */
+
+#include "AgentStore.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "RVOSimulator.h"
+#include "Snapshot.h"
+
+namespace RVO {
+namespace {
+/**
+ * @relates AgentStore
+ * @brief   The count of bits of each coordinate in a Morton code.
+ */
+const unsigned int RVO_MORTON_BITS = 16U;
+
+/**
+ * @relates   AgentStore
+ * @brief     Spreads the lower sixteen bits of the specified value to its even
+ *            bits.
+ * @param[in] value The value whose bits are to be spread.
+ * @return    The value with its bits spread.
+ */
+unsigned long spreadBits(unsigned long value) {
+  value &= 0x0000FFFFUL;
+  value = (value | (value << 8U)) & 0x00FF00FFUL;
+  value = (value | (value << 4U)) & 0x0F0F0F0FUL;
+  value = (value | (value << 2U)) & 0x33333333UL;
+  value = (value | (value << 1U)) & 0x55555555UL;
+
+  return value;
+}
+
+/**
+ * @relates      AgentStore
+ * @brief        Permutes the specified array.
+ * @param[in]    order The list of indices in their new order.
+ * @param[inout] array The array to be permuted.
+ */
+template <typename T>
+void permute(const std::vector<std::size_t> &order,
+             std::vector<T> &array) { /* NOLINT(runtime/references) */
+  std::vector<T> permuted(array.size());
+
+  for (std::size_t i = 0U; i < order.size(); ++i) {
+    permuted[i] = array[order[i]];
+  }
+
+  array.swap(permuted);
+}
+
+/**
+ * @relates      AgentStore
+ * @brief        Removes an element from the specified array by moving the last
+ *               element into its place.
+ * @param[in]    index The index of the element to be removed.
+ * @param[inout] array The array from which the element is to be removed.
+ */
+template <typename T>
+void swapRemove(std::size_t index,
+                std::vector<T> &array) { /* NOLINT(runtime/references) */
+  array[index] = array.back();
+  array.pop_back();
+}
+
+/**
+ * @relates   AgentStore
+ * @brief     Quantizes the specified coordinate to the bits of a Morton code.
+ * @param[in] value The coordinate to be quantized.
+ * @param[in] min   The minimum coordinate.
+ * @param[in] scale The scale from coordinates to quantized coordinates.
+ * @return    The quantized coordinate.
+ */
+unsigned long quantize(Real value, Real min, Real scale) {
+  const Real maxQuantized =
+      static_cast<Real>((1UL << RVO_MORTON_BITS) - 1UL);
+
+  return static_cast<unsigned long>(
+      std::min(maxQuantized, (value - min) * scale));
+}
+} /* namespace */
+
+AgentStore::AgentStore() {}
+
+AgentStore::~AgentStore() {}
+
+std::size_t AgentStore::addAgent(const Vector2 &position, Real neighborDist,
+                                 std::size_t maxNeighbors, Real timeHorizon,
+                                 Real timeHorizonObst, Real radius,
+                                 Real maxSpeed, const Vector2 &velocity) {
+  std::size_t id = slots_.size();
+
+  /* The free numbers form a min-heap, so the least one is reused and the
+   * numbering does not depend on the order of earlier removals. */
+  if (freeIds_.empty()) {
+    slots_.push_back(positions_.size());
+    generations_.push_back(0U);
+  } else {
+    std::pop_heap(freeIds_.begin(), freeIds_.end(),
+                  std::greater<std::size_t>());
+    id = freeIds_.back();
+    freeIds_.pop_back();
+    slots_[id] = positions_.size();
+  }
+
+  ids_.push_back(id);
+
+  goals_.push_back(Vector2());
+  newPositions_.push_back(Vector2());
+  newVelocities_.push_back(Vector2());
+  positions_.push_back(position);
+  prefVelocities_.push_back(Vector2());
+  velocities_.push_back(velocity);
+  maxNeighbors_.push_back(maxNeighbors);
+  goalRadii_.push_back(0.0F);
+  goalSpeeds_.push_back(0.0F);
+  maxSpeeds_.push_back(maxSpeed);
+  neighborDists_.push_back(neighborDist);
+  radii_.push_back(radius);
+  timeHorizons_.push_back(timeHorizon);
+  timeHorizonObsts_.push_back(timeHorizonObst);
+  hasGoals_.push_back(false);
+
+  return id;
+}
+
+void AgentStore::computeMortonOrder(std::vector<std::size_t> &order) const {
+  order.resize(positions_.size());
+
+  if (positions_.empty()) {
+    return;
+  }
+
+  Real minX = positions_[0U].x();
+  Real minY = positions_[0U].y();
+  Real maxX = minX;
+  Real maxY = minY;
+
+  for (std::size_t i = 1U; i < positions_.size(); ++i) {
+    maxX = std::max(maxX, positions_[i].x());
+    minX = std::min(minX, positions_[i].x());
+    maxY = std::max(maxY, positions_[i].y());
+    minY = std::min(minY, positions_[i].y());
+  }
+
+  /* Quantize both coordinates with the same scale to keep cells square. */
+  const Real extent = std::max(maxX - minX, maxY - minY);
+  const Real scale =
+      extent > 0.0F
+          ? static_cast<Real>(1UL << RVO_MORTON_BITS) / extent
+          : 0.0F;
+
+  std::vector<std::pair<unsigned long, std::size_t> > codes(positions_.size());
+
+  for (std::size_t i = 0U; i < positions_.size(); ++i) {
+    codes[i].first = spreadBits(quantize(positions_[i].x(), minX, scale)) |
+                     (spreadBits(quantize(positions_[i].y(), minY, scale))
+                      << 1U);
+    codes[i].second = i;
+  }
+
+  std::sort(codes.begin(), codes.end());
+
+  for (std::size_t i = 0U; i < codes.size(); ++i) {
+    order[i] = codes[i].second;
+  }
+}
+
+bool AgentStore::readSnapshot(SnapshotReader *reader) {
+  std::size_t numSlots = 0U;
+  std::size_t numAgents = 0U;
+
+  if (!reader->readSize(&numSlots) || !reader->readSizes(numSlots, &slots_) ||
+      !reader->readSizes(numSlots, &generations_) ||
+      !reader->readSize(&numAgents) ||
+      !reader->readVector2s(numAgents, &goals_) ||
+      !reader->readVector2s(numAgents, &positions_) ||
+      !reader->readVector2s(numAgents, &prefVelocities_) ||
+      !reader->readVector2s(numAgents, &velocities_) ||
+      !reader->readSizes(numAgents, &ids_) ||
+      !reader->readSizes(numAgents, &maxNeighbors_) ||
+      !reader->readReals(numAgents, &goalRadii_) ||
+      !reader->readReals(numAgents, &goalSpeeds_) ||
+      !reader->readReals(numAgents, &maxSpeeds_) ||
+      !reader->readReals(numAgents, &neighborDists_) ||
+      !reader->readReals(numAgents, &radii_) ||
+      !reader->readReals(numAgents, &timeHorizons_) ||
+      !reader->readReals(numAgents, &timeHorizonObsts_) ||
+      !reader->readBools(numAgents, &hasGoals_)) {
+    return false;
+  }
+
+  /* Each agent must be in the slot of its number, and each slot of a number
+   * that is not removed must hold the agent of that number. */
+  for (std::size_t i = 0U; i < numAgents; ++i) {
+    if (ids_[i] >= numSlots || slots_[ids_[i]] != i) {
+      return false;
+    }
+  }
+
+  /* The free numbers are found in increasing order, which is a min-heap. */
+  freeIds_.clear();
+
+  for (std::size_t i = 0U; i < numSlots; ++i) {
+    if (slots_[i] == RVO_ERROR) {
+      freeIds_.push_back(i);
+    } else if (slots_[i] >= numAgents || ids_[slots_[i]] != i) {
+      return false;
+    }
+  }
+
+  newPositions_.assign(numAgents, Vector2());
+  newVelocities_.assign(numAgents, Vector2());
+  stepPrefVelocities_.assign(numAgents, Vector2());
+
+  return true;
+}
+
+void AgentStore::removeAgent(std::size_t id) {
+  const std::size_t slot = slots_[id];
+
+  swapRemove(slot, goals_);
+  swapRemove(slot, newPositions_);
+  swapRemove(slot, newVelocities_);
+  swapRemove(slot, positions_);
+  swapRemove(slot, prefVelocities_);
+  swapRemove(slot, velocities_);
+  swapRemove(slot, ids_);
+  swapRemove(slot, maxNeighbors_);
+  swapRemove(slot, goalRadii_);
+  swapRemove(slot, goalSpeeds_);
+  swapRemove(slot, maxSpeeds_);
+  swapRemove(slot, neighborDists_);
+  swapRemove(slot, radii_);
+  swapRemove(slot, timeHorizons_);
+  swapRemove(slot, timeHorizonObsts_);
+  swapRemove(slot, hasGoals_);
+
+  if (slot < ids_.size()) {
+    slots_[ids_[slot]] = slot;
+  }
+
+  slots_[id] = RVO_ERROR;
+  ++generations_[id];
+  freeIds_.push_back(id);
+  std::push_heap(freeIds_.begin(), freeIds_.end(),
+                 std::greater<std::size_t>());
+}
+
+void AgentStore::reorder(const std::vector<std::size_t> &order) {
+  /* The new positions and velocities are overwritten by the next simulation
+   * step before they are read, so they are not permuted. */
+  permute(order, goals_);
+  permute(order, positions_);
+  permute(order, prefVelocities_);
+  permute(order, velocities_);
+  permute(order, ids_);
+  permute(order, maxNeighbors_);
+  permute(order, goalRadii_);
+  permute(order, goalSpeeds_);
+  permute(order, maxSpeeds_);
+  permute(order, neighborDists_);
+  permute(order, radii_);
+  permute(order, timeHorizons_);
+  permute(order, timeHorizonObsts_);
+  permute(order, hasGoals_);
+
+  for (std::size_t i = 0U; i < ids_.size(); ++i) {
+    slots_[ids_[i]] = i;
+  }
+}
+
+void AgentStore::swapBuffers() {
+  positions_.swap(newPositions_);
+  velocities_.swap(newVelocities_);
+}
+
+void AgentStore::writeSnapshot(SnapshotWriter *writer) const {
+  writer->writeSize(slots_.size());
+  writer->writeSizes(slots_);
+  writer->writeSizes(generations_);
+  writer->writeSize(positions_.size());
+  writer->writeVector2s(goals_);
+  writer->writeVector2s(positions_);
+  writer->writeVector2s(prefVelocities_);
+  writer->writeVector2s(velocities_);
+  writer->writeSizes(ids_);
+  writer->writeSizes(maxNeighbors_);
+  writer->writeReals(goalRadii_);
+  writer->writeReals(goalSpeeds_);
+  writer->writeReals(maxSpeeds_);
+  writer->writeReals(neighborDists_);
+  writer->writeReals(radii_);
+  writer->writeReals(timeHorizons_);
+  writer->writeReals(timeHorizonObsts_);
+  writer->writeBools(hasGoals_);
+}
+} /* namespace RVO */
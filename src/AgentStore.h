@@ -0,0 +1,178 @@
+/*
+ * AgentStore.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_AGENT_STORE_H_
+#define RVO_AGENT_STORE_H_
+
+/**
+ * @file  AgentStore.h
+ * @brief Declares the AgentStore class.
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "Real.h"
+#include "Vector2.h"
+
+namespace RVO {
+class SnapshotReader;
+class SnapshotWriter;
+
+/**
+ * @brief Defines the structure-of-arrays storage of the state and parameters
+ *        of the agents in the simulation. Each property is held in its own
+ *        contiguous array indexed by slot. The slot of an agent may change
+ *        when the agents are reordered, but its number does not. The number
+ *        of a removed agent is reused by the next agent added, and its
+ *        generation is incremented so that stale numbers may be detected.
+ */
+class AgentStore {
+ private:
+  /**
+   * @brief Constructs an agent store instance.
+   */
+  AgentStore();
+
+  /**
+   * @brief Destroys this agent store instance.
+   */
+  ~AgentStore();
+
+  /**
+   * @brief     Appends a new agent to this agent store.
+   * @param[in] position        The two-dimensional starting position of the
+   *                            agent.
+   * @param[in] neighborDist    The maximum neighbor distance of the agent.
+   * @param[in] maxNeighbors    The maximum neighbor count of the agent.
+   * @param[in] timeHorizon     The time horizon of the agent with respect to
+   *                            other agents.
+   * @param[in] timeHorizonObst The time horizon of the agent with respect to
+   *                            obstacles.
+   * @param[in] radius          The radius of the agent.
+   * @param[in] maxSpeed        The maximum speed of the agent.
+   * @param[in] velocity        The initial two-dimensional linear velocity of
+   *                            the agent.
+   * @return    The number of the agent, which is the least number of a removed
+   *            agent, if any. The agent is stored in the last slot.
+   */
+  std::size_t addAgent(const Vector2 &position, Real neighborDist,
+                       std::size_t maxNeighbors, Real timeHorizon,
+                       Real timeHorizonObst, Real radius, Real maxSpeed,
+                       const Vector2 &velocity);
+
+  /**
+   * @brief      Computes the order of the slots of this agent store along a
+   *             Morton (Z-order) curve through the positions of the agents.
+   * @param[out] order The list that receives the slots in Morton order.
+   */
+  void computeMortonOrder(
+      std::vector<std::size_t> &order) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief     Reads the agents of this agent store from a snapshot, replacing
+   *            its contents. The slots and numbers of the agents are checked
+   *            for consistency.
+   * @param[in] reader The snapshot reader.
+   * @return    Whether the agents were read.
+   */
+  bool readSnapshot(SnapshotReader *reader);
+
+  /**
+   * @brief     Removes an agent from this agent store by moving the agent in
+   *            the last slot into its slot.
+   * @param[in] id The number of the agent to be removed.
+   */
+  void removeAgent(std::size_t id);
+
+  /**
+   * @brief     Permutes the slots of this agent store.
+   * @param[in] order The list of slots in their new order. The agent in slot
+   *                  order[i] moves to slot i.
+   */
+  void reorder(const std::vector<std::size_t> &order);
+
+  /**
+   * @brief  Returns the count of agents in this agent store.
+   * @return The count of agents in this agent store.
+   */
+  std::size_t size() const { return positions_.size(); }
+
+  /**
+   * @brief Exchanges the present two-dimensional positions and velocities of
+   *        the agents with the new ones.
+   */
+  void swapBuffers();
+
+  /**
+   * @brief     Writes the agents of this agent store to a snapshot. The new
+   *            positions and velocities, which are only valid during a
+   *            simulation step, are not written.
+   * @param[in] writer The snapshot writer.
+   */
+  void writeSnapshot(SnapshotWriter *writer) const;
+
+  /* Not implemented. */
+  AgentStore(const AgentStore &other);
+
+  /* Not implemented. */
+  AgentStore &operator=(const AgentStore &other);
+
+  std::vector<Vector2> goals_;
+  std::vector<Vector2> newPositions_;
+  std::vector<Vector2> newVelocities_;
+  std::vector<Vector2> positions_;
+  std::vector<Vector2> prefVelocities_;
+  std::vector<Vector2> stepPrefVelocities_;
+  std::vector<Vector2> velocities_;
+  std::vector<std::size_t> freeIds_;
+  std::vector<std::size_t> generations_;
+  std::vector<std::size_t> ids_;
+  std::vector<std::size_t> maxNeighbors_;
+  std::vector<std::size_t> slots_;
+  std::vector<Real> goalRadii_;
+  std::vector<Real> goalSpeeds_;
+  std::vector<Real> maxSpeeds_;
+  std::vector<Real> neighborDists_;
+  std::vector<Real> radii_;
+  std::vector<Real> timeHorizons_;
+  std::vector<Real> timeHorizonObsts_;
+  std::vector<bool> hasGoals_;
+
+  friend class Agent;
+  friend class KdTree;
+  friend class RVOSimulator;
+};
+} /* namespace RVO */
+
+#endif /* RVO_AGENT_STORE_H_ */
@@ -0,0 +1,65 @@
+/*
+ * Clock.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_CLOCK_H_
+#define RVO_CLOCK_H_
+
+/**
+ * @file  Clock.h
+ * @brief Declares the monotonic clock that times the phases of a simulation
+ *        step.
+ */
+
+namespace RVO {
+/**
+ * @brief  Returns the time of a monotonic clock.
+ * @return The time in seconds since an unspecified epoch.
+ */
+double getClockTime();
+
+/**
+ * @brief          Returns the time elapsed since a previous time and advances
+ *                 that time to the present.
+ * @param[in, out] time The previous time, advanced to the present time.
+ * @return         The time elapsed in seconds.
+ */
+inline double lapClockTime(double *time) {
+  const double now = getClockTime();
+  const double lap = now - *time;
+  *time = now;
+
+  return lap;
+}
+} /* namespace RVO */
+
+#endif /* RVO_CLOCK_H_ */
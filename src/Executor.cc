@@ -0,0 +1,511 @@
+/*
+ * Executor.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  Executor.cc
+ * @brief Defines the Executor and DefaultExecutor classes.
+ */
+
+#include "Executor.h"
+
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+namespace RVO {
+namespace {
+/**
+ * @relates DefaultExecutor
+ * @brief   Returns the count of threads that a default executor runs by
+ *          default.
+ * @return  The maximum count of OpenMP threads when the library is built with
+ *          OpenMP, and the count of processors otherwise.
+ */
+std::size_t getDefaultNumThreads() {
+#if defined(_OPENMP)
+  return static_cast<std::size_t>(omp_get_max_threads());
+#elif defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+
+  return static_cast<std::size_t>(info.dwNumberOfProcessors);
+#else
+  const long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return numProcessors > 0L ? static_cast<std::size_t>(numProcessors) : 1U;
+#endif /* _OPENMP */
+}
+} /* namespace */
+
+/**
+ * @brief Defines the pool of threads of a default executor. Thread zero is the
+ *        thread that waits for a task, and the others are started by the
+ *        pool.
+ */
+class DefaultExecutor::Pool {
+ public:
+  /**
+   * @brief     Constructs a pool instance and starts its threads.
+   * @param[in] numThreads The count of threads, including the calling thread.
+   */
+  explicit Pool(std::size_t numThreads);
+
+  /**
+   * @brief Destroys this pool instance and stops its threads.
+   */
+  ~Pool();
+
+  /**
+   * @brief Runs the items of the present task that no thread has taken yet on
+   *        the calling thread, and waits until every item has completed.
+   */
+  void complete();
+
+  /**
+   * @brief  Returns whether every item of the present task has completed.
+   * @return True if every item of the present task has completed; false
+   *         otherwise.
+   */
+  bool isComplete();
+
+  /**
+   * @brief     Hands the items of a task to the threads of this pool and
+   *            returns before they have completed.
+   * @param[in] task     The task whose items are to be run.
+   * @param[in] numItems The count of items of the task.
+   */
+  void submit(Task &task, std::size_t numItems);
+
+ private:
+  /**
+   * @brief Defines a thread started by a pool.
+   */
+  class Worker {
+   public:
+    /**
+     * @brief The pool of the thread.
+     */
+    Pool *pool;
+
+    /**
+     * @brief The number of the thread in its pool.
+     */
+    std::size_t threadNo;
+
+#ifdef _WIN32
+    /**
+     * @brief The handle of the thread.
+     */
+    HANDLE thread;
+#else
+    /**
+     * @brief The handle of the thread.
+     */
+    pthread_t thread;
+#endif /* _WIN32 */
+  };
+
+  /**
+   * @brief      Takes the next item of the present task for a thread with the
+   *             mutex of this pool locked. A thread whose own items have all
+   *             been taken steals the later half of the items left to the
+   *             thread with the most.
+   * @param[in]  threadNo The number of the thread.
+   * @param[out] item     The item taken.
+   * @return     Whether an item was taken.
+   */
+  bool claimItem(std::size_t threadNo, std::size_t *item);
+
+  /**
+   * @brief Locks the mutex of this pool.
+   */
+  void lock();
+
+  /**
+   * @brief Wakes the threads waiting for the condition of this pool.
+   */
+  void notify();
+
+  /**
+   * @brief     Runs items of the present task on a thread until none are left
+   *            to be taken, with the mutex of this pool locked.
+   * @param[in] threadNo The number of the thread.
+   */
+  void runItems(std::size_t threadNo);
+
+#ifdef _WIN32
+  /**
+   * @brief     Runs a thread of a pool.
+   * @param[in] worker The worker of the thread.
+   * @return    Zero.
+   */
+  static DWORD WINAPI runThread(LPVOID worker);
+#else
+  /**
+   * @brief     Runs a thread of a pool.
+   * @param[in] worker The worker of the thread.
+   * @return    NULL.
+   */
+  static void *runThread(void *worker);
+#endif /* _WIN32 */
+
+  /**
+   * @brief Unlocks the mutex of this pool.
+   */
+  void unlock();
+
+  /**
+   * @brief Waits for the condition of this pool with its mutex locked.
+   */
+  void wait();
+
+  /**
+   * @brief     Runs the items of each task submitted to this pool on one of its
+   *            threads until the pool is destroyed.
+   * @param[in] threadNo The number of the thread.
+   */
+  void work(std::size_t threadNo);
+
+  /* Not implemented. */
+  Pool(const Pool &other);
+
+  /* Not implemented. */
+  Pool &operator=(const Pool &other);
+
+  std::vector<Worker> workers_;
+  std::vector<std::size_t> begins_;
+  std::vector<std::size_t> ends_;
+  Task *task_;
+  std::size_t numPending_;
+  std::size_t taskNo_;
+#ifdef _WIN32
+  CONDITION_VARIABLE condition_;
+  CRITICAL_SECTION mutex_;
+#else
+  pthread_cond_t condition_;
+  pthread_mutex_t mutex_;
+#endif /* _WIN32 */
+  bool isDone_;
+};
+
+DefaultExecutor::Pool::Pool(std::size_t numThreads)
+    : workers_(numThreads - 1U),
+      begins_(numThreads),
+      ends_(numThreads),
+      task_(NULL),
+      numPending_(0U),
+      taskNo_(0U),
+      isDone_(false) {
+#ifdef _WIN32
+  InitializeConditionVariable(&condition_);
+  InitializeCriticalSection(&mutex_);
+#else
+  pthread_cond_init(&condition_, NULL);
+  pthread_mutex_init(&mutex_, NULL);
+#endif /* _WIN32 */
+
+  /* The items of a thread that fails to start are stolen by the others, so
+   * the pool only runs with fewer threads. */
+  std::size_t numStarted = 0U;
+
+  for (std::size_t i = 0U; i < workers_.size(); ++i) {
+    Worker &worker = workers_[numStarted];
+    worker.pool = this;
+    worker.threadNo = i + 1U;
+#ifdef _WIN32
+    worker.thread =
+        CreateThread(NULL, 0U, &Pool::runThread, &worker, 0U, NULL);
+
+    if (worker.thread != NULL) {
+      ++numStarted;
+    }
+#else
+    if (pthread_create(&worker.thread, NULL, &Pool::runThread, &worker) == 0) {
+      ++numStarted;
+    }
+#endif /* _WIN32 */
+  }
+
+  /* The workers are not reallocated, since their threads refer to them. */
+  workers_.erase(workers_.begin() + static_cast<std::ptrdiff_t>(numStarted),
+                 workers_.end());
+}
+
+DefaultExecutor::Pool::~Pool() {
+  lock();
+  isDone_ = true;
+  notify();
+  unlock();
+
+  for (std::size_t i = 0U; i < workers_.size(); ++i) {
+#ifdef _WIN32
+    WaitForSingleObject(workers_[i].thread, INFINITE);
+    CloseHandle(workers_[i].thread);
+#else
+    pthread_join(workers_[i].thread, NULL);
+#endif /* _WIN32 */
+  }
+
+#ifdef _WIN32
+  DeleteCriticalSection(&mutex_);
+#else
+  pthread_cond_destroy(&condition_);
+  pthread_mutex_destroy(&mutex_);
+#endif /* _WIN32 */
+}
+
+bool DefaultExecutor::Pool::claimItem(std::size_t threadNo,
+                                      std::size_t *item) {
+  if (begins_[threadNo] == ends_[threadNo]) {
+    std::size_t victimNo = threadNo;
+    std::size_t numLeft = 0U;
+
+    for (std::size_t i = 0U; i < begins_.size(); ++i) {
+      if (ends_[i] - begins_[i] > numLeft) {
+        victimNo = i;
+        numLeft = ends_[i] - begins_[i];
+      }
+    }
+
+    if (numLeft == 0U) {
+      return false;
+    }
+
+    /* The victim keeps the earlier half, so that it goes on with the items
+     * next to the one it is running. */
+    begins_[threadNo] = ends_[victimNo] - (numLeft + 1U) / 2U;
+    ends_[threadNo] = ends_[victimNo];
+    ends_[victimNo] = begins_[threadNo];
+  }
+
+  *item = begins_[threadNo]++;
+
+  return true;
+}
+
+void DefaultExecutor::Pool::complete() {
+  lock();
+  runItems(0U);
+
+  while (numPending_ != 0U) {
+    wait();
+  }
+
+  unlock();
+}
+
+bool DefaultExecutor::Pool::isComplete() {
+  lock();
+  const bool isComplete = numPending_ == 0U;
+  unlock();
+
+  return isComplete;
+}
+
+void DefaultExecutor::Pool::lock() {
+#ifdef _WIN32
+  EnterCriticalSection(&mutex_);
+#else
+  pthread_mutex_lock(&mutex_);
+#endif /* _WIN32 */
+}
+
+void DefaultExecutor::Pool::notify() {
+#ifdef _WIN32
+  WakeAllConditionVariable(&condition_);
+#else
+  pthread_cond_broadcast(&condition_);
+#endif /* _WIN32 */
+}
+
+void DefaultExecutor::Pool::runItems(std::size_t threadNo) {
+  std::size_t item = 0U;
+
+  while (claimItem(threadNo, &item)) {
+    unlock();
+    task_->run(item);
+    lock();
+
+    if (--numPending_ == 0U) {
+      notify();
+    }
+  }
+}
+
+#ifdef _WIN32
+DWORD WINAPI DefaultExecutor::Pool::runThread(LPVOID worker) {
+  static_cast<Worker *>(worker)->pool->work(
+      static_cast<Worker *>(worker)->threadNo);
+
+  return 0U;
+}
+#else
+void *DefaultExecutor::Pool::runThread(void *worker) {
+  static_cast<Worker *>(worker)->pool->work(
+      static_cast<Worker *>(worker)->threadNo);
+
+  return NULL;
+}
+#endif /* _WIN32 */
+
+void DefaultExecutor::Pool::submit(Task &task, std::size_t numItems) {
+  lock();
+
+  /* The items of the previous task are only read while it is pending. */
+  while (numPending_ != 0U) {
+    wait();
+  }
+
+  task_ = &task;
+  numPending_ = numItems;
+  ++taskNo_;
+
+  for (std::size_t i = 0U; i < begins_.size(); ++i) {
+    begins_[i] = numItems * i / begins_.size();
+    ends_[i] = numItems * (i + 1U) / begins_.size();
+  }
+
+  notify();
+  unlock();
+}
+
+void DefaultExecutor::Pool::unlock() {
+#ifdef _WIN32
+  LeaveCriticalSection(&mutex_);
+#else
+  pthread_mutex_unlock(&mutex_);
+#endif /* _WIN32 */
+}
+
+void DefaultExecutor::Pool::wait() {
+#ifdef _WIN32
+  SleepConditionVariableCS(&condition_, &mutex_, INFINITE);
+#else
+  pthread_cond_wait(&condition_, &mutex_);
+#endif /* _WIN32 */
+}
+
+void DefaultExecutor::Pool::work(std::size_t threadNo) {
+  std::size_t taskNo = 0U;
+  lock();
+
+  while (true) {
+    while (taskNo == taskNo_ && !isDone_) {
+      wait();
+    }
+
+    if (isDone_) {
+      break;
+    }
+
+    taskNo = taskNo_;
+    runItems(threadNo);
+  }
+
+  unlock();
+}
+
+Executor::Task::Task() {}
+
+Executor::Task::~Task() {}
+
+Executor::Executor() {}
+
+Executor::~Executor() {}
+
+bool Executor::isComplete() const { return true; }
+
+void Executor::submit(Task &task, std::size_t numItems) {
+  run(task, numItems);
+}
+
+void Executor::wait() {}
+
+DefaultExecutor::DefaultExecutor()
+    : pool_(NULL), numThreads_(getDefaultNumThreads()) {}
+
+DefaultExecutor::DefaultExecutor(std::size_t numThreads)
+    : pool_(NULL), numThreads_(numThreads > 1U ? numThreads : 1U) {}
+
+DefaultExecutor::~DefaultExecutor() { delete pool_; }
+
+bool DefaultExecutor::isComplete() const {
+  return pool_ == NULL || pool_->isComplete();
+}
+
+void DefaultExecutor::run(Task &task, std::size_t numItems) {
+  if (numThreads_ == 1U || numItems < 2U) {
+    for (std::size_t i = 0U; i < numItems; ++i) {
+      task.run(i);
+    }
+
+    return;
+  }
+
+  submit(task, numItems);
+  wait();
+}
+
+void DefaultExecutor::submit(Task &task, std::size_t numItems) {
+  if (numThreads_ == 1U) {
+    for (std::size_t i = 0U; i < numItems; ++i) {
+      task.run(i);
+    }
+
+    return;
+  }
+
+  /* The threads are only started once a task is submitted, so that
+   * simulators that are never stepped do not hold idle threads. */
+  if (pool_ == NULL) {
+    pool_ = new Pool(numThreads_);
+  }
+
+  pool_->submit(task, numItems);
+}
+
+void DefaultExecutor::wait() {
+  if (pool_ != NULL) {
+    pool_->complete();
+  }
+}
+} /* namespace RVO */
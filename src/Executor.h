@@ -0,0 +1,233 @@
+/*
+ * Executor.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_EXECUTOR_H_
+#define RVO_EXECUTOR_H_
+
+/**
+ * @file  Executor.h
+ * @brief Declares the Executor and DefaultExecutor classes.
+ */
+
+#include <cstddef>
+
+#include "Export.h"
+
+namespace RVO {
+/**
+ * @brief Defines an executor that runs the items of the tasks of a simulation
+ *        step, possibly in parallel. An application that has its own job
+ *        system may derive from this class to dispatch the items to it.
+ */
+class RVO_EXPORT Executor {
+ public:
+  /**
+   * @brief Defines a task of a simulation step that consists of independent
+   *        items.
+   */
+  class RVO_EXPORT Task {
+   public:
+    /**
+     * @brief Destroys this task instance.
+     */
+    virtual ~Task();
+
+    /**
+     * @brief     Runs an item of this task. Distinct items may be run
+     *            concurrently and in any order.
+     * @param[in] item The number of the item to be run.
+     */
+    virtual void run(std::size_t item) = 0;
+
+   protected:
+    /**
+     * @brief Constructs a task instance.
+     */
+    Task();
+
+   private:
+    /* Not implemented. */
+    Task(const Task &other);
+
+    /* Not implemented. */
+    Task &operator=(const Task &other);
+  };
+
+  /**
+   * @brief Destroys this executor instance.
+   */
+  virtual ~Executor();
+
+  /**
+   * @brief  Returns the count of threads on which this executor runs items.
+   *         The simulation divides its work into a multiple of this count of
+   *         items.
+   * @return The count of threads on which this executor runs items.
+   */
+  virtual std::size_t getNumThreads() const = 0;
+
+  /**
+   * @brief  Returns whether every item of the task most recently submitted
+   *         has completed.
+   * @return True if every item of the task most recently submitted has
+   *         completed; false otherwise. The default implementation returns
+   *         true, as its submit() completes every item before it returns.
+   */
+  virtual bool isComplete() const;
+
+  /**
+   * @brief     Runs every item of a task and returns once all of them have
+   *            completed.
+   * @param[in] task     The task whose items are to be run.
+   * @param[in] numItems The count of items of the task.
+   */
+  virtual void run(Task &task, std::size_t numItems) = 0;
+
+  /**
+   * @brief     Starts to run every item of a task and may return before all of
+   *            them have completed. At most one task is submitted at a time,
+   *            and the task remains valid until wait() has returned.
+   * @param[in] task     The task whose items are to be run.
+   * @param[in] numItems The count of items of the task.
+   * @note      The default implementation calls run(). An executor that
+   *            overrides this function to return early lets the application
+   *            work while a simulation step started by
+   *            RVOSimulator::doStepAsync() is computed.
+   */
+  virtual void submit(Task &task, std::size_t numItems);
+
+  /**
+   * @brief Waits until every item of the task most recently submitted has
+   *        completed. The default implementation returns immediately.
+   */
+  virtual void wait();
+
+ protected:
+  /**
+   * @brief Constructs an executor instance.
+   */
+  Executor();
+
+ private:
+  /* Not implemented. */
+  Executor(const Executor &other);
+
+  /* Not implemented. */
+  Executor &operator=(const Executor &other);
+};
+
+/**
+ * @brief Defines the executor that the simulation uses unless another is set.
+ *        The items are run by a persistent pool of threads, started when the
+ *        first task is submitted, and by the thread that waits for the task.
+ *        The items are first divided evenly among the threads, and a thread
+ *        that runs out of items steals half of the items left to the busiest
+ *        other thread. A task submitted returns without waiting for its
+ *        items, so that the application may work while they are run.
+ */
+class RVO_EXPORT DefaultExecutor : public Executor {
+ public:
+  /**
+   * @brief Constructs a default executor instance with one thread per
+   *        processor, or the maximum count of OpenMP threads when the library
+   *        is built with OpenMP.
+   */
+  DefaultExecutor();
+
+  /**
+   * @brief     Constructs a default executor instance with a specified count of
+   *            threads.
+   * @param[in] numThreads The count of threads, including the calling thread.
+   *                       One runs the items serially without starting any
+   *                       thread.
+   */
+  explicit DefaultExecutor(std::size_t numThreads);
+
+  /**
+   * @brief Destroys this default executor instance and stops its threads.
+   */
+  virtual ~DefaultExecutor();
+
+  /**
+   * @brief  Returns the count of threads on which this executor runs items.
+   * @return The count of threads on which this executor runs items, including
+   *         the calling thread.
+   */
+  virtual std::size_t getNumThreads() const { return numThreads_; }
+
+  /**
+   * @brief  Returns whether every item of the task most recently submitted
+   *         has completed.
+   * @return True if every item of the task most recently submitted has
+   *         completed; false otherwise.
+   */
+  virtual bool isComplete() const;
+
+  /**
+   * @brief     Runs every item of a task and returns once all of them have
+   *            completed.
+   * @param[in] task     The task whose items are to be run.
+   * @param[in] numItems The count of items of the task.
+   */
+  virtual void run(Task &task, std::size_t numItems);
+
+  /**
+   * @brief     Hands the items of a task to the threads of the pool and returns
+   *            before they have completed. With one thread, the items are run
+   *            before it returns.
+   * @param[in] task     The task whose items are to be run.
+   * @param[in] numItems The count of items of the task.
+   */
+  virtual void submit(Task &task, std::size_t numItems);
+
+  /**
+   * @brief Waits until every item of the task most recently submitted has
+   *        completed, running the items that no thread has taken yet.
+   */
+  virtual void wait();
+
+ private:
+  class Pool;
+
+  /* Not implemented. */
+  DefaultExecutor(const DefaultExecutor &other);
+
+  /* Not implemented. */
+  DefaultExecutor &operator=(const DefaultExecutor &other);
+
+  Pool *pool_;
+  std::size_t numThreads_;
+};
+} /* namespace RVO */
+
+#endif /* RVO_EXECUTOR_H_ */
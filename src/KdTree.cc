@@ -39,20 +39,222 @@
 #include "KdTree.h"
 
 #include <algorithm>
+#include <limits>
 #include <utility>
 
 #include "Agent.h"
+#include "AgentStore.h"
 #include "Obstacle.h"
 #include "RVOSimulator.h"
+#include "Snapshot.h"
 #include "Vector2.h"
 
+#if RVO_ENABLE_STATISTICS
+#include "StepStatistics.h"
+#endif /* RVO_ENABLE_STATISTICS */
+
+#if defined(_OPENMP) && _OPENMP >= 200805
+/* Explicit tasks require OpenMP 3.0 or later. */
+#define RVO_OPENMP_TASKS 1
+#endif /* _OPENMP */
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define RVO_SIMD_AVX 1
+#elif RVO_USE_DOUBLE
+/* Double-precision vectors require SSE2, or NEON on AArch64. */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RVO_SIMD_SSE 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RVO_SIMD_NEON 1
+#endif /* __SSE2__ */
+#elif defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RVO_SIMD_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RVO_SIMD_NEON 1
+#endif /* __AVX__ */
+
+#ifndef RVO_AGENT_TREE_LEAF_SIZE
+/* Leaf sizes that are a multiple of the SIMD width avoid a scalar tail in the
+ * leaf scan. */
+#define RVO_AGENT_TREE_LEAF_SIZE 10U
+#endif /* RVO_AGENT_TREE_LEAF_SIZE */
+
 namespace RVO {
 namespace {
 /**
  * @relates KdTree
  * @brief   The maximum k-D tree node leaf size.
  */
-const std::size_t RVO_MAX_LEAF_SIZE = 10U;
+const std::size_t RVO_MAX_LEAF_SIZE = RVO_AGENT_TREE_LEAF_SIZE;
+
+/**
+ * @relates KdTree
+ * @brief   The factor by which the half-perimeter of the bounding box of an
+ *          agent k-D tree node may grow from when it was built before the
+ *          subtree is rebuilt when refitting.
+ */
+const Real RVO_AGENT_TREE_REFIT_GROWTH = 1.5F;
+
+/**
+ * @relates KdTree
+ * @brief   The count of agents processed by each task when computing the
+ *          bounding box of, or partitioning, an agent k-D tree node in
+ *          parallel.
+ */
+const std::size_t RVO_AGENT_TREE_CHUNK_SIZE = 4096U;
+
+#ifdef RVO_OPENMP_TASKS
+/**
+ * @relates KdTree
+ * @brief   The minimum size of an agent k-D tree node whose bounding box and
+ *          partition are computed in parallel.
+ */
+const std::size_t RVO_MIN_PARALLEL_PARTITION_SIZE =
+    8U * RVO_AGENT_TREE_CHUNK_SIZE;
+
+/**
+ * @relates KdTree
+ * @brief   The minimum size of an agent k-D subtree that is built by a
+ *          separate task.
+ */
+const std::size_t RVO_MIN_AGENT_SUBTREE_TASK_SIZE = 1024U;
+#else
+/* Without tasks, every agent k-D tree node is built serially. */
+const std::size_t RVO_MIN_PARALLEL_PARTITION_SIZE =
+    std::numeric_limits<std::size_t>::max();
+#endif /* RVO_OPENMP_TASKS */
+
+/**
+ * @relates KdTree
+ * @brief   The minimum count of obstacles of an obstacle k-D tree node whose
+ *          split candidates are evaluated in parallel.
+ */
+const std::size_t RVO_MIN_PARALLEL_OBSTACLE_SPLIT_SIZE = 1024U;
+
+/**
+ * @relates KdTree
+ * @brief   The number denoting the absence of an obstacle k-D tree node.
+ */
+const std::size_t RVO_NO_OBSTACLE_TREE_NODE =
+    std::numeric_limits<std::size_t>::max();
+
+/**
+ * @relates KdTree
+ * @brief   The maximum count of obstacle edges of a dynamic obstacle k-D tree
+ *          leaf node.
+ */
+const std::size_t RVO_MAX_DYNAMIC_OBSTACLE_LEAF_SIZE = 8U;
+
+#if defined(RVO_SIMD_AVX) || defined(RVO_SIMD_SSE) || defined(RVO_SIMD_NEON)
+/**
+ * @relates KdTree
+ * @brief   The count of agents whose distances are computed at once when
+ *          scanning an agent k-D tree leaf.
+ */
+#ifdef RVO_SIMD_AVX
+const std::size_t RVO_SIMD_WIDTH = 32U / sizeof(Real);
+#else
+const std::size_t RVO_SIMD_WIDTH = 16U / sizeof(Real);
+#endif /* RVO_SIMD_AVX */
+#else
+const std::size_t RVO_SIMD_WIDTH = 1U;
+#endif /* RVO_SIMD_AVX || RVO_SIMD_SSE || RVO_SIMD_NEON */
+
+/**
+ * @relates    KdTree
+ * @brief      Computes the squared distances from a point to RVO_SIMD_WIDTH
+ *             consecutive agents of an agent k-D tree leaf.
+ * @param[in]  agentsX The x-coordinates of the agents.
+ * @param[in]  agentsY The y-coordinates of the agents.
+ * @param[in]  x       The x-coordinate of the point.
+ * @param[in]  y       The y-coordinate of the point.
+ * @param[in]  rangeSq The squared range around the point.
+ * @param[out] distSq  The squared distances from the point to the agents.
+ * @return     A bit mask of the agents within the range.
+ */
+inline unsigned int computeLeafDistSq(const Real *agentsX,
+                                      const Real *agentsY, Real x, Real y,
+                                      Real rangeSq, Real *distSq) {
+#if defined(RVO_SIMD_AVX) && RVO_USE_DOUBLE
+  const __m256d distX =
+      _mm256_sub_pd(_mm256_set1_pd(x), _mm256_loadu_pd(agentsX));
+  const __m256d distY =
+      _mm256_sub_pd(_mm256_set1_pd(y), _mm256_loadu_pd(agentsY));
+  const __m256d result = _mm256_add_pd(_mm256_mul_pd(distX, distX),
+                                       _mm256_mul_pd(distY, distY));
+  _mm256_storeu_pd(distSq, result);
+
+  return static_cast<unsigned int>(_mm256_movemask_pd(
+      _mm256_cmp_pd(result, _mm256_set1_pd(rangeSq), _CMP_LT_OQ)));
+#elif defined(RVO_SIMD_AVX)
+  const __m256 distX =
+      _mm256_sub_ps(_mm256_set1_ps(x), _mm256_loadu_ps(agentsX));
+  const __m256 distY =
+      _mm256_sub_ps(_mm256_set1_ps(y), _mm256_loadu_ps(agentsY));
+  const __m256 result = _mm256_add_ps(_mm256_mul_ps(distX, distX),
+                                      _mm256_mul_ps(distY, distY));
+  _mm256_storeu_ps(distSq, result);
+
+  return static_cast<unsigned int>(_mm256_movemask_ps(
+      _mm256_cmp_ps(result, _mm256_set1_ps(rangeSq), _CMP_LT_OQ)));
+#elif defined(RVO_SIMD_SSE) && RVO_USE_DOUBLE
+  const __m128d distX = _mm_sub_pd(_mm_set1_pd(x), _mm_loadu_pd(agentsX));
+  const __m128d distY = _mm_sub_pd(_mm_set1_pd(y), _mm_loadu_pd(agentsY));
+  const __m128d result =
+      _mm_add_pd(_mm_mul_pd(distX, distX), _mm_mul_pd(distY, distY));
+  _mm_storeu_pd(distSq, result);
+
+  return static_cast<unsigned int>(
+      _mm_movemask_pd(_mm_cmplt_pd(result, _mm_set1_pd(rangeSq))));
+#elif defined(RVO_SIMD_SSE)
+  const __m128 distX = _mm_sub_ps(_mm_set1_ps(x), _mm_loadu_ps(agentsX));
+  const __m128 distY = _mm_sub_ps(_mm_set1_ps(y), _mm_loadu_ps(agentsY));
+  const __m128 result =
+      _mm_add_ps(_mm_mul_ps(distX, distX), _mm_mul_ps(distY, distY));
+  _mm_storeu_ps(distSq, result);
+
+  return static_cast<unsigned int>(
+      _mm_movemask_ps(_mm_cmplt_ps(result, _mm_set1_ps(rangeSq))));
+#elif defined(RVO_SIMD_NEON) && RVO_USE_DOUBLE
+  const float64x2_t distX = vsubq_f64(vdupq_n_f64(x), vld1q_f64(agentsX));
+  const float64x2_t distY = vsubq_f64(vdupq_n_f64(y), vld1q_f64(agentsY));
+  const float64x2_t result =
+      vaddq_f64(vmulq_f64(distX, distX), vmulq_f64(distY, distY));
+  vst1q_f64(distSq, result);
+
+  const uint64x2_t less = vcltq_f64(result, vdupq_n_f64(rangeSq));
+
+  return static_cast<unsigned int>((vgetq_lane_u64(less, 0) & 1U) |
+                                   (vgetq_lane_u64(less, 1) & 2U));
+#elif defined(RVO_SIMD_NEON)
+  const float32x4_t distX = vsubq_f32(vdupq_n_f32(x), vld1q_f32(agentsX));
+  const float32x4_t distY = vsubq_f32(vdupq_n_f32(y), vld1q_f32(agentsY));
+  /* Separate multiplies and an add, rather than a fused multiply-add, give
+   * the same distances as the scalar path. */
+  const float32x4_t result =
+      vaddq_f32(vmulq_f32(distX, distX), vmulq_f32(distY, distY));
+  vst1q_f32(distSq, result);
+
+  const uint32x4_t less = vcltq_f32(result, vdupq_n_f32(rangeSq));
+
+  return static_cast<unsigned int>(
+      (vgetq_lane_u32(less, 0) & 1U) | (vgetq_lane_u32(less, 1) & 2U) |
+      (vgetq_lane_u32(less, 2) & 4U) | (vgetq_lane_u32(less, 3) & 8U));
+#else
+  const Real distX = x - agentsX[0U];
+  const Real distY = y - agentsY[0U];
+  distSq[0U] = distX * distX + distY * distY;
+
+  return distSq[0U] < rangeSq ? 1U : 0U;
+#endif /* RVO_SIMD_AVX */
+}
 } /* namespace */
 
 /**
@@ -88,22 +290,28 @@ class KdTree::AgentTreeNode {
   /**
    * @brief The maximum x-coordinate.
    */
-  float maxX;
+  Real maxX;
 
   /**
    * @brief The maximum y-coordinate.
    */
-  float maxY;
+  Real maxY;
 
   /**
    * @brief The minimum x-coordinate.
    */
-  float minX;
+  Real minX;
 
   /**
    * @brief The minimum y-coordinate.
    */
-  float minY;
+  Real minY;
+
+  /**
+   * @brief The half-perimeter of the bounding box beyond which the subtree is
+   *        rebuilt when refitting.
+   */
+  Real refitLimit;
 };
 
 KdTree::AgentTreeNode::AgentTreeNode()
@@ -114,10 +322,12 @@ KdTree::AgentTreeNode::AgentTreeNode()
       maxX(0.0F),
       maxY(0.0F),
       minX(0.0F),
-      minY(0.0F) {}
+      minY(0.0F),
+      refitLimit(0.0F) {}
 
 /**
- * @brief Defines an obstacle k-D tree node.
+ * @brief Defines an obstacle k-D tree node. The endpoints of the obstacle edge
+ *        are stored in the node so that queries need not follow the obstacle.
  */
 class KdTree::ObstacleTreeNode {
  public:
@@ -127,170 +337,416 @@ class KdTree::ObstacleTreeNode {
   ObstacleTreeNode();
 
   /**
-   * @brief Destroys this obstacle k-D tree node instance.
+   * @brief The first endpoint of the obstacle edge.
    */
-  ~ObstacleTreeNode();
+  Vector2 point1;
 
   /**
-   * @brief The obstacle number.
+   * @brief The second endpoint of the obstacle edge.
    */
-  const Obstacle *obstacle;
+  Vector2 point2;
 
   /**
-   * @brief The left obstacle tree node.
+   * @brief The inverse of the squared length of the obstacle edge.
    */
-  ObstacleTreeNode *left;
+  Real invLengthSq;
 
   /**
-   * @brief The right obstacle tree node.
+   * @brief The obstacle number.
    */
-  ObstacleTreeNode *right;
+  const Obstacle *obstacle;
 
- private:
-  /* Not implemented. */
-  ObstacleTreeNode(const ObstacleTreeNode &other);
+  /**
+   * @brief The left obstacle tree node number.
+   */
+  std::size_t left;
 
-  /* Not implemented. */
-  ObstacleTreeNode &operator=(const ObstacleTreeNode &other);
+  /**
+   * @brief The right obstacle tree node number.
+   */
+  std::size_t right;
 };
 
 KdTree::ObstacleTreeNode::ObstacleTreeNode()
-    : obstacle(NULL), left(NULL), right(NULL) {}
+    : invLengthSq(0.0F),
+      obstacle(NULL),
+      left(RVO_NO_OBSTACLE_TREE_NODE),
+      right(RVO_NO_OBSTACLE_TREE_NODE) {}
+
+/**
+ * @brief Defines a dynamic obstacle k-D tree node. Each node bounds the
+ *        obstacle edges of its range of dynamic obstacles.
+ */
+class KdTree::DynamicObstacleTreeNode {
+ public:
+  /**
+   * @brief Constructs a dynamic obstacle k-D tree node instance.
+   */
+  DynamicObstacleTreeNode();
+
+  /**
+   * @brief The beginning node number.
+   */
+  std::size_t begin;
+
+  /**
+   * @brief The ending node number.
+   */
+  std::size_t end;
+
+  /**
+   * @brief The left node number.
+   */
+  std::size_t left;
 
-KdTree::ObstacleTreeNode::~ObstacleTreeNode() {}
+  /**
+   * @brief The right node number.
+   */
+  std::size_t right;
+
+  /**
+   * @brief The maximum x-coordinate.
+   */
+  Real maxX;
+
+  /**
+   * @brief The maximum y-coordinate.
+   */
+  Real maxY;
+
+  /**
+   * @brief The minimum x-coordinate.
+   */
+  Real minX;
+
+  /**
+   * @brief The minimum y-coordinate.
+   */
+  Real minY;
+};
+
+KdTree::DynamicObstacleTreeNode::DynamicObstacleTreeNode()
+    : begin(0U),
+      end(0U),
+      left(0U),
+      right(0U),
+      maxX(0.0F),
+      maxY(0.0F),
+      minX(0.0F),
+      minY(0.0F) {}
 
 KdTree::KdTree(RVOSimulator *simulator)
-    : obstacleTree_(NULL), simulator_(simulator) {}
+    : simulator_(simulator), stepsSinceAgentTreeBuild_(0U) {}
+
+KdTree::~KdTree() {}
+
+void KdTree::addDynamicObstacle(const Obstacle *obstacle) {
+  const Obstacle *vertex = obstacle;
 
-KdTree::~KdTree() { deleteObstacleTree(obstacleTree_); }
+  do {
+    dynamicObstacles_.push_back(vertex);
+    vertex = vertex->next_;
+  } while (vertex != obstacle);
+
+  buildDynamicObstacleTree();
+}
 
 void KdTree::buildAgentTree() {
-  if (agents_.size() < simulator_->agents_.size()) {
-    agents_.insert(agents_.end(),
-                   simulator_->agents_.begin() +
-                       static_cast<std::ptrdiff_t>(agents_.size()),
-                   simulator_->agents_.end());
-    agentTree_.resize(2U * agents_.size() - 1U);
+  const std::size_t numAgents = simulator_->agentStore_->size();
+
+  if (agents_.size() != numAgents) {
+    if (agents_.size() > numAgents) {
+      /* Agents have been removed, and the others moved into their slots. */
+      agents_.clear();
+    }
+
+    for (std::size_t i = agents_.size(); i < numAgents; ++i) {
+      agents_.push_back(i);
+    }
+
+    agentTree_.resize(agents_.empty() ? 0U : 2U * agents_.size() - 1U);
+    agentsBuffer_.resize(agents_.size());
+    agentsX_.resize(agents_.size());
+    agentsY_.resize(agents_.size());
   }
 
   if (!agents_.empty()) {
+    /* Subtrees are built by tasks of a single team. The implicit barrier at
+     * the end of the single construct waits for all of them. */
+#ifdef RVO_OPENMP_TASKS
+#pragma omp parallel if (agents_.size() >= RVO_MIN_AGENT_SUBTREE_TASK_SIZE)
+#pragma omp single
+#endif /* RVO_OPENMP_TASKS */
     buildAgentTreeRecursive(0U, agents_.size(), 0U);
   }
+
+  stepsSinceAgentTreeBuild_ = 0U;
 }
 
 void KdTree::buildAgentTreeRecursive(std::size_t begin, std::size_t end,
                                      std::size_t node) {
+  const std::vector<Vector2> &positions = simulator_->agentStore_->positions_;
+
   agentTree_[node].begin = begin;
   agentTree_[node].end = end;
-  agentTree_[node].minX = agentTree_[node].maxX = agents_[begin]->position_.x();
-  agentTree_[node].minY = agentTree_[node].maxY = agents_[begin]->position_.y();
 
-  for (std::size_t i = begin + 1U; i < end; ++i) {
-    agentTree_[node].maxX =
-        std::max(agentTree_[node].maxX, agents_[i]->position_.x());
-    agentTree_[node].minX =
-        std::min(agentTree_[node].minX, agents_[i]->position_.x());
-    agentTree_[node].maxY =
-        std::max(agentTree_[node].maxY, agents_[i]->position_.y());
-    agentTree_[node].minY =
-        std::min(agentTree_[node].minY, agents_[i]->position_.y());
+  if (end - begin >= RVO_MIN_PARALLEL_PARTITION_SIZE) {
+    computeAgentTreeBoundsParallel(node);
+  } else {
+    agentTree_[node].minX = agentTree_[node].maxX =
+        positions[agents_[begin]].x();
+    agentTree_[node].minY = agentTree_[node].maxY =
+        positions[agents_[begin]].y();
+
+    for (std::size_t i = begin + 1U; i < end; ++i) {
+      agentTree_[node].maxX =
+          std::max(agentTree_[node].maxX, positions[agents_[i]].x());
+      agentTree_[node].minX =
+          std::min(agentTree_[node].minX, positions[agents_[i]].x());
+      agentTree_[node].maxY =
+          std::max(agentTree_[node].maxY, positions[agents_[i]].y());
+      agentTree_[node].minY =
+          std::min(agentTree_[node].minY, positions[agents_[i]].y());
+    }
   }
 
+  agentTree_[node].refitLimit =
+      RVO_AGENT_TREE_REFIT_GROWTH *
+      (agentTree_[node].maxX - agentTree_[node].minX + agentTree_[node].maxY -
+       agentTree_[node].minY);
+
   if (end - begin > RVO_MAX_LEAF_SIZE) {
     /* No leaf node. */
     const bool isVertical = agentTree_[node].maxX - agentTree_[node].minX >
                             agentTree_[node].maxY - agentTree_[node].minY;
-    const float splitValue =
+    const Real splitValue =
         0.5F * (isVertical ? agentTree_[node].maxX + agentTree_[node].minX
                            : agentTree_[node].maxY + agentTree_[node].minY);
 
     std::size_t left = begin;
-    std::size_t right = end;
 
-    while (left < right) {
-      while (left < right &&
-             (isVertical ? agents_[left]->position_.x()
-                         : agents_[left]->position_.y()) < splitValue) {
-        ++left;
-      }
+    if (end - begin >= RVO_MIN_PARALLEL_PARTITION_SIZE) {
+      left = partitionAgentsParallel(begin, end, isVertical, splitValue);
+    } else {
+      std::size_t right = end;
 
-      while (right > left &&
-             (isVertical ? agents_[right - 1U]->position_.x()
-                         : agents_[right - 1U]->position_.y()) >= splitValue) {
-        --right;
-      }
+      while (left < right) {
+        while (left < right &&
+               (isVertical ? positions[agents_[left]].x()
+                           : positions[agents_[left]].y()) < splitValue) {
+          ++left;
+        }
 
-      if (left < right) {
-        std::swap(agents_[left], agents_[right - 1U]);
-        ++left;
-        --right;
+        while (right > left &&
+               (isVertical ? positions[agents_[right - 1U]].x()
+                           : positions[agents_[right - 1U]].y()) >=
+                   splitValue) {
+          --right;
+        }
+
+        if (left < right) {
+          std::swap(agents_[left], agents_[right - 1U]);
+          ++left;
+          --right;
+        }
       }
     }
 
     if (left == begin) {
       ++left;
-      ++right;
     }
 
     agentTree_[node].left = node + 1U;
     agentTree_[node].right = node + 2U * (left - begin);
 
+#ifdef RVO_OPENMP_TASKS
+    if (end - begin >= RVO_MIN_AGENT_SUBTREE_TASK_SIZE) {
+      /* Build the left subtree in a separate task and the right subtree in
+       * this one. */
+      const std::size_t leftNode = agentTree_[node].left;
+
+#pragma omp task
+      buildAgentTreeRecursive(begin, left, leftNode);
+
+      buildAgentTreeRecursive(left, end, agentTree_[node].right);
+
+      return;
+    }
+#endif /* RVO_OPENMP_TASKS */
+
     buildAgentTreeRecursive(begin, left, agentTree_[node].left);
     buildAgentTreeRecursive(left, end, agentTree_[node].right);
+  } else {
+    /* Leaf node. */
+    for (std::size_t i = begin; i < end; ++i) {
+      agentsX_[i] = positions[agents_[i]].x();
+      agentsY_[i] = positions[agents_[i]].y();
+    }
   }
 }
 
-void KdTree::buildObstacleTree() {
-  deleteObstacleTree(obstacleTree_);
+void KdTree::buildDynamicObstacleTree() {
+  dynamicObstacleTree_.resize(
+      dynamicObstacles_.empty() ? 0U : 2U * dynamicObstacles_.size() - 1U);
 
-  const std::vector<Obstacle *> obstacles(simulator_->obstacles_);
-  obstacleTree_ = buildObstacleTreeRecursive(obstacles);
+  if (!dynamicObstacles_.empty()) {
+    buildDynamicObstacleTreeRecursive(0U, dynamicObstacles_.size(), 0U);
+  }
 }
 
-KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
-    const std::vector<Obstacle *> &obstacles) {
-  if (!obstacles.empty()) {
-    ObstacleTreeNode *const node = new ObstacleTreeNode();
+void KdTree::buildDynamicObstacleTreeRecursive(std::size_t begin,
+                                               std::size_t end,
+                                               std::size_t node) {
+  DynamicObstacleTreeNode &treeNode = dynamicObstacleTree_[node];
 
-    std::size_t optimalSplit = 0U;
-    std::size_t minLeft = obstacles.size();
-    std::size_t minRight = obstacles.size();
+  treeNode.begin = begin;
+  treeNode.end = end;
+  treeNode.minX = treeNode.maxX = dynamicObstacles_[begin]->point_.x();
+  treeNode.minY = treeNode.maxY = dynamicObstacles_[begin]->point_.y();
+
+  for (std::size_t i = begin; i < end; ++i) {
+    const Vector2 &point1 = dynamicObstacles_[i]->point_;
+    const Vector2 &point2 = dynamicObstacles_[i]->next_->point_;
 
-    for (std::size_t i = 0U; i < obstacles.size(); ++i) {
-      std::size_t leftSize = 0U;
-      std::size_t rightSize = 0U;
+    treeNode.maxX = std::max(treeNode.maxX, std::max(point1.x(), point2.x()));
+    treeNode.minX = std::min(treeNode.minX, std::min(point1.x(), point2.x()));
+    treeNode.maxY = std::max(treeNode.maxY, std::max(point1.y(), point2.y()));
+    treeNode.minY = std::min(treeNode.minY, std::min(point1.y(), point2.y()));
+  }
 
-      const Obstacle *const obstacleI1 = obstacles[i];
-      const Obstacle *const obstacleI2 = obstacleI1->next_;
+  if (end - begin > RVO_MAX_DYNAMIC_OBSTACLE_LEAF_SIZE) {
+    /* No leaf node. The obstacle edges are split at the median of their
+     * midpoints along the longer side of the bounding box. */
+    const bool isVertical =
+        treeNode.maxX - treeNode.minX > treeNode.maxY - treeNode.minY;
+    const std::size_t middle = begin + (end - begin) / 2U;
+
+    /* Ties are broken by obstacle number so that the split does not depend
+     * on the addresses of the obstacles. */
+    std::vector<std::pair<std::pair<Real, std::size_t>, const Obstacle *> >
+        midpoints(end - begin);
+
+    for (std::size_t i = begin; i < end; ++i) {
+      const Obstacle *const obstacle = dynamicObstacles_[i];
+      const Vector2 sum = obstacle->point_ + obstacle->next_->point_;
+      midpoints[i - begin] = std::make_pair(
+          std::make_pair(isVertical ? sum.x() : sum.y(), obstacle->id_),
+          obstacle);
+    }
 
-      /* Compute optimal split node. */
-      for (std::size_t j = 0U; j < obstacles.size(); ++j) {
-        if (i != j) {
-          const Obstacle *const obstacleJ1 = obstacles[j];
-          const Obstacle *const obstacleJ2 = obstacleJ1->next_;
+    std::nth_element(midpoints.begin(), midpoints.begin() + (middle - begin),
+                     midpoints.end());
 
-          const float j1LeftOfI = leftOf(obstacleI1->point_, obstacleI2->point_,
-                                         obstacleJ1->point_);
-          const float j2LeftOfI = leftOf(obstacleI1->point_, obstacleI2->point_,
-                                         obstacleJ2->point_);
+    for (std::size_t i = begin; i < end; ++i) {
+      dynamicObstacles_[i] = midpoints[i - begin].second;
+    }
 
-          if (j1LeftOfI >= -RVO_EPSILON && j2LeftOfI >= -RVO_EPSILON) {
-            ++leftSize;
-          } else if (j1LeftOfI <= RVO_EPSILON && j2LeftOfI <= RVO_EPSILON) {
-            ++rightSize;
-          } else {
-            ++leftSize;
-            ++rightSize;
-          }
+    treeNode.left = node + 1U;
+    treeNode.right = node + 2U * (middle - begin);
+
+    buildDynamicObstacleTreeRecursive(begin, middle, treeNode.left);
+    buildDynamicObstacleTreeRecursive(middle, end, treeNode.right);
+  }
+}
+
+void KdTree::buildObstacleTree(std::size_t maxSplitCandidates) {
+  obstacleTree_.clear();
 
-          if (std::make_pair(std::max(leftSize, rightSize),
-                             std::min(leftSize, rightSize)) >=
-              std::make_pair(std::max(minLeft, minRight),
-                             std::min(minLeft, minRight))) {
-            break;
+  /* Dynamic obstacles, and the vertices of removed ones, are not part of the
+   * obstacle k-D tree. */
+  std::vector<Obstacle *> obstacles;
+  obstacles.reserve(simulator_->obstacles_.size());
+
+  for (std::size_t i = 0U; i < simulator_->obstacles_.size(); ++i) {
+    if (simulator_->obstacles_[i] != NULL &&
+        !simulator_->obstacles_[i]->isDynamic_) {
+      obstacles.push_back(simulator_->obstacles_[i]);
+    }
+  }
+
+  obstacleTree_.reserve(obstacles.size());
+  buildObstacleTreeRecursive(obstacles, maxSplitCandidates);
+}
+
+std::size_t KdTree::buildObstacleTreeRecursive(
+    const std::vector<Obstacle *> &obstacles, std::size_t maxSplitCandidates) {
+  if (!obstacles.empty()) {
+    const std::size_t node = obstacleTree_.size();
+    obstacleTree_.push_back(ObstacleTreeNode());
+
+    /* Sets of obstacles larger than the maximum count of candidates are
+     * split by the best of an evenly spaced sample of them. */
+    const std::size_t numCandidates =
+        std::min(obstacles.size(), maxSplitCandidates);
+    std::vector<std::pair<std::size_t, std::size_t> > splitSizes(
+        numCandidates);
+
+#ifdef _OPENMP
+#pragma omp parallel if (obstacles.size() >= \
+                         RVO_MIN_PARALLEL_OBSTACLE_SPLIT_SIZE)
+#endif /* _OPENMP */
+    {
+      /* Each thread stops counting for a candidate once it cannot beat the
+       * best candidate of that thread. Such a candidate is never chosen. */
+      std::pair<std::size_t, std::size_t> minCost(obstacles.size(),
+                                                  obstacles.size());
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif /* _OPENMP */
+      for (std::size_t k = 0U; k < numCandidates; ++k) {
+        std::size_t leftSize = 0U;
+        std::size_t rightSize = 0U;
+
+        const std::size_t i = k * obstacles.size() / numCandidates;
+        const Obstacle *const obstacleI1 = obstacles[i];
+        const Obstacle *const obstacleI2 = obstacleI1->next_;
+
+        /* Compute optimal split node. */
+        for (std::size_t j = 0U; j < obstacles.size(); ++j) {
+          if (i != j) {
+            const Obstacle *const obstacleJ1 = obstacles[j];
+            const Obstacle *const obstacleJ2 = obstacleJ1->next_;
+
+            const Real j1LeftOfI = leftOf(
+                obstacleI1->point_, obstacleI2->point_, obstacleJ1->point_);
+            const Real j2LeftOfI = leftOf(
+                obstacleI1->point_, obstacleI2->point_, obstacleJ2->point_);
+
+            if (j1LeftOfI >= -RVO_EPSILON && j2LeftOfI >= -RVO_EPSILON) {
+              ++leftSize;
+            } else if (j1LeftOfI <= RVO_EPSILON && j2LeftOfI <= RVO_EPSILON) {
+              ++rightSize;
+            } else {
+              ++leftSize;
+              ++rightSize;
+            }
+
+            if (std::make_pair(std::max(leftSize, rightSize),
+                               std::min(leftSize, rightSize)) >= minCost) {
+              break;
+            }
           }
         }
+
+        splitSizes[k] = std::make_pair(leftSize, rightSize);
+
+        const std::pair<std::size_t, std::size_t> cost(
+            std::max(leftSize, rightSize), std::min(leftSize, rightSize));
+
+        if (cost < minCost) {
+          minCost = cost;
+        }
       }
+    }
+
+    std::size_t optimalSplit = 0U;
+    std::size_t minLeft = obstacles.size();
+    std::size_t minRight = obstacles.size();
+
+    for (std::size_t k = 0U; k < numCandidates; ++k) {
+      const std::size_t leftSize = splitSizes[k].first;
+      const std::size_t rightSize = splitSizes[k].second;
 
       if (std::make_pair(std::max(leftSize, rightSize),
                          std::min(leftSize, rightSize)) <
@@ -298,7 +754,7 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
                          std::min(minLeft, minRight))) {
         minLeft = leftSize;
         minRight = rightSize;
-        optimalSplit = i;
+        optimalSplit = k * obstacles.size() / numCandidates;
       }
     }
 
@@ -318,9 +774,9 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
         Obstacle *const obstacleJ1 = obstacles[j];
         Obstacle *const obstacleJ2 = obstacleJ1->next_;
 
-        const float j1LeftOfI =
+        const Real j1LeftOfI =
             leftOf(obstacleI1->point_, obstacleI2->point_, obstacleJ1->point_);
-        const float j2LeftOfI =
+        const Real j2LeftOfI =
             leftOf(obstacleI1->point_, obstacleI2->point_, obstacleJ2->point_);
 
         if (j1LeftOfI >= -RVO_EPSILON && j2LeftOfI >= -RVO_EPSILON) {
@@ -329,7 +785,7 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
           rightObstacles[rightCounter++] = obstacles[j];
         } else {
           /* Split obstacle j. */
-          const float t = det(obstacleI2->point_ - obstacleI1->point_,
+          const Real t = det(obstacleI2->point_ - obstacleI1->point_,
                               obstacleJ1->point_ - obstacleI1->point_) /
                           det(obstacleI2->point_ - obstacleI1->point_,
                               obstacleJ1->point_ - obstacleJ2->point_);
@@ -361,63 +817,245 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
       }
     }
 
-    node->obstacle = obstacleI1;
-    node->left = buildObstacleTreeRecursive(leftObstacles);
-    node->right = buildObstacleTreeRecursive(rightObstacles);
+    obstacleTree_[node].point1 = obstacleI1->point_;
+    obstacleTree_[node].point2 = obstacleI2->point_;
+    obstacleTree_[node].invLengthSq =
+        1.0F / absSq(obstacleI2->point_ - obstacleI1->point_);
+    obstacleTree_[node].obstacle = obstacleI1;
+
+    /* The left subtree is appended first, so the obstacle k-D tree is stored
+     * in depth-first order. The node may move while its subtrees are built,
+     * so it is referenced by number. */
+    const std::size_t left =
+        buildObstacleTreeRecursive(leftObstacles, maxSplitCandidates);
+    const std::size_t right =
+        buildObstacleTreeRecursive(rightObstacles, maxSplitCandidates);
+    obstacleTree_[node].left = left;
+    obstacleTree_[node].right = right;
 
     return node;
   }
 
-  return NULL;
+  return RVO_NO_OBSTACLE_TREE_NODE;
 }
 
-void KdTree::computeAgentNeighbors(Agent *agent, float &rangeSq) const {
+void KdTree::computeAgentNeighbors(Agent *agent, Real &rangeSq) const {
   queryAgentTreeRecursive(agent, rangeSq, 0U);
 }
 
-void KdTree::computeObstacleNeighbors(Agent *agent, float rangeSq) const {
-  queryObstacleTreeRecursive(agent, rangeSq, obstacleTree_);
+void KdTree::computeAgentTreeBoundsParallel(std::size_t node) {
+  const std::vector<Vector2> &positions = simulator_->agentStore_->positions_;
+  const std::size_t begin = agentTree_[node].begin;
+  const std::size_t end = agentTree_[node].end;
+  const std::size_t numChunks =
+      (end - begin + RVO_AGENT_TREE_CHUNK_SIZE - 1U) /
+      RVO_AGENT_TREE_CHUNK_SIZE;
+
+  std::vector<AgentTreeNode> chunks(numChunks);
+
+  for (std::size_t chunk = 0U; chunk < numChunks; ++chunk) {
+#ifdef RVO_OPENMP_TASKS
+#pragma omp task shared(chunks, positions)
+#endif /* RVO_OPENMP_TASKS */
+    {
+      const std::size_t chunkBegin = begin + chunk * RVO_AGENT_TREE_CHUNK_SIZE;
+      const std::size_t chunkEnd =
+          std::min(end, chunkBegin + RVO_AGENT_TREE_CHUNK_SIZE);
+
+      AgentTreeNode &bounds = chunks[chunk];
+      bounds.minX = bounds.maxX = positions[agents_[chunkBegin]].x();
+      bounds.minY = bounds.maxY = positions[agents_[chunkBegin]].y();
+
+      for (std::size_t i = chunkBegin + 1U; i < chunkEnd; ++i) {
+        bounds.maxX = std::max(bounds.maxX, positions[agents_[i]].x());
+        bounds.minX = std::min(bounds.minX, positions[agents_[i]].x());
+        bounds.maxY = std::max(bounds.maxY, positions[agents_[i]].y());
+        bounds.minY = std::min(bounds.minY, positions[agents_[i]].y());
+      }
+    }
+  }
+
+#ifdef RVO_OPENMP_TASKS
+#pragma omp taskwait
+#endif /* RVO_OPENMP_TASKS */
+
+  agentTree_[node].maxX = chunks[0U].maxX;
+  agentTree_[node].minX = chunks[0U].minX;
+  agentTree_[node].maxY = chunks[0U].maxY;
+  agentTree_[node].minY = chunks[0U].minY;
+
+  for (std::size_t chunk = 1U; chunk < numChunks; ++chunk) {
+    agentTree_[node].maxX = std::max(agentTree_[node].maxX, chunks[chunk].maxX);
+    agentTree_[node].minX = std::min(agentTree_[node].minX, chunks[chunk].minX);
+    agentTree_[node].maxY = std::max(agentTree_[node].maxY, chunks[chunk].maxY);
+    agentTree_[node].minY = std::min(agentTree_[node].minY, chunks[chunk].minY);
+  }
+}
+
+void KdTree::computeObstacleNeighbors(Agent *agent, Real rangeSq) const {
+  if (!obstacleTree_.empty()) {
+    queryObstacleTreeRecursive(agent, rangeSq, 0U);
+  }
+
+  if (!dynamicObstacleTree_.empty()) {
+    queryDynamicObstacleTreeRecursive(agent, rangeSq, 0U);
+  }
 }
 
-void KdTree::deleteObstacleTree(ObstacleTreeNode *node) {
-  if (node != NULL) {
-    deleteObstacleTree(node->left);
-    deleteObstacleTree(node->right);
-    delete node;
+std::size_t KdTree::partitionAgentsParallel(std::size_t begin, std::size_t end,
+                                            bool isVertical,
+                                            Real splitValue) {
+  const std::vector<Vector2> &positions = simulator_->agentStore_->positions_;
+  const std::size_t numChunks =
+      (end - begin + RVO_AGENT_TREE_CHUNK_SIZE - 1U) /
+      RVO_AGENT_TREE_CHUNK_SIZE;
+
+  /* Count the agents of each chunk that belong to the left subtree. */
+  std::vector<std::size_t> leftOffsets(numChunks + 1U, 0U);
+
+  for (std::size_t chunk = 0U; chunk < numChunks; ++chunk) {
+#ifdef RVO_OPENMP_TASKS
+#pragma omp task shared(leftOffsets, positions)
+#endif /* RVO_OPENMP_TASKS */
+    {
+      const std::size_t chunkBegin = begin + chunk * RVO_AGENT_TREE_CHUNK_SIZE;
+      const std::size_t chunkEnd =
+          std::min(end, chunkBegin + RVO_AGENT_TREE_CHUNK_SIZE);
+      std::size_t numLeft = 0U;
+
+      for (std::size_t i = chunkBegin; i < chunkEnd; ++i) {
+        if ((isVertical ? positions[agents_[i]].x()
+                        : positions[agents_[i]].y()) < splitValue) {
+          ++numLeft;
+        }
+      }
+
+      leftOffsets[chunk + 1U] = numLeft;
+    }
+  }
+
+#ifdef RVO_OPENMP_TASKS
+#pragma omp taskwait
+#endif /* RVO_OPENMP_TASKS */
+
+  for (std::size_t chunk = 0U; chunk < numChunks; ++chunk) {
+    leftOffsets[chunk + 1U] += leftOffsets[chunk];
   }
+
+  const std::size_t numLeft = leftOffsets[numChunks];
+
+  /* Scatter each chunk into its slots of the buffer, keeping the relative
+   * order of agents on either side of the split. */
+  for (std::size_t chunk = 0U; chunk < numChunks; ++chunk) {
+#ifdef RVO_OPENMP_TASKS
+#pragma omp task shared(leftOffsets, positions)
+#endif /* RVO_OPENMP_TASKS */
+    {
+      const std::size_t chunkBegin = begin + chunk * RVO_AGENT_TREE_CHUNK_SIZE;
+      const std::size_t chunkEnd =
+          std::min(end, chunkBegin + RVO_AGENT_TREE_CHUNK_SIZE);
+      std::size_t left = begin + leftOffsets[chunk];
+      std::size_t right =
+          begin + numLeft + (chunkBegin - begin) - leftOffsets[chunk];
+
+      for (std::size_t i = chunkBegin; i < chunkEnd; ++i) {
+        if ((isVertical ? positions[agents_[i]].x()
+                        : positions[agents_[i]].y()) < splitValue) {
+          agentsBuffer_[left++] = agents_[i];
+        } else {
+          agentsBuffer_[right++] = agents_[i];
+        }
+      }
+    }
+  }
+
+#ifdef RVO_OPENMP_TASKS
+#pragma omp taskwait
+#endif /* RVO_OPENMP_TASKS */
+
+  for (std::size_t chunk = 0U; chunk < numChunks; ++chunk) {
+#ifdef RVO_OPENMP_TASKS
+#pragma omp task
+#endif /* RVO_OPENMP_TASKS */
+    {
+      const std::size_t chunkBegin = begin + chunk * RVO_AGENT_TREE_CHUNK_SIZE;
+      const std::size_t chunkEnd =
+          std::min(end, chunkBegin + RVO_AGENT_TREE_CHUNK_SIZE);
+
+      std::copy(agentsBuffer_.begin() + static_cast<std::ptrdiff_t>(chunkBegin),
+                agentsBuffer_.begin() + static_cast<std::ptrdiff_t>(chunkEnd),
+                agents_.begin() + static_cast<std::ptrdiff_t>(chunkBegin));
+    }
+  }
+
+#ifdef RVO_OPENMP_TASKS
+#pragma omp taskwait
+#endif /* RVO_OPENMP_TASKS */
+
+  return begin + numLeft;
 }
 
-void KdTree::queryAgentTreeRecursive(Agent *agent, float &rangeSq,
+void KdTree::queryAgentTreeRecursive(Agent *agent, Real &rangeSq,
                                      std::size_t node) const {
+#if RVO_ENABLE_STATISTICS
+  ++agent->statistics_->numAgentTreeNodesVisited;
+#endif /* RVO_ENABLE_STATISTICS */
+
+  const Vector2 &position = agent->store_->positions_[agent->id_];
+
   if (agentTree_[node].end - agentTree_[node].begin <= RVO_MAX_LEAF_SIZE) {
-    for (std::size_t i = agentTree_[node].begin; i < agentTree_[node].end;
-         ++i) {
-      agent->insertAgentNeighbor(agents_[i], rangeSq);
+    /* The distances to the agents of the leaf are computed RVO_SIMD_WIDTH at
+     * a time from its contiguous coordinates. The agents within range are
+     * then inserted in order, each against the range as narrowed by the
+     * agents inserted before it. */
+    std::size_t i = agentTree_[node].begin;
+
+    for (; i + RVO_SIMD_WIDTH <= agentTree_[node].end; i += RVO_SIMD_WIDTH) {
+      Real distSq[RVO_SIMD_WIDTH];
+      const unsigned int mask =
+          computeLeafDistSq(&agentsX_[i], &agentsY_[i], position.x(),
+                            position.y(), rangeSq, distSq);
+
+      for (std::size_t j = 0U; j < RVO_SIMD_WIDTH; ++j) {
+        if ((mask & (1U << j)) != 0U) {
+          agent->insertAgentNeighbor(agents_[i + j], distSq[j], rangeSq);
+        }
+      }
+    }
+
+    for (; i < agentTree_[node].end; ++i) {
+      const Real distX = position.x() - agentsX_[i];
+      const Real distY = position.y() - agentsY_[i];
+      const Real distSq = distX * distX + distY * distY;
+
+      if (distSq < rangeSq) {
+        agent->insertAgentNeighbor(agents_[i], distSq, rangeSq);
+      }
     }
   } else {
-    const float distLeftMinX = std::max(
-        0.0F, agentTree_[agentTree_[node].left].minX - agent->position_.x());
-    const float distLeftMaxX = std::max(
-        0.0F, agent->position_.x() - agentTree_[agentTree_[node].left].maxX);
-    const float distLeftMinY = std::max(
-        0.0F, agentTree_[agentTree_[node].left].minY - agent->position_.y());
-    const float distLeftMaxY = std::max(
-        0.0F, agent->position_.y() - agentTree_[agentTree_[node].left].maxY);
-
-    const float distSqLeft =
+    const Real distLeftMinX = std::max<Real>(
+        0.0F, agentTree_[agentTree_[node].left].minX - position.x());
+    const Real distLeftMaxX = std::max<Real>(
+        0.0F, position.x() - agentTree_[agentTree_[node].left].maxX);
+    const Real distLeftMinY = std::max<Real>(
+        0.0F, agentTree_[agentTree_[node].left].minY - position.y());
+    const Real distLeftMaxY = std::max<Real>(
+        0.0F, position.y() - agentTree_[agentTree_[node].left].maxY);
+
+    const Real distSqLeft =
         distLeftMinX * distLeftMinX + distLeftMaxX * distLeftMaxX +
         distLeftMinY * distLeftMinY + distLeftMaxY * distLeftMaxY;
 
-    const float distRightMinX = std::max(
-        0.0F, agentTree_[agentTree_[node].right].minX - agent->position_.x());
-    const float distRightMaxX = std::max(
-        0.0F, agent->position_.x() - agentTree_[agentTree_[node].right].maxX);
-    const float distRightMinY = std::max(
-        0.0F, agentTree_[agentTree_[node].right].minY - agent->position_.y());
-    const float distRightMaxY = std::max(
-        0.0F, agent->position_.y() - agentTree_[agentTree_[node].right].maxY);
+    const Real distRightMinX = std::max<Real>(
+        0.0F, agentTree_[agentTree_[node].right].minX - position.x());
+    const Real distRightMaxX = std::max<Real>(
+        0.0F, position.x() - agentTree_[agentTree_[node].right].maxX);
+    const Real distRightMinY = std::max<Real>(
+        0.0F, agentTree_[agentTree_[node].right].minY - position.y());
+    const Real distRightMaxY = std::max<Real>(
+        0.0F, position.y() - agentTree_[agentTree_[node].right].maxY);
 
-    const float distSqRight =
+    const Real distSqRight =
         distRightMinX * distRightMinX + distRightMaxX * distRightMaxX +
         distRightMinY * distRightMinY + distRightMaxY * distRightMaxY;
 
@@ -439,85 +1077,382 @@ void KdTree::queryAgentTreeRecursive(Agent *agent, float &rangeSq,
   }
 }
 
-void KdTree::queryObstacleTreeRecursive(Agent *agent, float rangeSq,
-                                        const ObstacleTreeNode *node) const {
-  if (node != NULL) {
-    const Obstacle *const obstacle1 = node->obstacle;
-    const Obstacle *const obstacle2 = obstacle1->next_;
+void KdTree::queryDynamicObstacleTreeRecursive(Agent *agent, Real rangeSq,
+                                               std::size_t node) const {
+  const DynamicObstacleTreeNode &treeNode = dynamicObstacleTree_[node];
+  const Vector2 &position = agent->store_->positions_[agent->id_];
+
+  const Real distMinX = std::max<Real>(0.0F, treeNode.minX - position.x());
+  const Real distMaxX = std::max<Real>(0.0F, position.x() - treeNode.maxX);
+  const Real distMinY = std::max<Real>(0.0F, treeNode.minY - position.y());
+  const Real distMaxY = std::max<Real>(0.0F, position.y() - treeNode.maxY);
+
+  if (distMinX * distMinX + distMaxX * distMaxX + distMinY * distMinY +
+          distMaxY * distMaxY >=
+      rangeSq) {
+    return;
+  }
+
+  if (treeNode.end - treeNode.begin <= RVO_MAX_DYNAMIC_OBSTACLE_LEAF_SIZE) {
+    for (std::size_t i = treeNode.begin; i < treeNode.end; ++i) {
+      const Obstacle *const obstacle = dynamicObstacles_[i];
+
+      /* Try obstacle only if agent is on right side of obstacle. */
+      if (leftOf(obstacle->point_, obstacle->next_->point_, position) < 0.0F) {
+        agent->insertObstacleNeighbor(obstacle, rangeSq);
+      }
+    }
+  } else {
+    queryDynamicObstacleTreeRecursive(agent, rangeSq, treeNode.left);
+    queryDynamicObstacleTreeRecursive(agent, rangeSq, treeNode.right);
+  }
+}
+
+bool KdTree::queryDynamicObstacleVisibilityRecursive(const Vector2 &vector1,
+                                                     const Vector2 &vector2,
+                                                     Real radius,
+                                                     std::size_t node) const {
+  const DynamicObstacleTreeNode &treeNode = dynamicObstacleTree_[node];
+
+  if (std::min(vector1.x(), vector2.x()) - radius > treeNode.maxX ||
+      std::max(vector1.x(), vector2.x()) + radius < treeNode.minX ||
+      std::min(vector1.y(), vector2.y()) - radius > treeNode.maxY ||
+      std::max(vector1.y(), vector2.y()) + radius < treeNode.minY) {
+    return true;
+  }
 
-    const float agentLeftOfLine =
-        leftOf(obstacle1->point_, obstacle2->point_, agent->position_);
+  if (treeNode.end - treeNode.begin > RVO_MAX_DYNAMIC_OBSTACLE_LEAF_SIZE) {
+    return queryDynamicObstacleVisibilityRecursive(vector1, vector2, radius,
+                                                   treeNode.left) &&
+           queryDynamicObstacleVisibilityRecursive(vector1, vector2, radius,
+                                                   treeNode.right);
+  }
+
+  for (std::size_t i = treeNode.begin; i < treeNode.end; ++i) {
+    const Vector2 &point1 = dynamicObstacles_[i]->point_;
+    const Vector2 &point2 = dynamicObstacles_[i]->next_->point_;
+
+    const Real q1LeftOfI = leftOf(point1, point2, vector1);
+    const Real q2LeftOfI = leftOf(point1, point2, vector2);
+
+    if (q1LeftOfI < 0.0F && q2LeftOfI > 0.0F) {
+      /* As in the obstacle k-D tree, one can see through an obstacle from
+       * left to right, and an obstacle crossed from right to left blocks the
+       * points unless it lies to one side of them beyond the radius. */
+      const Real point1LeftOfQ = leftOf(vector1, vector2, point1);
+      const Real point2LeftOfQ = leftOf(vector1, vector2, point2);
+      const Real invLengthQ = 1.0F / absSq(vector2 - vector1);
+
+      if (point1LeftOfQ * point2LeftOfQ < 0.0F ||
+          point1LeftOfQ * point1LeftOfQ * invLengthQ <= radius * radius ||
+          point2LeftOfQ * point2LeftOfQ * invLengthQ <= radius * radius) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void KdTree::queryObstacleTreeRecursive(Agent *agent, Real rangeSq,
+                                        std::size_t node) const {
+  if (node != RVO_NO_OBSTACLE_TREE_NODE) {
+    const ObstacleTreeNode &treeNode = obstacleTree_[node];
+
+    const Real agentLeftOfLine =
+        leftOf(treeNode.point1, treeNode.point2,
+               agent->store_->positions_[agent->id_]);
 
     queryObstacleTreeRecursive(
-        agent, rangeSq, agentLeftOfLine >= 0.0F ? node->left : node->right);
+        agent, rangeSq,
+        agentLeftOfLine >= 0.0F ? treeNode.left : treeNode.right);
 
-    const float distSqLine = agentLeftOfLine * agentLeftOfLine /
-                             absSq(obstacle2->point_ - obstacle1->point_);
+    const Real distSqLine =
+        agentLeftOfLine * agentLeftOfLine * treeNode.invLengthSq;
 
     if (distSqLine < rangeSq) {
       if (agentLeftOfLine < 0.0F) {
         /* Try obstacle at this node only if agent is on right side of obstacle
          * and can see obstacle. */
-        agent->insertObstacleNeighbor(node->obstacle, rangeSq);
+        agent->insertObstacleNeighbor(treeNode.obstacle, rangeSq);
       }
 
       /* Try other side of line. */
       queryObstacleTreeRecursive(
-          agent, rangeSq, agentLeftOfLine >= 0.0F ? node->right : node->left);
+          agent, rangeSq,
+          agentLeftOfLine >= 0.0F ? treeNode.right : treeNode.left);
     }
   }
 }
 
 bool KdTree::queryVisibility(const Vector2 &vector1, const Vector2 &vector2,
-                             float radius) const {
-  return queryVisibilityRecursive(vector1, vector2, radius, obstacleTree_);
+                             Real radius) const {
+  return (obstacleTree_.empty() ||
+          queryVisibilityRecursive(vector1, vector2, radius, 0U)) &&
+         (dynamicObstacleTree_.empty() ||
+          queryDynamicObstacleVisibilityRecursive(vector1, vector2, radius,
+                                                  0U));
 }
 
 bool KdTree::queryVisibilityRecursive(const Vector2 &vector1,
-                                      const Vector2 &vector2, float radius,
-                                      const ObstacleTreeNode *node) const {
-  if (node != NULL) {
-    const Obstacle *const obstacle1 = node->obstacle;
-    const Obstacle *const obstacle2 = obstacle1->next_;
-
-    const float q1LeftOfI =
-        leftOf(obstacle1->point_, obstacle2->point_, vector1);
-    const float q2LeftOfI =
-        leftOf(obstacle1->point_, obstacle2->point_, vector2);
-    const float invLengthI =
-        1.0F / absSq(obstacle2->point_ - obstacle1->point_);
+                                      const Vector2 &vector2, Real radius,
+                                      std::size_t node) const {
+  if (node != RVO_NO_OBSTACLE_TREE_NODE) {
+    const ObstacleTreeNode &treeNode = obstacleTree_[node];
+
+    const Real q1LeftOfI = leftOf(treeNode.point1, treeNode.point2, vector1);
+    const Real q2LeftOfI = leftOf(treeNode.point1, treeNode.point2, vector2);
+    const Real invLengthI = treeNode.invLengthSq;
 
     if (q1LeftOfI >= 0.0F && q2LeftOfI >= 0.0F) {
-      return queryVisibilityRecursive(vector1, vector2, radius, node->left) &&
+      return queryVisibilityRecursive(vector1, vector2, radius,
+                                      treeNode.left) &&
              ((q1LeftOfI * q1LeftOfI * invLengthI >= radius * radius &&
                q2LeftOfI * q2LeftOfI * invLengthI >= radius * radius) ||
-              queryVisibilityRecursive(vector1, vector2, radius, node->right));
+              queryVisibilityRecursive(vector1, vector2, radius,
+                                       treeNode.right));
     }
 
     if (q1LeftOfI <= 0.0F && q2LeftOfI <= 0.0F) {
-      return queryVisibilityRecursive(vector1, vector2, radius, node->right) &&
+      return queryVisibilityRecursive(vector1, vector2, radius,
+                                      treeNode.right) &&
              ((q1LeftOfI * q1LeftOfI * invLengthI >= radius * radius &&
                q2LeftOfI * q2LeftOfI * invLengthI >= radius * radius) ||
-              queryVisibilityRecursive(vector1, vector2, radius, node->left));
+              queryVisibilityRecursive(vector1, vector2, radius,
+                                       treeNode.left));
     }
 
     if (q1LeftOfI >= 0.0F && q2LeftOfI <= 0.0F) {
       /* One can see through obstacle from left to right. */
-      return queryVisibilityRecursive(vector1, vector2, radius, node->left) &&
-             queryVisibilityRecursive(vector1, vector2, radius, node->right);
+      return queryVisibilityRecursive(vector1, vector2, radius,
+                                      treeNode.left) &&
+             queryVisibilityRecursive(vector1, vector2, radius,
+                                      treeNode.right);
     }
 
-    const float point1LeftOfQ = leftOf(vector1, vector2, obstacle1->point_);
-    const float point2LeftOfQ = leftOf(vector1, vector2, obstacle2->point_);
-    const float invLengthQ = 1.0F / absSq(vector2 - vector1);
+    const Real point1LeftOfQ = leftOf(vector1, vector2, treeNode.point1);
+    const Real point2LeftOfQ = leftOf(vector1, vector2, treeNode.point2);
+    const Real invLengthQ = 1.0F / absSq(vector2 - vector1);
 
     return point1LeftOfQ * point2LeftOfQ >= 0.0F &&
            point1LeftOfQ * point1LeftOfQ * invLengthQ > radius * radius &&
            point2LeftOfQ * point2LeftOfQ * invLengthQ > radius * radius &&
-           queryVisibilityRecursive(vector1, vector2, radius, node->left) &&
-           queryVisibilityRecursive(vector1, vector2, radius, node->right);
+           queryVisibilityRecursive(vector1, vector2, radius, treeNode.left) &&
+           queryVisibilityRecursive(vector1, vector2, radius, treeNode.right);
+  }
+
+  return true;
+}
+
+bool KdTree::readObstacleTrees(SnapshotReader *reader,
+                               const std::vector<Obstacle *> &obstacles) {
+  std::size_t numNodes = 0U;
+  std::size_t numDynamicObstacles = 0U;
+  std::vector<std::size_t> nodeObstacles;
+  std::vector<std::size_t> lefts;
+  std::vector<std::size_t> rights;
+  std::vector<std::size_t> dynamicObstacleNos;
+
+  if (!reader->readSize(&numNodes) ||
+      !reader->readSizes(numNodes, &nodeObstacles) ||
+      !reader->readSizes(numNodes, &lefts) ||
+      !reader->readSizes(numNodes, &rights) ||
+      !reader->readSize(&numDynamicObstacles) ||
+      !reader->readSizes(numDynamicObstacles, &dynamicObstacleNos)) {
+    return false;
+  }
+
+  std::vector<ObstacleTreeNode> obstacleTree(numNodes);
+
+  for (std::size_t i = 0U; i < numNodes; ++i) {
+    /* The children of a node follow it, so that queries terminate. */
+    if (nodeObstacles[i] >= obstacles.size() ||
+        obstacles[nodeObstacles[i]] == NULL ||
+        obstacles[nodeObstacles[i]]->isDynamic_ ||
+        (lefts[i] != RVO_NO_OBSTACLE_TREE_NODE &&
+         (lefts[i] <= i || lefts[i] >= numNodes)) ||
+        (rights[i] != RVO_NO_OBSTACLE_TREE_NODE &&
+         (rights[i] <= i || rights[i] >= numNodes))) {
+      return false;
+    }
+
+    const Obstacle *const obstacle = obstacles[nodeObstacles[i]];
+
+    obstacleTree[i].point1 = obstacle->point_;
+    obstacleTree[i].point2 = obstacle->next_->point_;
+    obstacleTree[i].invLengthSq =
+        1.0F / absSq(obstacleTree[i].point2 - obstacleTree[i].point1);
+    obstacleTree[i].obstacle = obstacle;
+    obstacleTree[i].left = lefts[i];
+    obstacleTree[i].right = rights[i];
+  }
+
+  std::vector<const Obstacle *> dynamicObstacles(numDynamicObstacles);
+
+  for (std::size_t i = 0U; i < numDynamicObstacles; ++i) {
+    if (dynamicObstacleNos[i] >= obstacles.size() ||
+        obstacles[dynamicObstacleNos[i]] == NULL ||
+        !obstacles[dynamicObstacleNos[i]]->isDynamic_) {
+      return false;
+    }
+
+    dynamicObstacles[i] = obstacles[dynamicObstacleNos[i]];
   }
 
+  obstacleTree_.swap(obstacleTree);
+  dynamicObstacles_.swap(dynamicObstacles);
+  buildDynamicObstacleTree();
+
   return true;
 }
+
+void KdTree::refitAgentTree() {
+  std::vector<std::size_t> rebuildNodes;
+  refitAgentTreeRecursive(0U, rebuildNodes);
+
+  /* Rebuilding a subtree does not change the set of agents it contains, so
+   * the bounding boxes of its ancestors remain valid. */
+#ifdef RVO_OPENMP_TASKS
+#pragma omp parallel if (agents_.size() >= RVO_MIN_AGENT_SUBTREE_TASK_SIZE)
+#pragma omp single
+#endif /* RVO_OPENMP_TASKS */
+  for (std::size_t i = 0U; i < rebuildNodes.size(); ++i) {
+    const std::size_t node = rebuildNodes[i];
+
+#ifdef RVO_OPENMP_TASKS
+#pragma omp task if (agentTree_[node].end - agentTree_[node].begin >= \
+                     RVO_MIN_AGENT_SUBTREE_TASK_SIZE)
+#endif /* RVO_OPENMP_TASKS */
+    buildAgentTreeRecursive(agentTree_[node].begin, agentTree_[node].end,
+                            node);
+  }
+}
+
+void KdTree::refitAgentTreeRecursive(std::size_t node,
+                                     std::vector<std::size_t> &rebuildNodes) {
+  AgentTreeNode &treeNode = agentTree_[node];
+
+  if (treeNode.end - treeNode.begin <= RVO_MAX_LEAF_SIZE) {
+    const std::vector<Vector2> &positions =
+        simulator_->agentStore_->positions_;
+
+    treeNode.minX = treeNode.maxX = positions[agents_[treeNode.begin]].x();
+    treeNode.minY = treeNode.maxY = positions[agents_[treeNode.begin]].y();
+
+    for (std::size_t i = treeNode.begin; i < treeNode.end; ++i) {
+      agentsX_[i] = positions[agents_[i]].x();
+      agentsY_[i] = positions[agents_[i]].y();
+
+      treeNode.maxX = std::max(treeNode.maxX, agentsX_[i]);
+      treeNode.minX = std::min(treeNode.minX, agentsX_[i]);
+      treeNode.maxY = std::max(treeNode.maxY, agentsY_[i]);
+      treeNode.minY = std::min(treeNode.minY, agentsY_[i]);
+    }
+
+    return;
+  }
+
+  refitAgentTreeRecursive(treeNode.left, rebuildNodes);
+  refitAgentTreeRecursive(treeNode.right, rebuildNodes);
+
+  const AgentTreeNode &leftNode = agentTree_[treeNode.left];
+  const AgentTreeNode &rightNode = agentTree_[treeNode.right];
+
+  treeNode.maxX = std::max(leftNode.maxX, rightNode.maxX);
+  treeNode.minX = std::min(leftNode.minX, rightNode.minX);
+  treeNode.maxY = std::max(leftNode.maxY, rightNode.maxY);
+  treeNode.minY = std::min(leftNode.minY, rightNode.minY);
+
+  if (treeNode.maxX - treeNode.minX + treeNode.maxY - treeNode.minY >
+      treeNode.refitLimit) {
+    /* Nodes are visited in post-order and numbered in pre-order, so the
+     * subtrees of this node that are to be rebuilt are those at the back of
+     * the list with larger numbers. They are rebuilt with this node. */
+    while (!rebuildNodes.empty() && rebuildNodes.back() > node) {
+      rebuildNodes.pop_back();
+    }
+
+    rebuildNodes.push_back(node);
+  }
+}
+
+void KdTree::remapAgents(const std::vector<std::size_t> &order) {
+  if (agents_.size() != order.size()) {
+    /* The count of agents has changed, so the tree is about to be rebuilt. */
+    return;
+  }
+
+  std::vector<std::size_t> slots(order.size());
+
+  for (std::size_t i = 0U; i < order.size(); ++i) {
+    slots[order[i]] = i;
+  }
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    agents_[i] = slots[agents_[i]];
+  }
+}
+
+void KdTree::removeDynamicObstacle(const Obstacle *obstacle) {
+  /* The vertices of a dynamic obstacle have consecutive numbers. */
+  std::size_t numVertices = 0U;
+  const Obstacle *vertex = obstacle;
+
+  do {
+    ++numVertices;
+    vertex = vertex->next_;
+  } while (vertex != obstacle);
+
+  std::size_t numDynamicObstacles = 0U;
+
+  for (std::size_t i = 0U; i < dynamicObstacles_.size(); ++i) {
+    if (dynamicObstacles_[i]->id_ < obstacle->id_ ||
+        dynamicObstacles_[i]->id_ >= obstacle->id_ + numVertices) {
+      dynamicObstacles_[numDynamicObstacles++] = dynamicObstacles_[i];
+    }
+  }
+
+  dynamicObstacles_.resize(numDynamicObstacles);
+  buildDynamicObstacleTree();
+}
+
+void KdTree::updateAgentTree(std::size_t rebuildInterval) {
+  ++stepsSinceAgentTreeBuild_;
+
+  if (agents_.empty() || agents_.size() != simulator_->agentStore_->size() ||
+      stepsSinceAgentTreeBuild_ >= rebuildInterval) {
+    buildAgentTree();
+  } else {
+    refitAgentTree();
+  }
+}
+
+void KdTree::writeObstacleTrees(SnapshotWriter *writer) const {
+  std::vector<std::size_t> nodeObstacles(obstacleTree_.size());
+  std::vector<std::size_t> lefts(obstacleTree_.size());
+  std::vector<std::size_t> rights(obstacleTree_.size());
+
+  for (std::size_t i = 0U; i < obstacleTree_.size(); ++i) {
+    nodeObstacles[i] = obstacleTree_[i].obstacle->id_;
+    lefts[i] = obstacleTree_[i].left;
+    rights[i] = obstacleTree_[i].right;
+  }
+
+  std::vector<std::size_t> dynamicObstacleNos(dynamicObstacles_.size());
+
+  for (std::size_t i = 0U; i < dynamicObstacles_.size(); ++i) {
+    dynamicObstacleNos[i] = dynamicObstacles_[i]->id_;
+  }
+
+  /* The order of the dynamic obstacles depends on how often the dynamic
+   * obstacle k-D tree has been rebuilt, so they are written by number. */
+  std::sort(dynamicObstacleNos.begin(), dynamicObstacleNos.end());
+
+  writer->writeSize(obstacleTree_.size());
+  writer->writeSizes(nodeObstacles);
+  writer->writeSizes(lefts);
+  writer->writeSizes(rights);
+  writer->writeSize(dynamicObstacles_.size());
+  writer->writeSizes(dynamicObstacleNos);
+}
 } /* namespace RVO */
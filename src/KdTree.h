@@ -42,18 +42,24 @@
 #include <cstddef>
 #include <vector>
 
+#include "Real.h"
+
 namespace RVO {
 class Agent;
 class Obstacle;
 class RVOSimulator;
+class SnapshotReader;
+class SnapshotWriter;
 class Vector2;
 
 /**
- * @brief Defines k-D trees for agents and static obstacles in the simulation.
+ * @brief Defines k-D trees for agents and static and dynamic obstacles in the
+ *        simulation.
  */
 class KdTree {
  private:
   class AgentTreeNode;
+  class DynamicObstacleTreeNode;
   class ObstacleTreeNode;
 
   /**
@@ -67,6 +73,12 @@ class KdTree {
    */
   ~KdTree();
 
+  /**
+   * @brief     Adds a dynamic obstacle to the dynamic obstacle k-D tree.
+   * @param[in] obstacle A pointer to the first vertex of the dynamic obstacle.
+   */
+  void addDynamicObstacle(const Obstacle *obstacle);
+
   /**
    * @brief Builds an agent k-D tree.
    */
@@ -82,17 +94,46 @@ class KdTree {
                                std::size_t node);
 
   /**
-   * @brief Builds an obstacle k-D tree.
+   * @brief     Computes the bounding box of the specified agent k-D tree node
+   *            with one task per chunk of agents.
+   * @param[in] node The agent k-D tree node whose begin and end are set.
+   */
+  void computeAgentTreeBoundsParallel(std::size_t node);
+
+  /**
+   * @brief Builds a dynamic obstacle k-D tree.
+   */
+  void buildDynamicObstacleTree();
+
+  /**
+   * @brief     Recursive function to build a dynamic obstacle k-D tree.
+   * @param[in] begin The beginning dynamic obstacle k-D tree node.
+   * @param[in] end   The ending dynamic obstacle k-D tree node.
+   * @param[in] node  The current dynamic obstacle k-D tree node.
+   */
+  void buildDynamicObstacleTreeRecursive(std::size_t begin, std::size_t end,
+                                         std::size_t node);
+
+  /**
+   * @brief     Builds an obstacle k-D tree.
+   * @param[in] maxSplitCandidates The maximum count of obstacles evaluated as
+   *                               candidates to split each node. Must be
+   *                               positive.
    */
-  void buildObstacleTree();
+  void buildObstacleTree(std::size_t maxSplitCandidates);
 
   /**
-   * @brief     Recursive function to build an obstacle k-D tree.
-   * @param[in] obstacles List of obstacles from which to build the obstacle k-D
-   *                      tree.
+   * @brief     Recursive function to build an obstacle k-D tree. The nodes are
+   *            appended to the obstacle k-D tree in depth-first order.
+   * @param[in] obstacles          List of obstacles from which to build the
+   *                               obstacle k-D tree.
+   * @param[in] maxSplitCandidates The maximum count of obstacles evaluated as
+   *                               candidates to split each node.
+   * @return    The number of the root node of the obstacle k-D subtree.
    */
-  ObstacleTreeNode *buildObstacleTreeRecursive(
-      const std::vector<Obstacle *> &obstacles);
+  std::size_t buildObstacleTreeRecursive(
+      const std::vector<Obstacle *> &obstacles,
+      std::size_t maxSplitCandidates);
 
   /**
    * @brief     Computes the agent neighbors of the specified agent.
@@ -101,7 +142,7 @@ class KdTree {
    * @param[in, out] rangeSq The squared range around the agent.
    */
   void computeAgentNeighbors(
-      Agent *agent, float &rangeSq) const; /* NOLINT(runtime/references) */
+      Agent *agent, Real &rangeSq) const; /* NOLINT(runtime/references) */
 
   /**
    * @brief     Computes the obstacle neighbors of the specified agent.
@@ -109,13 +150,21 @@ class KdTree {
    *                    to be computed.
    * @param[in] rangeSq The squared range around the agent.
    */
-  void computeObstacleNeighbors(Agent *agent, float rangeSq) const;
+  void computeObstacleNeighbors(Agent *agent, Real rangeSq) const;
 
   /**
-   * @brief     Deletes the specified obstacle tree node.
-   * @param[in] node A pointer to the obstacle tree node to be deleted.
+   * @brief     Partitions the agents of the specified range about a split value
+   *            with one task per chunk of agents.
+   * @param[in] begin      The beginning of the range of agents.
+   * @param[in] end        The end of the range of agents.
+   * @param[in] isVertical True if the agents are split on their
+   *                       x-coordinates; false if on their y-coordinates.
+   * @param[in] splitValue The coordinate about which the agents are split.
+   * @return    The beginning of the agents whose coordinates are not less than
+   *            the split value.
    */
-  void deleteObstacleTree(ObstacleTreeNode *node);
+  std::size_t partitionAgentsParallel(std::size_t begin, std::size_t end,
+                                      bool isVertical, Real splitValue);
 
   /**
    * @brief         Recursive function to compute the neighbors of the specified
@@ -126,9 +175,37 @@ class KdTree {
    * @param[in]     node    The current agent k-D tree node.
    */
   void queryAgentTreeRecursive(Agent *agent,
-                               float &rangeSq, /* NOLINT(runtime/references) */
+                               Real &rangeSq, /* NOLINT(runtime/references) */
                                std::size_t node) const;
 
+  /**
+   * @brief     Recursive function to compute the dynamic obstacle neighbors of
+   *            the specified agent.
+   * @param[in] agent   A pointer to the agent for which neighbors are to be
+   *                    computed.
+   * @param[in] rangeSq The squared range around the agent.
+   * @param[in] node    The current dynamic obstacle k-D tree node.
+   */
+  void queryDynamicObstacleTreeRecursive(Agent *agent, Real rangeSq,
+                                         std::size_t node) const;
+
+  /**
+   * @brief     Recursive function to query the visibility between two points
+   *            within a specified radius past the dynamic obstacles.
+   * @param[in] vector1 The first point between which visibility is to be
+   *                    tested.
+   * @param[in] vector2 The second point between which visibility is to be
+   *                    tested.
+   * @param[in] radius  The radius within which visibility is to be tested.
+   * @param[in] node    The current dynamic obstacle k-D tree node.
+   * @return    True if q1 and q2 are mutually visible within the radius; false
+   *            otherwise.
+   */
+  bool queryDynamicObstacleVisibilityRecursive(const Vector2 &vector1,
+                                               const Vector2 &vector2,
+                                               Real radius,
+                                               std::size_t node) const;
+
   /**
    * @brief         Recursive function to compute the neighbors of the specified
    *                obstacle.
@@ -137,8 +214,8 @@ class KdTree {
    * @param[in,out] rangeSq The squared range around the agent.
    * @param[in]     node    The current obstacle k-D tree node.
    */
-  void queryObstacleTreeRecursive(Agent *agent, float rangeSq,
-                                  const ObstacleTreeNode *node) const;
+  void queryObstacleTreeRecursive(Agent *agent, Real rangeSq,
+                                  std::size_t node) const;
 
   /**
    * @brief     Queries the visibility between two points within a specified
@@ -152,7 +229,7 @@ class KdTree {
    *            otherwise.
    */
   bool queryVisibility(const Vector2 &vector1, const Vector2 &vector2,
-                       float radius) const;
+                       Real radius) const;
 
   /**
    * @brief     Recursive function to query the visibility between two points
@@ -167,8 +244,66 @@ class KdTree {
    *            otherwise.
    */
   bool queryVisibilityRecursive(const Vector2 &vector1, const Vector2 &vector2,
-                                float radius,
-                                const ObstacleTreeNode *node) const;
+                                Real radius, std::size_t node) const;
+
+  /**
+   * @brief     Reads the obstacle k-D tree and the list of dynamic obstacles
+   *            from a snapshot, replacing them, and rebuilds the dynamic
+   *            obstacle k-D tree. The tree is checked for consistency with
+   *            the obstacles, and is unchanged if it is not read.
+   * @param[in] reader    The snapshot reader.
+   * @param[in] obstacles The obstacles to which the tree refers.
+   * @return    Whether the obstacle k-D tree was read.
+   */
+  bool readObstacleTrees(SnapshotReader *reader,
+                         const std::vector<Obstacle *> &obstacles);
+
+  /**
+   * @brief Refits the agent k-D tree to the present agent positions, keeping
+   *        its topology, and rebuilds the subtrees whose bounding boxes have
+   *        grown too much since they were built.
+   */
+  void refitAgentTree();
+
+  /**
+   * @brief         Recursive function to refit an agent k-D tree.
+   * @param[in]     node         The current agent k-D tree node.
+   * @param[in,out] rebuildNodes The list of agent k-D tree nodes whose
+   *                             subtrees are to be rebuilt.
+   */
+  void refitAgentTreeRecursive(
+      std::size_t node,
+      std::vector<std::size_t> &rebuildNodes); /* NOLINT(runtime/references) */
+
+  /**
+   * @brief     Maps the agents referenced by the agent k-D tree to their new
+   *            slots after the agents have been reordered, keeping the
+   *            topology of the tree.
+   * @param[in] order The list of old slots of the agents in their new order.
+   */
+  void remapAgents(const std::vector<std::size_t> &order);
+
+  /**
+   * @brief     Removes a dynamic obstacle from the dynamic obstacle k-D tree.
+   * @param[in] obstacle A pointer to the first vertex of the dynamic obstacle.
+   */
+  void removeDynamicObstacle(const Obstacle *obstacle);
+
+  /**
+   * @brief     Updates the agent k-D tree for a new simulation step, either by
+   *            building it or by refitting it.
+   * @param[in] rebuildInterval The count of simulation steps between builds
+   *                            of the agent k-D tree.
+   */
+  void updateAgentTree(std::size_t rebuildInterval);
+
+  /**
+   * @brief     Writes the obstacle k-D tree and the list of dynamic obstacles
+   *            to a snapshot. The obstacle k-D tree is written rather than
+   *            rebuilt on reading, since building it splits obstacles.
+   * @param[in] writer The snapshot writer.
+   */
+  void writeObstacleTrees(SnapshotWriter *writer) const;
 
   /* Not implemented. */
   KdTree(const KdTree &other);
@@ -176,10 +311,16 @@ class KdTree {
   /* Not implemented. */
   KdTree &operator=(const KdTree &other);
 
-  std::vector<Agent *> agents_;
+  std::vector<std::size_t> agents_;
+  std::vector<std::size_t> agentsBuffer_;
+  std::vector<Real> agentsX_;
+  std::vector<Real> agentsY_;
   std::vector<AgentTreeNode> agentTree_;
-  ObstacleTreeNode *obstacleTree_;
+  std::vector<const Obstacle *> dynamicObstacles_;
+  std::vector<DynamicObstacleTreeNode> dynamicObstacleTree_;
+  std::vector<ObstacleTreeNode> obstacleTree_;
   RVOSimulator *simulator_;
+  std::size_t stepsSinceAgentTreeBuild_;
 
   friend class Agent;
   friend class RVOSimulator;
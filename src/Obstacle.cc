@@ -40,7 +40,11 @@
 
 namespace RVO {
 Obstacle::Obstacle()
-    : next_(NULL), previous_(NULL), id_(0U), isConvex_(false) {}
+    : next_(NULL),
+      previous_(NULL),
+      id_(0U),
+      isConvex_(false),
+      isDynamic_(false) {}
 
 Obstacle::~Obstacle() {}
 } /* namespace RVO */
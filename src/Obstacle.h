@@ -71,6 +71,7 @@ class Obstacle {
   Obstacle *previous_;
   std::size_t id_;
   bool isConvex_;
+  bool isDynamic_;
 
   friend class Agent;
   friend class KdTree;
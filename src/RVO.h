@@ -46,9 +46,14 @@
  */
 
 /* IWYU pragma: begin_exports */
+#include "Executor.h"
 #include "Export.h"
 #include "Line.h"
 #include "RVOSimulator.h"
+#include "Real.h"
+#include "StepStatistics.h"
+#include "TiledSimulator.h"
+#include "Trajectory.h"
 #include "Vector2.h"
 /* IWYU pragma: end_exports */
 
@@ -83,8 +88,9 @@ third-party applications. The user specifies static obstacles, agents, and the
 preferred velocities of the agents. The simulation is performed step-by-step via
 a simple call to the library. The simulation is fully accessible and manipulable
 during runtime. The library exploits multiple processors if they are available
-using <a href="https://www.openmp.org/">OpenMP</a> for efficient parallelization
-of the simulation.
+using a persistent pool of threads, and optionally
+<a href="https://www.openmp.org/">OpenMP</a>, for efficient parallelization of
+the simulation.
 
 The creation of <b>RVO2 Library</b> was supported by the
 <a href="https://www.arl.army.mil/who-we-are/directorates/aro/">United States
@@ -231,6 +237,25 @@ On Windows, configure Meson with a static default library:
 meson setup _build -Ddefault_library=static
 @endcode
 
+@section double_precision Double Precision
+
+By default, the real quantities of the simulation, such as positions,
+velocities, and times, are of type RVO::Real, which is @c float. Build with
+double precision for large worlds or long-running simulations whose
+coordinates lose too much precision as @c float:
+
+@code{.sh}
+cmake -B _build -S . -DENABLE_DOUBLE_PRECISION=ON
+meson setup _build -Ddouble_precision=true
+bazel build --define double_precision=true //src:RVO
+@endcode
+
+The double-precision library is installed as the separate package RVODouble,
+with its own headers, library, CMake configuration, and pkg-config file, so
+that it may be installed alongside the single-precision library. Its
+configuration defines @c RVO_USE_DOUBLE for dependents, which must see the
+same RVO::Real type as the library.
+
 @page using_rvo2_library Using RVO2 Library
 
 @section structure Structure
@@ -445,6 +470,25 @@ simulator->getAgentPosition(i)));
 }  // namespace
 @endcode
 
+@section tiled_worlds Tiled Worlds
+
+The precision of RVO::Real limits the size of the world that may be simulated
+around the origin. Rather than build with double precision, the user may
+simulate a large world with an RVO::TiledSimulator, which divides it into
+square tiles. Positions are given as the coordinates of a tile and a position
+relative to its origin, and the agents and obstacles of each tile are simulated
+in coordinates relative to its origin, so the simulation is as precise far from
+the origin as near it. Agents avoid the agents and obstacles of the neighboring
+tiles within a halo around their tile, whose width must be at least the range
+within which each agent takes others into account.
+
+@code{.cc}
+RVO::TiledSimulator simulator(1000.0F, 15.0F, 0.25F, 15.0F, 10U, 5.0F, 5.0F,
+                              2.0F, 2.0F);
+const std::size_t agentNo =
+    simulator.addAgent(40000L, 40000L, RVO::Vector2(500.0F, 500.0F));
+@endcode
+
 @section example_programs Example Programs
 
 <b>RVO2 Library</b> is accompanied by three example programs, which can be found
@@ -485,7 +529,7 @@ around the obstacles.</td>
 </tr>
 <tr>
 <td valign="top">timeStep</td>
-<td valign="top">float (time)</td>
+<td valign="top">Real (time)</td>
 <td valign="top">The time step of the simulation. Must be positive.</td>
 </tr>
 </table>
@@ -507,12 +551,12 @@ simulation. If the number is too low, the simulation will not be safe.</td>
 </tr>
 <tr>
 <td valign="top">maxSpeed</td>
-<td valign="top">float (distance/time)</td>
+<td valign="top">Real (distance/time)</td>
 <td valign="top">The maximum speed of the agent. Must be non-negative.</td>
 </tr>
 <tr>
 <td valign="top">neighborDist</td>
-<td valign="top">float (distance)</td>
+<td valign="top">Real (distance)</td>
 <td valign="top">The maximum distance center-point to center-point to other
 agents the agent takes into account in the navigation. The larger this number,
 the longer the running time of the simulation. If the number is too low, the
@@ -534,12 +578,12 @@ avoidance.</td>
 </tr>
 <tr>
 <td valign="top">radius</td>
-<td valign="top">float (distance)</td>
+<td valign="top">Real (distance)</td>
 <td valign="top">The radius of the agent. Must be non-negative.</td>
 </tr>
 <tr>
 <td valign="top" width="150">timeHorizon</td>
-<td valign="top" width="150">float (time)</td>
+<td valign="top" width="150">Real (time)</td>
 <td valign="top">The minimal amount of time for which the agent's velocities
 that are computed by the simulation are safe with respect to other agents. The
 larger this number, the sooner this agent will respond to the presence of other
@@ -548,7 +592,7 @@ positive.</td>
 </tr>
 <tr>
 <td valign="top">timeHorizonObst</td>
-<td valign="top">float (time)</td>
+<td valign="top">Real (time)</td>
 <td valign="top">The minimal amount of time for which the agent's velocities
 that are computed by the simulation are safe with respect to obstacles. The
 larger this number, the sooner this agent will respond to the presence of
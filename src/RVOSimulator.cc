@@ -38,15 +38,24 @@
 
 #include "RVOSimulator.h"
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
 #include <utility>
 
 #include "Agent.h"
+#include "AgentStore.h"
+#include "Executor.h"
 #include "KdTree.h"
 #include "Line.h"
 #include "Obstacle.h"
+#include "Snapshot.h"
 #include "Vector2.h"
 
+#if RVO_ENABLE_STATISTICS
+#include "Clock.h"
+#endif /* RVO_ENABLE_STATISTICS */
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif /* _OPENMP */
@@ -54,52 +63,183 @@
 namespace RVO {
 const std::size_t RVO_ERROR = std::numeric_limits<std::size_t>::max();
 
+namespace {
+/**
+ * @relates RVOSimulator
+ * @brief   The count of chunks of agents per thread of the executor, so that
+ *          threads that finish early can take more chunks.
+ */
+const std::size_t RVO_AGENT_CHUNKS_PER_THREAD = 8U;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The minimum count of agents per chunk of agents.
+ */
+const std::size_t RVO_MIN_AGENT_CHUNK_SIZE = 64U;
+
+/**
+ * @relates   RVOSimulator
+ * @brief     Mixes 32 bits into a 32-bit hash.
+ * @param[in] hash  The hash.
+ * @param[in] value The 32 bits to be mixed into the hash.
+ * @return    The mixed hash.
+ */
+inline unsigned long mixHash(unsigned long hash, unsigned long value) {
+  hash = ((hash ^ value) * 0x7FEB352DUL) & 0xFFFFFFFFUL;
+  hash = ((hash ^ (hash >> 15U)) * 0x846CA68BUL) & 0xFFFFFFFFUL;
+
+  return hash ^ (hash >> 16U);
+}
+
+/**
+ * @relates   RVOSimulator
+ * @brief     Mixes the bits of a real into a 32-bit hash.
+ * @param[in] hash  The hash.
+ * @param[in] value The real to be mixed into the hash.
+ * @return    The mixed hash.
+ */
+inline unsigned long mixHash(unsigned long hash, Real value) {
+  const std::size_t numWords = sizeof(Real) / sizeof(unsigned int);
+  const Real one = 1.0F;
+  unsigned int oneWords[numWords];
+  unsigned int words[numWords];
+  std::memcpy(oneWords, &one, sizeof(Real));
+  std::memcpy(words, &value, sizeof(Real));
+
+  /* The words are mixed from the most significant, the one with the exponent
+   * of one, whatever the byte order of the host. */
+  const bool isReversed = oneWords[0U] == 0U;
+
+  for (std::size_t i = 0U; i < numWords; ++i) {
+    hash = mixHash(hash, static_cast<unsigned long>(
+                             words[isReversed ? numWords - 1U - i : i]));
+  }
+
+  return hash;
+}
+} /* namespace */
+
+/**
+ * @brief Defines the task that computes the neighbors and new velocities of
+ *        the agents, one chunk of agents per item.
+ */
+class RVOSimulator::ComputeNewVelocityTask : public Executor::Task {
+ public:
+  /**
+   * @brief     Constructs a task instance.
+   * @param[in] simulator The simulator instance.
+   */
+  explicit ComputeNewVelocityTask(RVOSimulator *simulator)
+      : simulator_(simulator) {}
+
+  /**
+   * @brief     Computes the neighbors and new velocities of the agents of a
+   *            chunk.
+   * @param[in] item The number of the chunk of agents.
+   */
+  virtual void run(std::size_t item) { simulator_->computeNewVelocities(item); }
+
+ private:
+  RVOSimulator *simulator_;
+};
+
 RVOSimulator::RVOSimulator()
-    : defaultAgent_(NULL),
+    : agentStore_(new AgentStore()),
+      defaultAgent_(NULL),
+      computeNewVelocityTask_(new ComputeNewVelocityTask(this)),
+      defaultExecutor_(new DefaultExecutor()),
+      executor_(defaultExecutor_),
       kdTree_(new KdTree(this)),
+      agentReorderInterval_(0U),
+      agentTreeRebuildInterval_(1U),
+      stepsSinceAgentReorder_(0U),
+      stepNo_(0U),
       globalTime_(0.0F),
-      timeStep_(0.0F) {}
-
-RVOSimulator::RVOSimulator(float timeStep, float neighborDist,
-                           std::size_t maxNeighbors, float timeHorizon,
-                           float timeHorizonObst, float radius, float maxSpeed)
-    : defaultAgent_(new Agent()),
+      goalPerturbation_(0.0F),
+      timeStep_(0.0F),
+      agentsRemoved_(false),
+      obstaclesRemoved_(false),
+      stepInProgress_(false),
+      vectorizeORCALines_(false) {}
+
+RVOSimulator::RVOSimulator(Real timeStep, Real neighborDist,
+                           std::size_t maxNeighbors, Real timeHorizon,
+                           Real timeHorizonObst, Real radius, Real maxSpeed)
+    : agentStore_(new AgentStore()),
+      defaultAgent_(NULL),
+      computeNewVelocityTask_(new ComputeNewVelocityTask(this)),
+      defaultExecutor_(new DefaultExecutor()),
+      executor_(defaultExecutor_),
       kdTree_(new KdTree(this)),
+      agentReorderInterval_(0U),
+      agentTreeRebuildInterval_(1U),
+      stepsSinceAgentReorder_(0U),
+      stepNo_(0U),
       globalTime_(0.0F),
-      timeStep_(timeStep) {
-  defaultAgent_->maxNeighbors_ = maxNeighbors;
-  defaultAgent_->maxSpeed_ = maxSpeed;
-  defaultAgent_->neighborDist_ = neighborDist;
-  defaultAgent_->radius_ = radius;
-  defaultAgent_->timeHorizon_ = timeHorizon;
-  defaultAgent_->timeHorizonObst_ = timeHorizonObst;
-}
-
-RVOSimulator::RVOSimulator(float timeStep, float neighborDist,
-                           std::size_t maxNeighbors, float timeHorizon,
-                           float timeHorizonObst, float radius, float maxSpeed,
+      goalPerturbation_(0.0F),
+      timeStep_(timeStep),
+      agentsRemoved_(false),
+      obstaclesRemoved_(false),
+      stepInProgress_(false),
+      vectorizeORCALines_(false) {
+  setAgentDefaults(neighborDist, maxNeighbors, timeHorizon, timeHorizonObst,
+                   radius, maxSpeed, Vector2());
+}
+
+RVOSimulator::RVOSimulator(Real timeStep, Real neighborDist,
+                           std::size_t maxNeighbors, Real timeHorizon,
+                           Real timeHorizonObst, Real radius, Real maxSpeed,
                            const Vector2 &velocity)
-    : defaultAgent_(new Agent()),
+    : agentStore_(new AgentStore()),
+      defaultAgent_(NULL),
+      computeNewVelocityTask_(new ComputeNewVelocityTask(this)),
+      defaultExecutor_(new DefaultExecutor()),
+      executor_(defaultExecutor_),
       kdTree_(new KdTree(this)),
+      agentReorderInterval_(0U),
+      agentTreeRebuildInterval_(1U),
+      stepsSinceAgentReorder_(0U),
+      stepNo_(0U),
       globalTime_(0.0F),
-      timeStep_(timeStep) {
-  defaultAgent_->velocity_ = velocity;
-  defaultAgent_->maxNeighbors_ = maxNeighbors;
-  defaultAgent_->maxSpeed_ = maxSpeed;
-  defaultAgent_->neighborDist_ = neighborDist;
-  defaultAgent_->radius_ = radius;
-  defaultAgent_->timeHorizon_ = timeHorizon;
-  defaultAgent_->timeHorizonObst_ = timeHorizonObst;
+      goalPerturbation_(0.0F),
+      timeStep_(timeStep),
+      agentsRemoved_(false),
+      obstaclesRemoved_(false),
+      stepInProgress_(false),
+      vectorizeORCALines_(false) {
+  setAgentDefaults(neighborDist, maxNeighbors, timeHorizon, timeHorizonObst,
+                   radius, maxSpeed, velocity);
+}
+
+StepFuture::StepFuture() : simulator_(NULL) {}
+
+StepFuture::StepFuture(RVOSimulator *simulator) : simulator_(simulator) {}
+
+bool StepFuture::isReady() const {
+  return simulator_ == NULL || !simulator_->stepInProgress_ ||
+         simulator_->executor_->isComplete();
+}
+
+void StepFuture::wait() {
+  if (simulator_ != NULL) {
+    simulator_->completeStep();
+  }
 }
 
 RVOSimulator::~RVOSimulator() {
+  completeStep();
+
+  delete computeNewVelocityTask_;
   delete defaultAgent_;
+  delete defaultExecutor_;
   delete kdTree_;
 
   for (std::size_t i = 0U; i < agents_.size(); ++i) {
     delete agents_[i];
   }
 
+  delete agentStore_;
+
   for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
     delete obstacles_[i];
   }
@@ -107,52 +247,57 @@ RVOSimulator::~RVOSimulator() {
 
 std::size_t RVOSimulator::addAgent(const Vector2 &position) {
   if (defaultAgent_ != NULL) {
-    Agent *const agent = new Agent();
-    agent->position_ = position;
-    agent->velocity_ = defaultAgent_->velocity_;
-    agent->id_ = agents_.size();
-    agent->maxNeighbors_ = defaultAgent_->maxNeighbors_;
-    agent->maxSpeed_ = defaultAgent_->maxSpeed_;
-    agent->neighborDist_ = defaultAgent_->neighborDist_;
-    agent->radius_ = defaultAgent_->radius_;
-    agent->timeHorizon_ = defaultAgent_->timeHorizon_;
-    agent->timeHorizonObst_ = defaultAgent_->timeHorizonObst_;
-    agents_.push_back(agent);
-
-    return agents_.size() - 1U;
+    return addAgent(position, defaultAgent_->neighborDists_[0U],
+                    defaultAgent_->maxNeighbors_[0U],
+                    defaultAgent_->timeHorizons_[0U],
+                    defaultAgent_->timeHorizonObsts_[0U],
+                    defaultAgent_->radii_[0U], defaultAgent_->maxSpeeds_[0U],
+                    defaultAgent_->velocities_[0U]);
   }
 
   return RVO_ERROR;
 }
 
-std::size_t RVOSimulator::addAgent(const Vector2 &position, float neighborDist,
-                                   std::size_t maxNeighbors, float timeHorizon,
-                                   float timeHorizonObst, float radius,
-                                   float maxSpeed) {
+std::size_t RVOSimulator::addAgent(const Vector2 &position, Real neighborDist,
+                                   std::size_t maxNeighbors, Real timeHorizon,
+                                   Real timeHorizonObst, Real radius,
+                                   Real maxSpeed) {
   return addAgent(position, neighborDist, maxNeighbors, timeHorizon,
                   timeHorizonObst, radius, maxSpeed, Vector2());
 }
 
-std::size_t RVOSimulator::addAgent(const Vector2 &position, float neighborDist,
-                                   std::size_t maxNeighbors, float timeHorizon,
-                                   float timeHorizonObst, float radius,
-                                   float maxSpeed, const Vector2 &velocity) {
-  Agent *const agent = new Agent();
-  agent->position_ = position;
-  agent->velocity_ = velocity;
-  agent->id_ = agents_.size();
-  agent->maxNeighbors_ = maxNeighbors;
-  agent->maxSpeed_ = maxSpeed;
-  agent->neighborDist_ = neighborDist;
-  agent->radius_ = radius;
-  agent->timeHorizon_ = timeHorizon;
-  agent->timeHorizonObst_ = timeHorizonObst;
-  agents_.push_back(agent);
+std::size_t RVOSimulator::addAgent(const Vector2 &position, Real neighborDist,
+                                   std::size_t maxNeighbors, Real timeHorizon,
+                                   Real timeHorizonObst, Real radius,
+                                   Real maxSpeed, const Vector2 &velocity) {
+  completeStep();
+
+  const std::size_t agentNo =
+      agentStore_->addAgent(position, neighborDist, maxNeighbors, timeHorizon,
+                            timeHorizonObst, radius, maxSpeed, velocity);
+  agents_.push_back(new Agent(agentStore_, agentStore_->size() - 1U));
+
+  return agentNo;
+}
+
+std::size_t RVOSimulator::addDynamicObstacle(
+    const std::vector<Vector2> &vertices) {
+  const std::size_t obstacleNo = addObstacle(vertices);
 
-  return agents_.size() - 1U;
+  if (obstacleNo != RVO_ERROR) {
+    for (std::size_t i = obstacleNo; i < obstacles_.size(); ++i) {
+      obstacles_[i]->isDynamic_ = true;
+    }
+
+    kdTree_->addDynamicObstacle(obstacles_[obstacleNo]);
+  }
+
+  return obstacleNo;
 }
 
 std::size_t RVOSimulator::addObstacle(const std::vector<Vector2> &vertices) {
+  completeStep();
+
   if (vertices.size() > 1U) {
     const std::size_t obstacleNo = obstacles_.size();
 
@@ -193,89 +338,311 @@ std::size_t RVOSimulator::addObstacle(const std::vector<Vector2> &vertices) {
   return RVO_ERROR;
 }
 
-void RVOSimulator::doStep() {
-  kdTree_->buildAgentTree();
+void RVOSimulator::clearAgentGoal(std::size_t agentNo) {
+  agentStore_->hasGoals_[agentStore_->slots_[agentNo]] = false;
+}
+
+void RVOSimulator::completeStep() {
+  if (stepInProgress_) {
+    executor_->wait();
+
+#if RVO_ENABLE_STATISTICS
+    double time = getClockTime();
+#endif /* RVO_ENABLE_STATISTICS */
+
+    agentStore_->swapBuffers();
+
+    /* The preferred velocities computed toward the goals are only published
+     * once the step is complete, since the application may read and set the
+     * preferred velocities while it is performed. */
+    for (std::size_t i = 0U; i < agents_.size(); ++i) {
+      if (agentStore_->hasGoals_[i]) {
+        agentStore_->prefVelocities_[i] = agentStore_->stepPrefVelocities_[i];
+      }
+    }
+
+#if RVO_ENABLE_STATISTICS
+    StepStatistics &serialStatistics = chunkStatistics_.back();
+    serialStatistics.integrationTime += lapClockTime(&time);
+    serialStatistics.stepTime = time - serialStatistics.stepTime;
+    stepStatistics_ = StepStatistics();
+
+    for (std::size_t i = 0U; i < chunkStatistics_.size(); ++i) {
+      stepStatistics_ += chunkStatistics_[i];
+    }
+#endif /* RVO_ENABLE_STATISTICS */
+
+    agentsRemoved_ = false;
+    obstaclesRemoved_ = false;
+    globalTime_ += timeStep_;
+    ++stepNo_;
+    stepInProgress_ = false;
+  }
+}
+
+void RVOSimulator::computeAgentChunks() {
+  const std::size_t numThreads = executor_->getNumThreads();
+  std::size_t numChunks = 1U;
+
+  if (numThreads > 1U) {
+    numChunks = std::max<std::size_t>(
+        1U, std::min(numThreads * RVO_AGENT_CHUNKS_PER_THREAD,
+                     agents_.size() / RVO_MIN_AGENT_CHUNK_SIZE));
+  }
+
+  agentChunks_.resize(numChunks + 1U);
+  agentChunks_[0U] = 0U;
+  agentChunks_[numChunks] = agents_.size();
+
+  if (numChunks > 1U) {
+    /* Agents in dense clusters cost many times more than isolated ones, so
+     * each agent is weighted by the count of its ORCA lines. */
+    std::size_t totalCost = 0U;
+
+    for (std::size_t i = 0U; i < agents_.size(); ++i) {
+      totalCost += 1U + agents_[i]->orcaLines_.size();
+    }
+
+    const std::size_t chunkCost = totalCost / numChunks;
+    std::size_t cost = 0U;
+    std::size_t chunkNo = 1U;
+
+    for (std::size_t i = 0U; i < agents_.size() && chunkNo < numChunks; ++i) {
+      cost += 1U + agents_[i]->orcaLines_.size();
+
+      while (chunkNo < numChunks && cost >= chunkNo * chunkCost) {
+        agentChunks_[chunkNo++] = i + 1U;
+      }
+    }
+  }
+}
+
+void RVOSimulator::computeNewVelocities(std::size_t chunkNo) {
+#if RVO_ENABLE_STATISTICS
+  /* The statistics of the chunk are accumulated on the stack of its thread
+   * and stored once, since the entries of neighboring chunks may share a
+   * cache line. */
+  StepStatistics statistics;
+#endif /* RVO_ENABLE_STATISTICS */
+
+  for (std::size_t i = agentChunks_[chunkNo]; i < agentChunks_[chunkNo + 1U];
+       ++i) {
+    if (agentStore_->hasGoals_[i]) {
+      agents_[i]->computePrefVelocity(stepNo_, goalPerturbation_);
+    }
+
+#if RVO_ENABLE_STATISTICS
+    agents_[i]->statistics_ = &statistics;
+#endif /* RVO_ENABLE_STATISTICS */
 
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif /* _OPENMP */
-  for (std::size_t i = 0U; i < agents_.size(); ++i) {
     agents_[i]->computeNeighbors(kdTree_);
-    agents_[i]->computeNewVelocity(timeStep_);
+    agents_[i]->computeNewVelocity(timeStep_, vectorizeORCALines_);
   }
 
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif /* _OPENMP */
-  for (std::size_t i = 0U; i < agents_.size(); ++i) {
-    agents_[i]->update(timeStep_);
+#if RVO_ENABLE_STATISTICS
+  chunkStatistics_[chunkNo] = statistics;
+#endif /* RVO_ENABLE_STATISTICS */
+}
+
+void RVOSimulator::doStep() { doStepAsync().wait(); }
+
+StepFuture RVOSimulator::doStepAsync() {
+  completeStep();
+
+#if RVO_ENABLE_STATISTICS
+  const double startTime = getClockTime();
+#endif /* RVO_ENABLE_STATISTICS */
+
+  if (agentReorderInterval_ != 0U &&
+      ++stepsSinceAgentReorder_ >= agentReorderInterval_) {
+    reorderAgents();
   }
 
-  globalTime_ += timeStep_;
+#if RVO_ENABLE_STATISTICS
+  double time = getClockTime();
+#endif /* RVO_ENABLE_STATISTICS */
+
+  kdTree_->updateAgentTree(agentTreeRebuildInterval_);
+
+#if RVO_ENABLE_STATISTICS
+  const double agentTreeTime = lapClockTime(&time);
+#endif /* RVO_ENABLE_STATISTICS */
+
+  computeAgentChunks();
+
+#if RVO_ENABLE_STATISTICS
+  /* Each chunk of agents stores its statistics in its own entry, so that
+   * they are summed in the same order however the chunks are scheduled. The
+   * extra last entry records the phases run serially, and holds the start
+   * time of the step until it completes. */
+  chunkStatistics_.assign(agentChunks_.size(), StepStatistics());
+  chunkStatistics_.back().agentTreeTime = agentTreeTime;
+  chunkStatistics_.back().stepTime = startTime;
+#endif /* RVO_ENABLE_STATISTICS */
+
+  /* The agents read the preferred velocities of this step from a copy, so
+   * that those of the next step may be set while this one is computed. */
+  agentStore_->stepPrefVelocities_ = agentStore_->prefVelocities_;
+
+  /* The new velocities and positions are written to a second buffer, so the
+   * agents are updated in the same pass without waiting for every agent to
+   * read the present ones. */
+  executor_->submit(*computeNewVelocityTask_, agentChunks_.size() - 1U);
+  stepInProgress_ = true;
+
+  return StepFuture(this);
+}
+
+std::size_t RVOSimulator::doSteps(std::size_t numSteps) {
+  for (std::size_t i = 0U; i < numSteps; ++i) {
+    if (haveAgentsReachedGoals()) {
+      return i;
+    }
+
+    doStep();
+  }
+
+  return numSteps;
 }
 
 std::size_t RVOSimulator::getAgentAgentNeighbor(std::size_t agentNo,
                                                 std::size_t neighborNo) const {
-  return agents_[agentNo]->agentNeighbors_[neighborNo].second->id_;
+  return agentStore_->ids_[agents_[agentStore_->slots_[agentNo]]
+                               ->agentNeighbors_[neighborNo]
+                               .second];
+}
+
+std::size_t RVOSimulator::getAgentBufferIndex(std::size_t agentNo) const {
+  return agentStore_->slots_[agentNo];
+}
+
+std::size_t RVOSimulator::getAgentGeneration(std::size_t agentNo) const {
+  return agentStore_->generations_[agentNo];
+}
+
+const Vector2 &RVOSimulator::getAgentGoal(std::size_t agentNo) const {
+  return agentStore_->goals_[agentStore_->slots_[agentNo]];
 }
 
 std::size_t RVOSimulator::getAgentMaxNeighbors(std::size_t agentNo) const {
-  return agents_[agentNo]->maxNeighbors_;
+  return agentStore_->maxNeighbors_[agentStore_->slots_[agentNo]];
 }
 
-float RVOSimulator::getAgentMaxSpeed(std::size_t agentNo) const {
-  return agents_[agentNo]->maxSpeed_;
+Real RVOSimulator::getAgentMaxSpeed(std::size_t agentNo) const {
+  return agentStore_->maxSpeeds_[agentStore_->slots_[agentNo]];
 }
 
-float RVOSimulator::getAgentNeighborDist(std::size_t agentNo) const {
-  return agents_[agentNo]->neighborDist_;
+Real RVOSimulator::getAgentNeighborDist(std::size_t agentNo) const {
+  return agentStore_->neighborDists_[agentStore_->slots_[agentNo]];
+}
+
+std::size_t RVOSimulator::getAgentNo(std::size_t bufferIndex) const {
+  return agentStore_->ids_[bufferIndex];
 }
 
 std::size_t RVOSimulator::getAgentNumAgentNeighbors(std::size_t agentNo) const {
-  return agents_[agentNo]->agentNeighbors_.size();
+  /* The agent neighbors refer to buffer indices that removing an agent may
+   * have changed. */
+  return agentsRemoved_
+             ? 0U
+             : agents_[agentStore_->slots_[agentNo]]->agentNeighbors_.size();
 }
 
 std::size_t RVOSimulator::getAgentNumObstacleNeighbors(
     std::size_t agentNo) const {
-  return agents_[agentNo]->obstacleNeighbors_.size();
+  /* The obstacle neighbors may refer to the vertices of removed obstacles. */
+  return obstaclesRemoved_
+             ? 0U
+             : agents_[agentStore_->slots_[agentNo]]->obstacleNeighbors_.size();
 }
 
 std::size_t RVOSimulator::getAgentNumORCALines(std::size_t agentNo) const {
-  return agents_[agentNo]->orcaLines_.size();
+  return agents_[agentStore_->slots_[agentNo]]->orcaLines_.size();
 }
 
 std::size_t RVOSimulator::getAgentObstacleNeighbor(
     std::size_t agentNo, std::size_t neighborNo) const {
-  return agents_[agentNo]->obstacleNeighbors_[neighborNo].second->id_;
+  return agents_[agentStore_->slots_[agentNo]]
+      ->obstacleNeighbors_[neighborNo]
+      .second->id_;
 }
 
 const Line &RVOSimulator::getAgentORCALine(std::size_t agentNo,
                                            std::size_t lineNo) const {
-  return agents_[agentNo]->orcaLines_[lineNo];
+  return agents_[agentStore_->slots_[agentNo]]->orcaLines_[lineNo];
 }
 
 const Vector2 &RVOSimulator::getAgentPosition(std::size_t agentNo) const {
-  return agents_[agentNo]->position_;
+  return agentStore_->positions_[agentStore_->slots_[agentNo]];
+}
+
+const Vector2 *RVOSimulator::getAgentPositionBuffer() const {
+  return agentStore_->positions_.empty() ? NULL : &agentStore_->positions_[0U];
+}
+
+void RVOSimulator::getAgentPositions(Vector2 *positions) const {
+  std::size_t i = 0U;
+
+  for (std::size_t agentNo = 0U; agentNo < agentStore_->slots_.size();
+       ++agentNo) {
+    const std::size_t slot = agentStore_->slots_[agentNo];
+
+    if (slot != RVO_ERROR) {
+      positions[i++] = agentStore_->positions_[slot];
+    }
+  }
+}
+
+void RVOSimulator::getAgentPrefVelocities(Vector2 *prefVelocities) const {
+  std::size_t i = 0U;
+
+  for (std::size_t agentNo = 0U; agentNo < agentStore_->slots_.size();
+       ++agentNo) {
+    const std::size_t slot = agentStore_->slots_[agentNo];
+
+    if (slot != RVO_ERROR) {
+      prefVelocities[i++] = agentStore_->prefVelocities_[slot];
+    }
+  }
 }
 
 const Vector2 &RVOSimulator::getAgentPrefVelocity(std::size_t agentNo) const {
-  return agents_[agentNo]->prefVelocity_;
+  return agentStore_->prefVelocities_[agentStore_->slots_[agentNo]];
 }
 
-float RVOSimulator::getAgentRadius(std::size_t agentNo) const {
-  return agents_[agentNo]->radius_;
+Real RVOSimulator::getAgentRadius(std::size_t agentNo) const {
+  return agentStore_->radii_[agentStore_->slots_[agentNo]];
 }
 
-float RVOSimulator::getAgentTimeHorizon(std::size_t agentNo) const {
-  return agents_[agentNo]->timeHorizon_;
+Real RVOSimulator::getAgentTimeHorizon(std::size_t agentNo) const {
+  return agentStore_->timeHorizons_[agentStore_->slots_[agentNo]];
 }
 
-float RVOSimulator::getAgentTimeHorizonObst(std::size_t agentNo) const {
-  return agents_[agentNo]->timeHorizonObst_;
+Real RVOSimulator::getAgentTimeHorizonObst(std::size_t agentNo) const {
+  return agentStore_->timeHorizonObsts_[agentStore_->slots_[agentNo]];
+}
+
+void RVOSimulator::getAgentVelocities(Vector2 *velocities) const {
+  std::size_t i = 0U;
+
+  for (std::size_t agentNo = 0U; agentNo < agentStore_->slots_.size();
+       ++agentNo) {
+    const std::size_t slot = agentStore_->slots_[agentNo];
+
+    if (slot != RVO_ERROR) {
+      velocities[i++] = agentStore_->velocities_[slot];
+    }
+  }
 }
 
 const Vector2 &RVOSimulator::getAgentVelocity(std::size_t agentNo) const {
-  return agents_[agentNo]->velocity_;
+  return agentStore_->velocities_[agentStore_->slots_[agentNo]];
+}
+
+
+const Vector2 *RVOSimulator::getAgentVelocityBuffer() const {
+  return agentStore_->velocities_.empty() ? NULL
+                                          : &agentStore_->velocities_[0U];
 }
 
 const Vector2 &RVOSimulator::getObstacleVertex(std::size_t vertexNo) const {
@@ -290,7 +657,151 @@ std::size_t RVOSimulator::getPrevObstacleVertexNo(std::size_t vertexNo) const {
   return obstacles_[vertexNo]->previous_->id_;
 }
 
-void RVOSimulator::processObstacles() { kdTree_->buildObstacleTree(); }
+unsigned long RVOSimulator::getStateHash() const {
+  unsigned long hash = mixHash(0x811C9DC5UL, globalTime_);
+  hash = mixHash(hash, static_cast<unsigned long>(agents_.size()));
+
+  for (std::size_t agentNo = 0U; agentNo < agentStore_->slots_.size();
+       ++agentNo) {
+    const std::size_t slot = agentStore_->slots_[agentNo];
+
+    if (slot != RVO_ERROR) {
+      const Vector2 &position = agentStore_->positions_[slot];
+      const Vector2 &velocity = agentStore_->velocities_[slot];
+
+      hash = mixHash(hash, static_cast<unsigned long>(agentNo));
+      hash = mixHash(hash, position.x());
+      hash = mixHash(hash, position.y());
+      hash = mixHash(hash, velocity.x());
+      hash = mixHash(hash, velocity.y());
+    }
+  }
+
+  return hash;
+}
+
+bool RVOSimulator::hasAgentGoal(std::size_t agentNo) const {
+  return agentStore_->hasGoals_[agentStore_->slots_[agentNo]];
+}
+
+bool RVOSimulator::hasAgentReachedGoal(std::size_t agentNo) const {
+  const std::size_t slot = agentStore_->slots_[agentNo];
+  const Real goalRadius = agentStore_->goalRadii_[slot];
+
+  return agentStore_->hasGoals_[slot] &&
+         absSq(agentStore_->goals_[slot] - agentStore_->positions_[slot]) <=
+             goalRadius * goalRadius;
+}
+
+bool RVOSimulator::haveAgentsReachedGoals() const {
+  bool hasGoals = false;
+
+  for (std::size_t i = 0U; i < agentStore_->size(); ++i) {
+    if (agentStore_->hasGoals_[i]) {
+      const Real goalRadius = agentStore_->goalRadii_[i];
+
+      if (absSq(agentStore_->goals_[i] - agentStore_->positions_[i]) >
+          goalRadius * goalRadius) {
+        return false;
+      }
+
+      hasGoals = true;
+    }
+  }
+
+  return hasGoals;
+}
+
+bool RVOSimulator::loadSnapshot(std::istream &stream) {
+  completeStep();
+
+  SnapshotReader reader(&stream);
+  std::size_t agentReorderInterval = 0U;
+  std::size_t agentTreeRebuildInterval = 0U;
+  std::size_t stepsSinceAgentReorder = 0U;
+  std::size_t stepNo = 0U;
+  Real globalTime = 0.0F;
+  Real goalPerturbation = 0.0F;
+  Real timeStep = 0.0F;
+  bool hasDefaultAgent = false;
+
+  if (!reader.readHeader() || !reader.readReal(&timeStep) ||
+      !reader.readReal(&globalTime) || !reader.readReal(&goalPerturbation) ||
+      !reader.readSize(&stepNo) || !reader.readSize(&agentReorderInterval) ||
+      !reader.readSize(&agentTreeRebuildInterval) ||
+      !reader.readSize(&stepsSinceAgentReorder) ||
+      !reader.readBool(&hasDefaultAgent)) {
+    return false;
+  }
+
+  /* The snapshot is read in full before the simulation is changed. The
+   * obstacle k-D tree is read last, since it replaces that of the simulation
+   * once it is read. */
+  AgentStore *const defaultAgent = hasDefaultAgent ? new AgentStore() : NULL;
+  AgentStore *const agentStore = new AgentStore();
+  std::vector<Obstacle *> obstacles;
+
+  const bool isRead =
+      (defaultAgent == NULL || (defaultAgent->readSnapshot(&reader) &&
+                                defaultAgent->size() == 1U)) &&
+      agentStore->readSnapshot(&reader) && readObstacles(&reader, &obstacles) &&
+      kdTree_->readObstacleTrees(&reader, obstacles);
+
+  if (!isRead) {
+    delete defaultAgent;
+    delete agentStore;
+
+    for (std::size_t i = 0U; i < obstacles.size(); ++i) {
+      delete obstacles[i];
+    }
+
+    return false;
+  }
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    delete agents_[i];
+  }
+
+  for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
+    delete obstacles_[i];
+  }
+
+  delete agentStore_;
+  delete defaultAgent_;
+
+  agentStore_ = agentStore;
+  defaultAgent_ = defaultAgent;
+  obstacles_.swap(obstacles);
+  agents_.resize(agentStore_->size());
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    agents_[i] = new Agent(agentStore_, i);
+  }
+
+  /* The agent k-D tree is rebuilt in the next simulation step. */
+  kdTree_->agents_.clear();
+
+  agentReorderInterval_ = agentReorderInterval;
+  agentTreeRebuildInterval_ = agentTreeRebuildInterval;
+  stepsSinceAgentReorder_ = stepsSinceAgentReorder;
+  stepNo_ = stepNo;
+  globalTime_ = globalTime;
+  goalPerturbation_ = goalPerturbation;
+  timeStep_ = timeStep;
+  agentsRemoved_ = false;
+  obstaclesRemoved_ = false;
+
+  return true;
+}
+
+void RVOSimulator::processObstacles() {
+  processObstacles(std::numeric_limits<std::size_t>::max());
+}
+
+void RVOSimulator::processObstacles(std::size_t maxSplitCandidates) {
+  completeStep();
+  kdTree_->buildObstacleTree(maxSplitCandidates);
+}
 
 bool RVOSimulator::queryVisibility(const Vector2 &point1,
                                    const Vector2 &point2) const {
@@ -298,74 +809,313 @@ bool RVOSimulator::queryVisibility(const Vector2 &point1,
 }
 
 bool RVOSimulator::queryVisibility(const Vector2 &point1, const Vector2 &point2,
-                                   float radius) const {
+                                   Real radius) const {
   return kdTree_->queryVisibility(point1, point2, radius);
 }
 
-void RVOSimulator::setAgentDefaults(float neighborDist,
-                                    std::size_t maxNeighbors, float timeHorizon,
-                                    float timeHorizonObst, float radius,
-                                    float maxSpeed) {
+bool RVOSimulator::readObstacles(SnapshotReader *reader,
+                                 std::vector<Obstacle *> *obstacles) const {
+  std::size_t numObstacles = 0U;
+  std::vector<Vector2> directions;
+  std::vector<Vector2> points;
+  std::vector<std::size_t> nextNos;
+  std::vector<std::size_t> previousNos;
+  std::vector<bool> areConvex;
+  std::vector<bool> areDynamic;
+  std::vector<bool> arePresent;
+
+  if (!reader->readSize(&numObstacles) ||
+      !reader->readBools(numObstacles, &arePresent) ||
+      !reader->readVector2s(numObstacles, &directions) ||
+      !reader->readVector2s(numObstacles, &points) ||
+      !reader->readSizes(numObstacles, &nextNos) ||
+      !reader->readSizes(numObstacles, &previousNos) ||
+      !reader->readBools(numObstacles, &areConvex) ||
+      !reader->readBools(numObstacles, &areDynamic)) {
+    return false;
+  }
+
+  obstacles->assign(numObstacles, NULL);
+
+  for (std::size_t i = 0U; i < numObstacles; ++i) {
+    if (arePresent[i]) {
+      Obstacle *const obstacle = new Obstacle();
+      obstacle->direction_ = directions[i];
+      obstacle->point_ = points[i];
+      obstacle->id_ = i;
+      obstacle->isConvex_ = areConvex[i];
+      obstacle->isDynamic_ = areDynamic[i];
+      (*obstacles)[i] = obstacle;
+    }
+  }
+
+  for (std::size_t i = 0U; i < numObstacles; ++i) {
+    if (arePresent[i]) {
+      if (nextNos[i] >= numObstacles || !arePresent[nextNos[i]] ||
+          previousNos[i] >= numObstacles || !arePresent[previousNos[i]]) {
+        return false;
+      }
+
+      (*obstacles)[i]->next_ = (*obstacles)[nextNos[i]];
+      (*obstacles)[i]->previous_ = (*obstacles)[previousNos[i]];
+    }
+  }
+
+  /* The vertices of an obstacle must form a cycle of a single kind. */
+  for (std::size_t i = 0U; i < numObstacles; ++i) {
+    const Obstacle *const obstacle = (*obstacles)[i];
+
+    if (obstacle != NULL &&
+        (obstacle->next_->previous_ != obstacle ||
+         obstacle->previous_->next_ != obstacle ||
+         obstacle->next_->isDynamic_ != obstacle->isDynamic_)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void RVOSimulator::removeAgent(std::size_t agentNo) {
+  completeStep();
+
+  if (agentNo >= agentStore_->slots_.size() ||
+      agentStore_->slots_[agentNo] == RVO_ERROR) {
+    return;
+  }
+
+  const std::size_t slot = agentStore_->slots_[agentNo];
+  agentStore_->removeAgent(agentNo);
+
+  delete agents_[slot];
+  agents_[slot] = agents_.back();
+  agents_.pop_back();
+
+  if (slot < agents_.size()) {
+    agents_[slot]->id_ = slot;
+  }
+
+  agentsRemoved_ = true;
+}
+
+void RVOSimulator::removeObstacle(std::size_t obstacleNo) {
+  completeStep();
+
+  /* The vertices of a dynamic obstacle have consecutive numbers, so only its
+   * first vertex is preceded by a vertex with a greater number. */
+  if (obstacleNo >= obstacles_.size() || obstacles_[obstacleNo] == NULL ||
+      !obstacles_[obstacleNo]->isDynamic_ ||
+      obstacles_[obstacleNo]->previous_->id_ < obstacleNo) {
+    return;
+  }
+
+  kdTree_->removeDynamicObstacle(obstacles_[obstacleNo]);
+
+  const std::size_t lastVertexNo = obstacles_[obstacleNo]->previous_->id_;
+
+  for (std::size_t i = obstacleNo; i <= lastVertexNo; ++i) {
+    delete obstacles_[i];
+    obstacles_[i] = NULL;
+  }
+
+  obstaclesRemoved_ = true;
+}
+
+void RVOSimulator::reorderAgents() {
+  std::vector<std::size_t> order;
+  agentStore_->computeMortonOrder(order);
+  agentStore_->reorder(order);
+
+  std::vector<Agent *> agents(agents_.size());
+
+  for (std::size_t i = 0U; i < order.size(); ++i) {
+    agents[i] = agents_[order[i]];
+    agents[i]->id_ = i;
+  }
+
+  agents_.swap(agents);
+  kdTree_->remapAgents(order);
+  stepsSinceAgentReorder_ = 0U;
+}
+
+bool RVOSimulator::saveSnapshot(std::ostream &stream) {
+  completeStep();
+
+  SnapshotWriter writer(&stream);
+  writer.writeHeader();
+  writer.writeReal(timeStep_);
+  writer.writeReal(globalTime_);
+  writer.writeReal(goalPerturbation_);
+  writer.writeSize(stepNo_);
+  writer.writeSize(agentReorderInterval_);
+  writer.writeSize(agentTreeRebuildInterval_);
+  writer.writeSize(stepsSinceAgentReorder_);
+  writer.writeBool(defaultAgent_ != NULL);
+
+  if (defaultAgent_ != NULL) {
+    defaultAgent_->writeSnapshot(&writer);
+  }
+
+  agentStore_->writeSnapshot(&writer);
+  writeObstacles(&writer);
+  kdTree_->writeObstacleTrees(&writer);
+
+  return writer.flush();
+}
+
+void RVOSimulator::setAgentDefaults(Real neighborDist,
+                                    std::size_t maxNeighbors, Real timeHorizon,
+                                    Real timeHorizonObst, Real radius,
+                                    Real maxSpeed) {
   setAgentDefaults(neighborDist, maxNeighbors, timeHorizon, timeHorizonObst,
                    radius, maxSpeed, Vector2());
 }
 
-void RVOSimulator::setAgentDefaults(float neighborDist,
-                                    std::size_t maxNeighbors, float timeHorizon,
-                                    float timeHorizonObst, float radius,
-                                    float maxSpeed, const Vector2 &velocity) {
+void RVOSimulator::setAgentDefaults(Real neighborDist,
+                                    std::size_t maxNeighbors, Real timeHorizon,
+                                    Real timeHorizonObst, Real radius,
+                                    Real maxSpeed, const Vector2 &velocity) {
   if (defaultAgent_ == NULL) {
-    defaultAgent_ = new Agent();
+    defaultAgent_ = new AgentStore();
+    defaultAgent_->addAgent(Vector2(), neighborDist, maxNeighbors, timeHorizon,
+                            timeHorizonObst, radius, maxSpeed, velocity);
+  } else {
+    defaultAgent_->maxNeighbors_[0U] = maxNeighbors;
+    defaultAgent_->maxSpeeds_[0U] = maxSpeed;
+    defaultAgent_->neighborDists_[0U] = neighborDist;
+    defaultAgent_->radii_[0U] = radius;
+    defaultAgent_->timeHorizons_[0U] = timeHorizon;
+    defaultAgent_->timeHorizonObsts_[0U] = timeHorizonObst;
+    defaultAgent_->velocities_[0U] = velocity;
   }
+}
 
-  defaultAgent_->maxNeighbors_ = maxNeighbors;
-  defaultAgent_->maxSpeed_ = maxSpeed;
-  defaultAgent_->neighborDist_ = neighborDist;
-  defaultAgent_->radius_ = radius;
-  defaultAgent_->timeHorizon_ = timeHorizon;
-  defaultAgent_->timeHorizonObst_ = timeHorizonObst;
-  defaultAgent_->velocity_ = velocity;
+void RVOSimulator::setAgentGoal(std::size_t agentNo, const Vector2 &goal,
+                                Real speed, Real arrivalRadius) {
+  const std::size_t slot = agentStore_->slots_[agentNo];
+  agentStore_->goals_[slot] = goal;
+  agentStore_->goalRadii_[slot] = arrivalRadius;
+  agentStore_->goalSpeeds_[slot] = speed;
+  agentStore_->hasGoals_[slot] = true;
 }
 
 void RVOSimulator::setAgentMaxNeighbors(std::size_t agentNo,
                                         std::size_t maxNeighbors) {
-  agents_[agentNo]->maxNeighbors_ = maxNeighbors;
+  agentStore_->maxNeighbors_[agentStore_->slots_[agentNo]] = maxNeighbors;
 }
 
-void RVOSimulator::setAgentMaxSpeed(std::size_t agentNo, float maxSpeed) {
-  agents_[agentNo]->maxSpeed_ = maxSpeed;
+void RVOSimulator::setAgentMaxSpeed(std::size_t agentNo, Real maxSpeed) {
+  agentStore_->maxSpeeds_[agentStore_->slots_[agentNo]] = maxSpeed;
 }
 
 void RVOSimulator::setAgentNeighborDist(std::size_t agentNo,
-                                        float neighborDist) {
-  agents_[agentNo]->neighborDist_ = neighborDist;
+                                        Real neighborDist) {
+  agentStore_->neighborDists_[agentStore_->slots_[agentNo]] = neighborDist;
 }
 
 void RVOSimulator::setAgentPosition(std::size_t agentNo,
                                     const Vector2 &position) {
-  agents_[agentNo]->position_ = position;
+  agentStore_->positions_[agentStore_->slots_[agentNo]] = position;
+}
+
+void RVOSimulator::setAgentPositions(const Vector2 *positions,
+                                     std::size_t count) {
+  std::size_t i = 0U;
+
+  for (std::size_t agentNo = 0U; i < count; ++agentNo) {
+    const std::size_t slot = agentStore_->slots_[agentNo];
+
+    if (slot != RVO_ERROR) {
+      agentStore_->positions_[slot] = positions[i++];
+    }
+  }
 }
 
 void RVOSimulator::setAgentPrefVelocity(std::size_t agentNo,
                                         const Vector2 &prefVelocity) {
-  agents_[agentNo]->prefVelocity_ = prefVelocity;
+  agentStore_->prefVelocities_[agentStore_->slots_[agentNo]] = prefVelocity;
+}
+
+void RVOSimulator::setAgentPrefVelocities(const Vector2 *prefVelocities,
+                                          std::size_t count) {
+  std::size_t i = 0U;
+
+  for (std::size_t agentNo = 0U; i < count; ++agentNo) {
+    const std::size_t slot = agentStore_->slots_[agentNo];
+
+    if (slot != RVO_ERROR) {
+      agentStore_->prefVelocities_[slot] = prefVelocities[i++];
+    }
+  }
 }
 
-void RVOSimulator::setAgentRadius(std::size_t agentNo, float radius) {
-  agents_[agentNo]->radius_ = radius;
+void RVOSimulator::setAgentRadius(std::size_t agentNo, Real radius) {
+  agentStore_->radii_[agentStore_->slots_[agentNo]] = radius;
 }
 
-void RVOSimulator::setAgentTimeHorizon(std::size_t agentNo, float timeHorizon) {
-  agents_[agentNo]->timeHorizon_ = timeHorizon;
+void RVOSimulator::setAgentTimeHorizon(std::size_t agentNo, Real timeHorizon) {
+  agentStore_->timeHorizons_[agentStore_->slots_[agentNo]] = timeHorizon;
 }
 
 void RVOSimulator::setAgentTimeHorizonObst(std::size_t agentNo,
-                                           float timeHorizonObst) {
-  agents_[agentNo]->timeHorizonObst_ = timeHorizonObst;
+                                           Real timeHorizonObst) {
+  agentStore_->timeHorizonObsts_[agentStore_->slots_[agentNo]] =
+      timeHorizonObst;
+}
+
+void RVOSimulator::setAgentVelocities(const Vector2 *velocities,
+                                      std::size_t count) {
+  std::size_t i = 0U;
+
+  for (std::size_t agentNo = 0U; i < count; ++agentNo) {
+    const std::size_t slot = agentStore_->slots_[agentNo];
+
+    if (slot != RVO_ERROR) {
+      agentStore_->velocities_[slot] = velocities[i++];
+    }
+  }
 }
 
 void RVOSimulator::setAgentVelocity(std::size_t agentNo,
                                     const Vector2 &velocity) {
-  agents_[agentNo]->velocity_ = velocity;
+  agentStore_->velocities_[agentStore_->slots_[agentNo]] = velocity;
+}
+
+void RVOSimulator::setExecutor(Executor *executor) {
+  completeStep();
+  executor_ = executor != NULL ? executor : defaultExecutor_;
+}
+
+void RVOSimulator::writeObstacles(SnapshotWriter *writer) const {
+  std::vector<Vector2> directions(obstacles_.size());
+  std::vector<Vector2> points(obstacles_.size());
+  std::vector<std::size_t> nextNos(obstacles_.size(), RVO_ERROR);
+  std::vector<std::size_t> previousNos(obstacles_.size(), RVO_ERROR);
+  std::vector<bool> areConvex(obstacles_.size(), false);
+  std::vector<bool> areDynamic(obstacles_.size(), false);
+  std::vector<bool> arePresent(obstacles_.size(), false);
+
+  for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
+    const Obstacle *const obstacle = obstacles_[i];
+
+    if (obstacle != NULL) {
+      directions[i] = obstacle->direction_;
+      points[i] = obstacle->point_;
+      nextNos[i] = obstacle->next_->id_;
+      previousNos[i] = obstacle->previous_->id_;
+      areConvex[i] = obstacle->isConvex_;
+      areDynamic[i] = obstacle->isDynamic_;
+      arePresent[i] = true;
+    }
+  }
+
+  writer->writeSize(obstacles_.size());
+  writer->writeBools(arePresent);
+  writer->writeVector2s(directions);
+  writer->writeVector2s(points);
+  writer->writeSizes(nextNos);
+  writer->writeSizes(previousNos);
+  writer->writeBools(areConvex);
+  writer->writeBools(areDynamic);
 }
 } /* namespace RVO */
@@ -40,15 +40,24 @@
  */
 
 #include <cstddef>
+#include <iosfwd>
 #include <vector>
 
 #include "Export.h"
+#include "Real.h"
+#include "StepStatistics.h"
 
 namespace RVO {
 class Agent;
+class AgentStore;
+class DefaultExecutor;
+class Executor;
 class KdTree;
 class Line;
 class Obstacle;
+class RVOSimulator;
+class SnapshotReader;
+class SnapshotWriter;
 class Vector2;
 
 /**
@@ -58,6 +67,44 @@ class Vector2;
  */
 RVO_EXPORT extern const std::size_t RVO_ERROR;
 
+/**
+ * @brief Defines a handle to a simulation step started by
+ *        RVOSimulator::doStepAsync().
+ */
+class RVO_EXPORT StepFuture {
+ public:
+  /**
+   * @brief Constructs a handle that refers to no simulation step.
+   */
+  StepFuture();
+
+  /**
+   * @brief  Returns whether the simulation step has been computed, so that
+   *         wait() does not block.
+   * @return True if the simulation step has been computed or has been
+   *         completed; false otherwise.
+   */
+  bool isReady() const;
+
+  /**
+   * @brief Waits until the simulation step has been computed and completes
+   *        it, making the new positions and velocities of the agents the
+   *        present ones. Does nothing if the step has already been completed.
+   */
+  void wait();
+
+ private:
+  /**
+   * @brief     Constructs a handle to the simulation step in progress.
+   * @param[in] simulator The simulator instance.
+   */
+  explicit StepFuture(RVOSimulator *simulator);
+
+  RVOSimulator *simulator_;
+
+  friend class RVOSimulator;
+};
+
 /**
  * @brief Defines the simulation. The main class of the library that contains
  *        all simulation functionality.
@@ -105,9 +152,9 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] maxSpeed        The default maximum speed of a new agent. Must
    *                            be non-negative.
    */
-  RVOSimulator(float timeStep, float neighborDist, std::size_t maxNeighbors,
-               float timeHorizon, float timeHorizonObst, float radius,
-               float maxSpeed);
+  RVOSimulator(Real timeStep, Real neighborDist, std::size_t maxNeighbors,
+               Real timeHorizon, Real timeHorizonObst, Real radius,
+               Real maxSpeed);
 
   /**
    * @brief     Constructs a simulator instance and sets the default properties
@@ -147,9 +194,9 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] velocity        The default initial two-dimensional linear
    *                            velocity of a new agent.
    */
-  RVOSimulator(float timeStep, float neighborDist, std::size_t maxNeighbors,
-               float timeHorizon, float timeHorizonObst, float radius,
-               float maxSpeed, const Vector2 &velocity);
+  RVOSimulator(Real timeStep, Real neighborDist, std::size_t maxNeighbors,
+               Real timeHorizon, Real timeHorizonObst, Real radius,
+               Real maxSpeed, const Vector2 &velocity);
 
   /**
    * @brief Destroys this simulator instance.
@@ -199,9 +246,9 @@ class RVO_EXPORT RVOSimulator {
    *                            non-negative.
    * @return    The number of the agent.
    */
-  std::size_t addAgent(const Vector2 &position, float neighborDist,
-                       std::size_t maxNeighbors, float timeHorizon,
-                       float timeHorizonObst, float radius, float maxSpeed);
+  std::size_t addAgent(const Vector2 &position, Real neighborDist,
+                       std::size_t maxNeighbors, Real timeHorizon,
+                       Real timeHorizonObst, Real radius, Real maxSpeed);
 
   /**
    * @brief     Adds a new agent to the simulation.
@@ -240,11 +287,27 @@ class RVO_EXPORT RVOSimulator {
    *                            this agent.
    * @return    The number of the agent.
    */
-  std::size_t addAgent(const Vector2 &position, float neighborDist,
-                       std::size_t maxNeighbors, float timeHorizon,
-                       float timeHorizonObst, float radius, float maxSpeed,
+  std::size_t addAgent(const Vector2 &position, Real neighborDist,
+                       std::size_t maxNeighbors, Real timeHorizon,
+                       Real timeHorizonObst, Real radius, Real maxSpeed,
                        const Vector2 &velocity);
 
+  /**
+   * @brief     Adds a new dynamic obstacle to the simulation. Unlike the
+   *            obstacles processed by processObstacles(), a dynamic obstacle
+   *            is accounted for in the simulation immediately, and it may be
+   *            removed with removeObstacle().
+   * @param[in] vertices List of the vertices of the polygonal obstacle in
+   *                     counterclockwise order.
+   * @return    The number of the first vertex of the obstacle, or
+   *            RVO::RVO_ERROR when the number of vertices is less than two.
+   * @note      Dynamic obstacles are kept in a separate k-D tree of bounding
+   *            boxes that is rebuilt whenever one is added or removed, so they
+   *            are best suited to a modest count of obstacles such as doors
+   *            and vehicles.
+   */
+  std::size_t addDynamicObstacle(const std::vector<Vector2> &vertices);
+
   /**
    * @brief     Adds a new obstacle to the simulation.
    * @param[in] vertices List of the vertices of the polygonal obstacle in
@@ -257,12 +320,66 @@ class RVO_EXPORT RVOSimulator {
    */
   std::size_t addObstacle(const std::vector<Vector2> &vertices);
 
+  /**
+   * @brief     Clears the goal of a specified agent, so that its preferred
+   *            velocity is again set only by setAgentPrefVelocity().
+   * @param[in] agentNo The number of the agent whose goal is to be cleared.
+   */
+  void clearAgentGoal(std::size_t agentNo);
+
   /**
    * @brief Lets the simulator perform a simulation step and updates the
    *        two-dimensional position and two-dimensional velocity of each agent.
    */
   void doStep();
 
+  /**
+   * @brief  Lets the simulator start a simulation step on its executor and
+   *         returns without waiting for the step to be computed, if the
+   *         executor supports it, as the default executor does with more than
+   *         one thread. A simulation step that is still in progress is
+   *         completed first.
+   * @return A handle with which to wait for the simulation step.
+   * @note   Until the step has been completed, the getters of the positions,
+   *         velocities, preferred velocities, and properties of the agents
+   *         and the global time return the state of the last completed step,
+   *         and the preferred velocities of the agents for the following step
+   *         may be set. No other function may be called except doStep(),
+   *         doStepAsync(), and those that add or remove agents or obstacles,
+   *         which complete the step first.
+   */
+  StepFuture doStepAsync();
+
+  /**
+   * @brief     Lets the simulator perform a count of simulation steps without
+   *            returning in between. The preferred velocities of the agents
+   *            that have goals are computed in each step.
+   * @param[in] numSteps The maximum count of simulation steps to perform.
+   * @return    The count of simulation steps performed, which is less than the
+   *            maximum count if every agent that has a goal has reached it.
+   */
+  std::size_t doSteps(std::size_t numSteps);
+
+  /**
+   * @brief  Returns the count of simulation steps between reorderings of the
+   *         agents along a space-filling curve.
+   * @return The present count of simulation steps between reorderings of the
+   *         agents, or zero if the agents are never reordered.
+   */
+  std::size_t getAgentReorderInterval() const {
+    return agentReorderInterval_;
+  }
+
+  /**
+   * @brief  Returns the count of simulation steps between full rebuilds of
+   *         the agent k-D tree.
+   * @return The present count of simulation steps between full rebuilds of
+   *         the agent k-D tree.
+   */
+  std::size_t getAgentTreeRebuildInterval() const {
+    return agentTreeRebuildInterval_;
+  }
+
   /**
    * @brief     Returns the specified agent neighbor of the specified agent.
    * @param[in] agentNo    The number of the agent whose agent neighbor is to be
@@ -273,6 +390,35 @@ class RVO_EXPORT RVOSimulator {
   std::size_t getAgentAgentNeighbor(std::size_t agentNo,
                                     std::size_t neighborNo) const;
 
+  /**
+   * @brief     Returns the index of a specified agent in the position and
+   *            velocity buffers.
+   * @param[in] agentNo The number of the agent whose buffer index is to be
+   *                    retrieved.
+   * @return    The present buffer index of the agent. It equals the number of
+   *            the agent unless the agents have been reordered.
+   */
+  std::size_t getAgentBufferIndex(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the generation of a specified agent number, which is
+   *            the count of agents with that number that have been removed.
+   * @param[in] agentNo The agent number whose generation is to be retrieved.
+   * @return    The generation of the agent number.
+   * @note      An agent number is reused after its agent is removed. An
+   *            application that may hold the number of a removed agent keeps
+   *            the generation returned just after adding the agent, and
+   *            treats the number as stale when the generation differs.
+   */
+  std::size_t getAgentGeneration(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the goal of a specified agent.
+   * @param[in] agentNo The number of the agent whose goal is to be retrieved.
+   * @return    The two-dimensional position of the goal of the agent.
+   */
+  const Vector2 &getAgentGoal(std::size_t agentNo) const;
+
   /**
    * @brief     Returns the maximum neighbor count of a specified agent.
    * @param[in] agentNo The number of the agent whose maximum neighbor count is
@@ -287,7 +433,7 @@ class RVO_EXPORT RVOSimulator {
    *                    retrieved.
    * @return    The present maximum speed of the agent.
    */
-  float getAgentMaxSpeed(std::size_t agentNo) const;
+  Real getAgentMaxSpeed(std::size_t agentNo) const;
 
   /**
    * @brief     Returns the maximum neighbor distance of a specified agent.
@@ -295,7 +441,16 @@ class RVO_EXPORT RVOSimulator {
    *                    is to be retrieved.
    * @return    The present maximum neighbor distance of the agent.
    */
-  float getAgentNeighborDist(std::size_t agentNo) const;
+  Real getAgentNeighborDist(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the number of the agent at a specified index of the
+   *            position and velocity buffers.
+   * @param[in] bufferIndex The buffer index of the agent whose number is to be
+   *                        retrieved. Must be less than getNumAgents().
+   * @return    The number of the agent.
+   */
+  std::size_t getAgentNo(std::size_t bufferIndex) const;
 
   /**
    * @brief     Returns the count of agent neighbors taken into account to
@@ -304,6 +459,8 @@ class RVO_EXPORT RVOSimulator {
    *                    is to be retrieved.
    * @return    The count of agent neighbors taken into account to compute the
    *            current velocity for the specified agent.
+   * @note      The count is zero after an agent is removed, until the next
+   *            simulation step.
    */
   std::size_t getAgentNumAgentNeighbors(std::size_t agentNo) const;
 
@@ -357,6 +514,39 @@ class RVO_EXPORT RVOSimulator {
    */
   const Vector2 &getAgentPosition(std::size_t agentNo) const;
 
+  /**
+   * @brief  Returns a read-only view of the two-dimensional positions of all
+   *         agents, stored contiguously in order of buffer index.
+   * @return A pointer to the first of getNumAgents() two-dimensional
+   *         positions, or NULL when there are no agents.
+   * @note   The pointer is invalidated when an agent is added or a simulation
+   *         step is performed. The contents are permuted when the agents are
+   *         reordered or an agent is removed.
+   * @note   A simulation step writes the new positions to a second buffer and
+   *         then makes it the present one, so the positions that the pointer
+   *         refers to are not modified by the next call to doStep(). Another
+   *         thread, e.g., a render thread, may read them while that step is
+   *         performed, provided that the agents are not reordered during it.
+   */
+  const Vector2 *getAgentPositionBuffer() const;
+
+  /**
+   * @brief      Copies the two-dimensional positions of all agents in order of
+   *             agent number, skipping removed agents.
+   * @param[out] positions An array of at least getNumAgents() two-dimensional
+   *                       vectors that receives the positions.
+   */
+  void getAgentPositions(Vector2 *positions) const;
+
+  /**
+   * @brief      Copies the two-dimensional preferred velocities of all agents
+   *             in order of agent number, skipping removed agents.
+   * @param[out] prefVelocities An array of at least getNumAgents()
+   *                            two-dimensional vectors that receives the
+   *                            preferred velocities.
+   */
+  void getAgentPrefVelocities(Vector2 *prefVelocities) const;
+
   /**
    * @brief     Returns the two-dimensional preferred velocity of a specified
    *            agent.
@@ -371,7 +561,7 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] agentNo The number of the agent whose radius is to be retrieved.
    * @return    The present radius of the agent.
    */
-  float getAgentRadius(std::size_t agentNo) const;
+  Real getAgentRadius(std::size_t agentNo) const;
 
   /**
    * @brief     Returns the time horizon of a specified agent.
@@ -379,7 +569,7 @@ class RVO_EXPORT RVOSimulator {
    *                    retrieved.
    * @return    The present time horizon of the agent.
    */
-  float getAgentTimeHorizon(std::size_t agentNo) const;
+  Real getAgentTimeHorizon(std::size_t agentNo) const;
 
   /**
    * @brief     Returns the time horizon with respect to obstacles of a
@@ -388,7 +578,15 @@ class RVO_EXPORT RVOSimulator {
    *                    to obstacles is to be retrieved.
    * @return    The present time horizon with respect to obstacles of the agent.
    */
-  float getAgentTimeHorizonObst(std::size_t agentNo) const;
+  Real getAgentTimeHorizonObst(std::size_t agentNo) const;
+
+  /**
+   * @brief      Copies the two-dimensional linear velocities of all agents in
+   *             order of agent number, skipping removed agents.
+   * @param[out] velocities An array of at least getNumAgents() two-dimensional
+   *                        vectors that receives the velocities.
+   */
+  void getAgentVelocities(Vector2 *velocities) const;
 
   /**
    * @brief     Returns the two-dimensional linear velocity of a specified
@@ -399,11 +597,37 @@ class RVO_EXPORT RVOSimulator {
    */
   const Vector2 &getAgentVelocity(std::size_t agentNo) const;
 
+  /**
+   * @brief  Returns a read-only view of the two-dimensional linear velocities
+   *         of all agents, stored contiguously in order of buffer index.
+   * @return A pointer to the first of getNumAgents() two-dimensional linear
+   *         velocities, or NULL when there are no agents.
+   * @note   The pointer is invalidated when an agent is added or a simulation
+   *         step is performed. The contents are permuted when the agents are
+   *         reordered or an agent is removed.
+   * @note   As with getAgentPositionBuffer(), the velocities that the pointer
+   *         refers to are not modified by the next call to doStep().
+   */
+  const Vector2 *getAgentVelocityBuffer() const;
+
+  /**
+   * @brief  Returns the executor that runs the tasks of each simulation step.
+   * @return The executor that runs the tasks of each simulation step.
+   */
+  Executor *getExecutor() const { return executor_; }
+
   /**
    * @brief  Returns the global time of the simulation.
    * @return The present global time of the simulation (zero initially).
    */
-  float getGlobalTime() const { return globalTime_; }
+  Real getGlobalTime() const { return globalTime_; }
+
+  /**
+   * @brief  Returns the maximum magnitude of the random perturbation of the
+   *         preferred velocities computed toward the goals of the agents.
+   * @return The present maximum magnitude of the perturbation.
+   */
+  Real getGoalPerturbation() const { return goalPerturbation_; }
 
   /**
    * @brief  Returns the count of agents in the simulation.
@@ -414,6 +638,8 @@ class RVO_EXPORT RVOSimulator {
   /**
    * @brief  Returns the count of obstacle vertices in the simulation.
    * @return The count of obstacle vertices in the simulation.
+   * @note   The count includes the vertices of removed obstacles, whose
+   *         numbers are not reused.
    */
   std::size_t getNumObstacleVertices() const { return obstacles_.size(); }
 
@@ -421,6 +647,7 @@ class RVO_EXPORT RVOSimulator {
    * @brief     Returns the two-dimensional position of a specified obstacle
    *            vertex.
    * @param[in] vertexNo The number of the obstacle vertex to be retrieved.
+   *                     Must not be a vertex of a removed obstacle.
    * @return    The two-dimensional position of the specified obstacle vertex.
    */
   const Vector2 &getObstacleVertex(std::size_t vertexNo) const;
@@ -445,20 +672,95 @@ class RVO_EXPORT RVOSimulator {
    */
   std::size_t getPrevObstacleVertexNo(std::size_t vertexNo) const;
 
+  /**
+   * @brief  Returns a hash of the state of the simulation, to detect cheaply
+   *         when replicas of a simulation run in lockstep have diverged.
+   * @return A 32-bit hash of the global time and of the numbers, positions,
+   *         and velocities of all agents, taken in order of agent number.
+   * @note   The hash is the same for bitwise identical states on any host,
+   *         however the agents are ordered in the buffers. Simulations built
+   *         with RVO_DETERMINISTIC give bitwise identical states from
+   *         identical inputs on x86-64 hosts, whatever the count of threads,
+   *         provided that denormals are not flushed to zero.
+   */
+  unsigned long getStateHash() const;
+
+  /**
+   * @brief  Returns the timings and counters of the phases of the last
+   *         completed simulation step.
+   * @return The statistics of the last completed simulation step, all zero if
+   *         the library is built without RVO_ENABLE_STATISTICS.
+   */
+  const StepStatistics &getStepStatistics() const { return stepStatistics_; }
+
   /**
    * @brief  Returns the time step of the simulation.
    * @return The present time step of the simulation.
    */
-  float getTimeStep() const { return timeStep_; }
+  Real getTimeStep() const { return timeStep_; }
+
+  /**
+   * @brief  Returns whether the ORCA lines induced by agent neighbors are
+   *         computed in batches of vector lanes.
+   * @return True if the ORCA lines are vectorized; false otherwise.
+   */
+  bool getVectorizeORCALines() const { return vectorizeORCALines_; }
+
+  /**
+   * @brief     Returns whether a specified agent has a goal.
+   * @param[in] agentNo The number of the agent to be queried.
+   * @return    True if the agent has a goal; false otherwise.
+   */
+  bool hasAgentGoal(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns whether a specified agent has reached its goal.
+   * @param[in] agentNo The number of the agent to be queried.
+   * @return    True if the agent has a goal and is within its arrival radius;
+   *            false otherwise.
+   */
+  bool hasAgentReachedGoal(std::size_t agentNo) const;
+
+  /**
+   * @brief     Loads the state of the simulation from a binary snapshot
+   *            written by saveSnapshot(), replacing all agents, obstacles,
+   *            and the global time, time step, and agent defaults.
+   * @param[in] stream The stream from which to read the snapshot.
+   * @return    True if the snapshot was loaded; false if it is truncated,
+   *            corrupt, of an unknown version, or saved by a library of another
+   *            precision, in which case the simulation is unchanged.
+   * @note      The neighbors and ORCA lines of the agents are not restored,
+   *            and are available again after the next simulation step. The
+   *            simulation then continues exactly as if it had not been saved.
+   *            The executor is not changed.
+   */
+  bool loadSnapshot(std::istream &stream);
 
   /**
    * @brief Processes the obstacles that have been added so that they are
    *        accounted for in the simulation.
    * @note  Obstacles added to the simulation after this function has been
-   *        called are not accounted for in the simulation.
+   *        called are not accounted for in the simulation. Dynamic obstacles
+   *        are accounted for without this function.
    */
   void processObstacles();
 
+  /**
+   * @brief     Processes the obstacles that have been added so that they are
+   *            accounted for in the simulation, trying only an evenly spaced
+   *            sample of the obstacles of each large node of the obstacle k-D
+   *            tree as its split. This builds the tree of a map with many
+   *            thousands of obstacle edges far faster, but the tree differs
+   *            from that built by processObstacles(), so the trajectories of
+   *            the agents differ as well.
+   * @param[in] maxSplitCandidates The maximum count of obstacles tried as the
+   *                               split of each node, e.g., 64. Must be
+   *                               positive.
+   * @note      Obstacles added to the simulation after this function has been
+   *            called are not accounted for in the simulation.
+   */
+  void processObstacles(std::size_t maxSplitCandidates);
+
   /**
    * @brief     Performs a visibility query between the two specified points
    *            with respect to the obstacles
@@ -483,7 +785,42 @@ class RVO_EXPORT RVOSimulator {
    *            processed.
    */
   bool queryVisibility(const Vector2 &point1, const Vector2 &point2,
-                       float radius) const;
+                       Real radius) const;
+
+  /**
+   * @brief     Removes a specified agent from the simulation. The agent in the
+   *            last buffer index is moved into its buffer index.
+   * @param[in] agentNo The number of the agent to be removed. Agents that have
+   *                    already been removed are ignored.
+   * @note      The numbers of the other agents are not affected. The number of
+   *            the removed agent is reused by the next agent added, and its
+   *            generation is incremented, so that the count of agent numbers
+   *            is bounded by the greatest count of agents at once.
+   */
+  void removeAgent(std::size_t agentNo);
+
+  /**
+   * @brief     Removes a specified dynamic obstacle from the simulation.
+   * @param[in] obstacleNo The number of the first vertex of the dynamic
+   *                       obstacle to be removed, as returned by
+   *                       addDynamicObstacle(). Other numbers, including those
+   *                       of obstacles that are not dynamic or that have
+   *                       already been removed, are ignored.
+   * @note      The numbers of the vertices of the removed obstacle are not
+   *            reused.
+   */
+  void removeObstacle(std::size_t obstacleNo);
+
+  /**
+   * @brief     Saves the state of the simulation to a binary snapshot that may
+   *            be loaded by loadSnapshot(). Waits for a simulation step in
+   *            progress to complete.
+   * @param[in] stream The stream to which to write the snapshot.
+   * @return    True if the snapshot was written; false otherwise.
+   * @note      The snapshot is independent of the byte order and word size of
+   *            the platform.
+   */
+  bool saveSnapshot(std::ostream &stream);
 
   /**
    * @brief     Sets the default properties for any new agent that is added.
@@ -518,9 +855,9 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] maxSpeed        The default maximum speed of a new agent. Must
    *                            be non-negative.
    */
-  void setAgentDefaults(float neighborDist, std::size_t maxNeighbors,
-                        float timeHorizon, float timeHorizonObst, float radius,
-                        float maxSpeed);
+  void setAgentDefaults(Real neighborDist, std::size_t maxNeighbors,
+                        Real timeHorizon, Real timeHorizonObst, Real radius,
+                        Real maxSpeed);
 
   /**
    * @brief     Sets the default properties for any new agent that is added.
@@ -557,9 +894,58 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] velocity        The default initial two-dimensional linear
    *                            velocity of a new agent.
    */
-  void setAgentDefaults(float neighborDist, std::size_t maxNeighbors,
-                        float timeHorizon, float timeHorizonObst, float radius,
-                        float maxSpeed, const Vector2 &velocity);
+  void setAgentDefaults(Real neighborDist, std::size_t maxNeighbors,
+                        Real timeHorizon, Real timeHorizonObst, Real radius,
+                        Real maxSpeed, const Vector2 &velocity);
+
+  /**
+   * @brief     Sets the count of simulation steps between reorderings of the
+   *            agents in memory along a Morton (Z-order) curve, so that agents
+   *            that are close in space are also close in memory. The numbers
+   *            of the agents are not affected, but the order of the agents in
+   *            the position and velocity buffers is.
+   * @param[in] agentReorderInterval The count of simulation steps between
+   *                                 reorderings. The default of zero never
+   *                                 reorders the agents.
+   */
+  void setAgentReorderInterval(std::size_t agentReorderInterval) {
+    agentReorderInterval_ = agentReorderInterval;
+  }
+
+  /**
+   * @brief     Sets the count of simulation steps between full rebuilds of the
+   *            agent k-D tree. In the steps in between, the tree is refit to
+   *            the new agent positions, and only its subtrees whose bounding
+   *            boxes have grown too much are rebuilt. The tree is always
+   *            rebuilt in the step after the count of agents changes.
+   * @param[in] agentTreeRebuildInterval The count of simulation steps between
+   *                                     full rebuilds. Must be positive. The
+   *                                     default of one rebuilds the tree in
+   *                                     every step.
+   */
+  void setAgentTreeRebuildInterval(std::size_t agentTreeRebuildInterval) {
+    agentTreeRebuildInterval_ = agentTreeRebuildInterval;
+  }
+
+  /**
+   * @brief     Sets the goal of a specified agent. In each simulation step, the
+   *            preferred velocity of the agent is computed to head toward the
+   *            goal at the specified speed, slowing down within the distance
+   *            it covers in a unit of time and stopping within the arrival
+   *            radius.
+   * @param[in] agentNo       The number of the agent whose goal is to be
+   *                          modified.
+   * @param[in] goal          The two-dimensional position of the goal.
+   * @param[in] speed         The preferred speed toward the goal. Must be
+   *                          non-negative.
+   * @param[in] arrivalRadius The distance from the goal within which the goal
+   *                          is reached. Must be non-negative.
+   * @note      The preferred velocity of an agent that has a goal is
+   *            overwritten when each simulation step is completed, and may be
+   *            perturbed as set by setGoalPerturbation().
+   */
+  void setAgentGoal(std::size_t agentNo, const Vector2 &goal, Real speed,
+                    Real arrivalRadius);
 
   /**
    * @brief     Sets the maximum neighbor count of a specified agent.
@@ -575,7 +961,7 @@ class RVO_EXPORT RVOSimulator {
    *                     modified.
    * @param[in] maxSpeed The replacement maximum speed. Must be non-negative.
    */
-  void setAgentMaxSpeed(std::size_t agentNo, float maxSpeed);
+  void setAgentMaxSpeed(std::size_t agentNo, Real maxSpeed);
 
   /**
    * @brief     Sets the maximum neighbor distance of a specified agent.
@@ -584,7 +970,7 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] neighborDist The replacement maximum neighbor distance. Must be
    *                         non-negative.
    */
-  void setAgentNeighborDist(std::size_t agentNo, float neighborDist);
+  void setAgentNeighborDist(std::size_t agentNo, Real neighborDist);
 
   /**
    * @brief     Sets the two-dimensional position of a specified agent.
@@ -594,6 +980,16 @@ class RVO_EXPORT RVOSimulator {
    */
   void setAgentPosition(std::size_t agentNo, const Vector2 &position);
 
+  /**
+   * @brief     Sets the two-dimensional positions of the first agents in order
+   *            of agent number, skipping removed agents.
+   * @param[in] positions An array of the replacement two-dimensional
+   *                      positions.
+   * @param[in] count     The count of positions to set. Must not exceed the
+   *                      count of agents.
+   */
+  void setAgentPositions(const Vector2 *positions, std::size_t count);
+
   /**
    * @brief     Sets the two-dimensional preferred velocity of a specified
    *            agent.
@@ -604,12 +1000,23 @@ class RVO_EXPORT RVOSimulator {
    */
   void setAgentPrefVelocity(std::size_t agentNo, const Vector2 &prefVelocity);
 
+  /**
+   * @brief     Sets the two-dimensional preferred velocities of the first
+   *            agents in order of agent number, skipping removed agents.
+   * @param[in] prefVelocities An array of the replacement two-dimensional
+   *                           preferred velocities.
+   * @param[in] count          The count of preferred velocities to set. Must
+   *                           not exceed the count of agents.
+   */
+  void setAgentPrefVelocities(const Vector2 *prefVelocities,
+                              std::size_t count);
+
   /**
    * @brief     Sets the radius of a specified agent.
    * @param[in] agentNo The number of the agent whose radius is to be modified.
    * @param[in] radius  The replacement radius. Must be non-negative.
    */
-  void setAgentRadius(std::size_t agentNo, float radius);
+  void setAgentRadius(std::size_t agentNo, Real radius);
 
   /**
    * @brief     Sets the time horizon of a specified agent with respect to other
@@ -619,7 +1026,7 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] timeHorizon The replacement time horizon with respect to other
    *                        agents. Must be positive.
    */
-  void setAgentTimeHorizon(std::size_t agentNo, float timeHorizon);
+  void setAgentTimeHorizon(std::size_t agentNo, Real timeHorizon);
 
   /**
    * @brief     Sets the time horizon of a specified agent with respect to
@@ -629,7 +1036,17 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] timeHorizonObst The replacement time horizon with respect to
    *                            obstacles. Must be positive.
    */
-  void setAgentTimeHorizonObst(std::size_t agentNo, float timeHorizonObst);
+  void setAgentTimeHorizonObst(std::size_t agentNo, Real timeHorizonObst);
+
+  /**
+   * @brief     Sets the two-dimensional linear velocities of the first agents
+   *            in order of agent number, skipping removed agents.
+   * @param[in] velocities An array of the replacement two-dimensional linear
+   *                       velocities.
+   * @param[in] count      The count of velocities to set. Must not exceed the
+   *                       count of agents.
+   */
+  void setAgentVelocities(const Vector2 *velocities, std::size_t count);
 
   /**
    * @brief     Sets the two-dimensional linear velocity of a specified agent.
@@ -639,11 +1056,53 @@ class RVO_EXPORT RVOSimulator {
    */
   void setAgentVelocity(std::size_t agentNo, const Vector2 &velocity);
 
+  /**
+   * @brief     Sets the executor that runs the tasks of each simulation step.
+   *            The agents are divided into a multiple of the count of threads
+   *            of the executor of chunks of about equal cost, as estimated
+   *            from the previous simulation step.
+   * @param[in] executor A pointer to the executor, or NULL to restore the
+   *                     default executor. The simulator does not take
+   *                     ownership of the executor, which must remain valid
+   *                     while it is set.
+   */
+  void setExecutor(Executor *executor);
+
+  /**
+   * @brief     Sets the maximum magnitude of the random perturbation of the
+   *            preferred velocities computed toward the goals of the agents,
+   *            which avoids deadlocks due to perfect symmetry. The
+   *            perturbation depends only on the agent number and the
+   *            simulation step, so it is reproducible.
+   * @param[in] goalPerturbation The maximum magnitude of the perturbation, or
+   *                             zero for none, the default. Must be
+   *                             non-negative.
+   */
+  void setGoalPerturbation(Real goalPerturbation) {
+    goalPerturbation_ = goalPerturbation;
+  }
+
   /**
    * @brief     Sets the time step of the simulation.
    * @param[in] timeStep The time step of the simulation. Must be positive.
    */
-  void setTimeStep(float timeStep) { timeStep_ = timeStep; }
+  void setTimeStep(Real timeStep) { timeStep_ = timeStep; }
+
+  /**
+   * @brief     Sets whether the ORCA lines induced by agent neighbors are
+   *            computed in batches of vector lanes, with AVX-512, AVX, SSE, or
+   *            NEON as the build targets. Every case of the construction is
+   *            computed for every neighbor of a batch and selected by masks,
+   *            with the arithmetic of the scalar construction, so the lines
+   *            differ from the scalar ones at most by the rounding of
+   *            operations that the compiler contracts differently.
+   * @param[in] vectorizeORCALines True if the ORCA lines are to be vectorized.
+   *                               The default of false computes them one
+   *                               neighbor at a time.
+   */
+  void setVectorizeORCALines(bool vectorizeORCALines) {
+    vectorizeORCALines_ = vectorizeORCALines;
+  }
 
  private:
   /* Not implemented. */
@@ -652,21 +1111,89 @@ class RVO_EXPORT RVOSimulator {
   /* Not implemented. */
   RVOSimulator &operator=(const RVOSimulator &other);
 
+  class ComputeNewVelocityTask;
+
+  /**
+   * @brief Completes the simulation step in progress, if any, once it has
+   *        been computed.
+   */
+  void completeStep();
+
+  /**
+   * @brief Divides the agents into chunks of about equal cost, estimated from
+   *        the counts of ORCA lines of the agents in the previous simulation
+   *        step.
+   */
+  void computeAgentChunks();
+
+  /**
+   * @brief     Computes the neighbors and new velocities of the agents of a
+   *            specified chunk.
+   * @param[in] chunkNo The number of the chunk of agents.
+   */
+  void computeNewVelocities(std::size_t chunkNo);
+
+  /**
+   * @brief  Returns whether every agent that has a goal has reached it.
+   * @return True if at least one agent has a goal and every agent that has a
+   *         goal has reached it; false otherwise.
+   */
+  bool haveAgentsReachedGoals() const;
+
+  /**
+   * @brief      Reads the obstacles from a snapshot. The vertices are checked
+   *             for consistency.
+   * @param[in]  reader    The snapshot reader.
+   * @param[out] obstacles The obstacles read, which are to be deleted by the
+   *                       caller even if they are not all read.
+   * @return     Whether the obstacles were read.
+   */
+  bool readObstacles(SnapshotReader *reader,
+                     std::vector<Obstacle *> *obstacles) const;
+
+  /**
+   * @brief Reorders the agents in memory along a Morton (Z-order) curve.
+   */
+  void reorderAgents();
+
+  /**
+   * @brief     Writes the obstacles to a snapshot.
+   * @param[in] writer The snapshot writer.
+   */
+  void writeObstacles(SnapshotWriter *writer) const;
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4251)
 #endif /* _MSC_VER */
   std::vector<Agent *> agents_;
+  std::vector<std::size_t> agentChunks_;
+  std::vector<StepStatistics> chunkStatistics_;
   std::vector<Obstacle *> obstacles_;
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif /* _MSC_VER */
-  Agent *defaultAgent_;
+  AgentStore *agentStore_;
+  AgentStore *defaultAgent_;
+  ComputeNewVelocityTask *computeNewVelocityTask_;
+  DefaultExecutor *defaultExecutor_;
+  Executor *executor_;
   KdTree *kdTree_;
-  float globalTime_;
-  float timeStep_;
+  StepStatistics stepStatistics_;
+  std::size_t agentReorderInterval_;
+  std::size_t agentTreeRebuildInterval_;
+  std::size_t stepsSinceAgentReorder_;
+  std::size_t stepNo_;
+  Real globalTime_;
+  Real goalPerturbation_;
+  Real timeStep_;
+  bool agentsRemoved_;
+  bool obstaclesRemoved_;
+  bool stepInProgress_;
+  bool vectorizeORCALines_;
 
   friend class KdTree;
+  friend class StepFuture;
 };
 } /* namespace RVO */
 
@@ -0,0 +1,59 @@
+/*
+ * Real.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_REAL_H_
+#define RVO_REAL_H_
+
+/**
+ * @file  Real.h
+ * @brief Declares the Real type.
+ */
+
+namespace RVO {
+/**
+ * @brief The floating-point type of the coordinates, times, and other real
+ *        quantities of the simulation. It is double if the library is built
+ *        with RVO_USE_DOUBLE defined to one, which keeps centimeter precision
+ *        tens of kilometers from the origin, and float otherwise.
+ * @note  The library and the code that uses it must be compiled with the same
+ *        definition of RVO_USE_DOUBLE. The build systems define it for the
+ *        code that uses a double-precision library.
+ */
+#if RVO_USE_DOUBLE
+typedef double Real;
+#else
+typedef float Real;
+#endif /* RVO_USE_DOUBLE */
+} /* namespace RVO */
+
+#endif /* RVO_REAL_H_ */
@@ -0,0 +1,451 @@
+/*
+ * Snapshot.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  Snapshot.cc
+ * @brief Defines the SnapshotReader and SnapshotWriter classes.
+ */
+
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+#include "Vector2.h"
+
+namespace RVO {
+namespace {
+/**
+ * @relates SnapshotReader
+ * @brief   The count of bytes read or written at a time.
+ */
+const std::size_t RVO_SNAPSHOT_CHUNK_SIZE = 65536U;
+
+/**
+ * @relates SnapshotReader
+ * @brief   The magic number that begins a snapshot.
+ */
+const char RVO_SNAPSHOT_MAGIC[] = {'R', 'V', 'O', '2', 'S', 'N', 'A', 'P'};
+
+/**
+ * @relates SnapshotReader
+ * @brief   The version of the snapshot format.
+ */
+const std::size_t RVO_SNAPSHOT_VERSION = 3U;
+
+/**
+ * @relates SnapshotReader
+ * @brief   The count of bytes of an encoded real.
+ */
+const std::size_t RVO_SNAPSHOT_REAL_SIZE = sizeof(Real);
+
+/**
+ * @relates SnapshotReader
+ * @brief   The count of bytes of an encoded size.
+ */
+const std::size_t RVO_SNAPSHOT_SIZE_SIZE = 8U;
+
+/**
+ * @relates SnapshotReader
+ * @brief   Returns whether reals are stored in little-endian byte order.
+ * @return  Whether reals are stored in little-endian byte order.
+ */
+bool isLittleEndian() {
+  const Real one = 1.0F;
+  unsigned char bytes[sizeof(Real)];
+  std::memcpy(bytes, &one, sizeof(Real));
+
+  /* The sign and high bits of the exponent of one are in the last byte. */
+  return bytes[sizeof(Real) - 1U] == 0x3FU;
+}
+
+/**
+ * @relates   SnapshotWriter
+ * @brief     Appends an encoded real to a buffer.
+ * @param[in] value  The real to be encoded.
+ * @param[in] buffer The buffer to which to append.
+ */
+void encodeReal(Real value, std::vector<unsigned char> *buffer) {
+  unsigned char bytes[RVO_SNAPSHOT_REAL_SIZE];
+  std::memcpy(bytes, &value, RVO_SNAPSHOT_REAL_SIZE);
+
+  if (!isLittleEndian()) {
+    std::reverse(bytes, bytes + RVO_SNAPSHOT_REAL_SIZE);
+  }
+
+  buffer->insert(buffer->end(), bytes, bytes + RVO_SNAPSHOT_REAL_SIZE);
+}
+
+/**
+ * @relates   SnapshotWriter
+ * @brief     Appends an encoded size to a buffer.
+ * @param[in] value  The size to be encoded.
+ * @param[in] buffer The buffer to which to append.
+ */
+void encodeSize(std::size_t value, std::vector<unsigned char> *buffer) {
+  const bool isMax = value == std::numeric_limits<std::size_t>::max();
+
+  for (std::size_t i = 0U; i < RVO_SNAPSHOT_SIZE_SIZE; ++i) {
+    buffer->push_back(
+        isMax ? 0xFFU : static_cast<unsigned char>(value & 0xFFU));
+    value >>= 8U;
+  }
+}
+
+/**
+ * @relates   SnapshotReader
+ * @brief     Decodes a real.
+ * @param[in] bytes The encoded real.
+ * @return    The decoded real.
+ */
+Real decodeReal(const unsigned char *bytes) {
+  unsigned char copy[RVO_SNAPSHOT_REAL_SIZE];
+  std::memcpy(copy, bytes, RVO_SNAPSHOT_REAL_SIZE);
+
+  if (!isLittleEndian()) {
+    std::reverse(copy, copy + RVO_SNAPSHOT_REAL_SIZE);
+  }
+
+  Real value = 0.0F;
+  std::memcpy(&value, copy, RVO_SNAPSHOT_REAL_SIZE);
+
+  return value;
+}
+
+/**
+ * @relates    SnapshotReader
+ * @brief      Decodes a size.
+ * @param[in]  bytes The encoded size.
+ * @param[out] value The decoded size.
+ * @return     Whether the encoded integer fits a size.
+ */
+bool decodeSize(const unsigned char *bytes, std::size_t *value) {
+  const std::size_t max = std::numeric_limits<std::size_t>::max();
+  bool isMax = true;
+
+  for (std::size_t i = 0U; i < RVO_SNAPSHOT_SIZE_SIZE; ++i) {
+    isMax = isMax && bytes[i] == 0xFFU;
+  }
+
+  if (isMax) {
+    *value = max;
+
+    return true;
+  }
+
+  std::size_t result = 0U;
+
+  for (std::size_t i = RVO_SNAPSHOT_SIZE_SIZE; i-- > 0U;) {
+    if (result > (max >> 8U)) {
+      return false;
+    }
+
+    result = (result << 8U) | bytes[i];
+  }
+
+  *value = result;
+
+  return true;
+}
+} /* namespace */
+
+SnapshotReader::SnapshotReader(std::istream *stream)
+    : stream_(stream), good_(true) {}
+
+SnapshotReader::~SnapshotReader() {}
+
+bool SnapshotReader::fill(std::size_t count) {
+  buffer_.resize(count);
+
+  return readBytes(count, reinterpret_cast<char *>(&buffer_[0]));
+}
+
+bool SnapshotReader::readBool(bool *value) {
+  if (!fill(1U) || buffer_[0U] > 1U) {
+    good_ = false;
+
+    return false;
+  }
+
+  *value = buffer_[0U] != 0U;
+
+  return true;
+}
+
+bool SnapshotReader::readBools(std::size_t count, std::vector<bool> *values) {
+  values->clear();
+
+  while (count > 0U) {
+    const std::size_t chunk = std::min(count, RVO_SNAPSHOT_CHUNK_SIZE);
+
+    if (!fill(chunk)) {
+      return false;
+    }
+
+    for (std::size_t i = 0U; i < chunk; ++i) {
+      if (buffer_[i] > 1U) {
+        good_ = false;
+
+        return false;
+      }
+
+      values->push_back(buffer_[i] != 0U);
+    }
+
+    count -= chunk;
+  }
+
+  return good_;
+}
+
+bool SnapshotReader::readBytes(std::size_t count, char *bytes) {
+  if (good_ && count > 0U) {
+    stream_->read(bytes, static_cast<std::streamsize>(count));
+    good_ = stream_->gcount() == static_cast<std::streamsize>(count);
+  }
+
+  return good_;
+}
+
+bool SnapshotReader::readReal(Real *value) {
+  if (!fill(RVO_SNAPSHOT_REAL_SIZE)) {
+    return false;
+  }
+
+  *value = decodeReal(&buffer_[0U]);
+
+  return true;
+}
+
+bool SnapshotReader::readReals(std::size_t count, std::vector<Real> *values) {
+  values->clear();
+
+  while (count > 0U) {
+    const std::size_t chunk =
+        std::min(count, RVO_SNAPSHOT_CHUNK_SIZE / RVO_SNAPSHOT_REAL_SIZE);
+
+    if (!fill(chunk * RVO_SNAPSHOT_REAL_SIZE)) {
+      return false;
+    }
+
+    for (std::size_t i = 0U; i < chunk; ++i) {
+      values->push_back(decodeReal(&buffer_[i * RVO_SNAPSHOT_REAL_SIZE]));
+    }
+
+    count -= chunk;
+  }
+
+  return good_;
+}
+
+bool SnapshotReader::readHeader() {
+  char magic[sizeof(RVO_SNAPSHOT_MAGIC)];
+  std::size_t version = 0U;
+  std::size_t realSize = 0U;
+
+  /* A snapshot is loaded only by a library of the same precision. */
+  if (!readBytes(sizeof(RVO_SNAPSHOT_MAGIC), magic) ||
+      std::memcmp(magic, RVO_SNAPSHOT_MAGIC, sizeof(RVO_SNAPSHOT_MAGIC)) != 0 ||
+      !readSize(&version) || version != RVO_SNAPSHOT_VERSION ||
+      !readSize(&realSize) || realSize != RVO_SNAPSHOT_REAL_SIZE) {
+    good_ = false;
+  }
+
+  return good_;
+}
+
+bool SnapshotReader::readSize(std::size_t *value) {
+  if (!fill(RVO_SNAPSHOT_SIZE_SIZE) || !decodeSize(&buffer_[0U], value)) {
+    good_ = false;
+
+    return false;
+  }
+
+  return true;
+}
+
+bool SnapshotReader::readSizes(std::size_t count,
+                               std::vector<std::size_t> *values) {
+  values->clear();
+
+  while (count > 0U) {
+    const std::size_t chunk =
+        std::min(count, RVO_SNAPSHOT_CHUNK_SIZE / RVO_SNAPSHOT_SIZE_SIZE);
+
+    if (!fill(chunk * RVO_SNAPSHOT_SIZE_SIZE)) {
+      return false;
+    }
+
+    for (std::size_t i = 0U; i < chunk; ++i) {
+      std::size_t value = 0U;
+
+      if (!decodeSize(&buffer_[i * RVO_SNAPSHOT_SIZE_SIZE], &value)) {
+        good_ = false;
+
+        return false;
+      }
+
+      values->push_back(value);
+    }
+
+    count -= chunk;
+  }
+
+  return good_;
+}
+
+bool SnapshotReader::readVector2(Vector2 *value) {
+  Real x = 0.0F;
+  Real y = 0.0F;
+
+  if (!readReal(&x) || !readReal(&y)) {
+    return false;
+  }
+
+  *value = Vector2(x, y);
+
+  return true;
+}
+
+bool SnapshotReader::readVector2s(std::size_t count,
+                                  std::vector<Vector2> *values) {
+  values->clear();
+
+  while (count > 0U) {
+    const std::size_t chunk = std::min(
+        count, RVO_SNAPSHOT_CHUNK_SIZE / (2U * RVO_SNAPSHOT_REAL_SIZE));
+
+    if (!fill(chunk * 2U * RVO_SNAPSHOT_REAL_SIZE)) {
+      return false;
+    }
+
+    for (std::size_t i = 0U; i < chunk; ++i) {
+      values->push_back(Vector2(
+          decodeReal(&buffer_[2U * i * RVO_SNAPSHOT_REAL_SIZE]),
+          decodeReal(
+              &buffer_[(2U * i + 1U) * RVO_SNAPSHOT_REAL_SIZE])));
+    }
+
+    count -= chunk;
+  }
+
+  return good_;
+}
+
+SnapshotWriter::SnapshotWriter(std::ostream *stream)
+    : stream_(stream), good_(true) {
+  buffer_.reserve(RVO_SNAPSHOT_CHUNK_SIZE + RVO_SNAPSHOT_SIZE_SIZE);
+}
+
+SnapshotWriter::~SnapshotWriter() {}
+
+bool SnapshotWriter::flush() {
+  if (good_ && !buffer_.empty()) {
+    stream_->write(reinterpret_cast<const char *>(&buffer_[0U]),
+                   static_cast<std::streamsize>(buffer_.size()));
+    good_ = stream_->good();
+  }
+
+  buffer_.clear();
+
+  return good_;
+}
+
+void SnapshotWriter::writeBool(bool value) {
+  buffer_.push_back(value ? 1U : 0U);
+}
+
+void SnapshotWriter::writeBools(const std::vector<bool> &values) {
+  for (std::size_t i = 0U; i < values.size(); ++i) {
+    writeBool(values[i]);
+
+    if (buffer_.size() >= RVO_SNAPSHOT_CHUNK_SIZE) {
+      flush();
+    }
+  }
+}
+
+void SnapshotWriter::writeBytes(std::size_t count, const char *bytes) {
+  buffer_.insert(buffer_.end(), bytes, bytes + count);
+}
+
+void SnapshotWriter::writeReal(Real value) { encodeReal(value, &buffer_); }
+
+void SnapshotWriter::writeReals(const std::vector<Real> &values) {
+  for (std::size_t i = 0U; i < values.size(); ++i) {
+    encodeReal(values[i], &buffer_);
+
+    if (buffer_.size() >= RVO_SNAPSHOT_CHUNK_SIZE) {
+      flush();
+    }
+  }
+}
+
+void SnapshotWriter::writeHeader() {
+  writeBytes(sizeof(RVO_SNAPSHOT_MAGIC), RVO_SNAPSHOT_MAGIC);
+  writeSize(RVO_SNAPSHOT_VERSION);
+  writeSize(RVO_SNAPSHOT_REAL_SIZE);
+}
+
+void SnapshotWriter::writeSize(std::size_t value) {
+  encodeSize(value, &buffer_);
+}
+
+void SnapshotWriter::writeSizes(const std::vector<std::size_t> &values) {
+  for (std::size_t i = 0U; i < values.size(); ++i) {
+    encodeSize(values[i], &buffer_);
+
+    if (buffer_.size() >= RVO_SNAPSHOT_CHUNK_SIZE) {
+      flush();
+    }
+  }
+}
+
+void SnapshotWriter::writeVector2(const Vector2 &value) {
+  encodeReal(value.x(), &buffer_);
+  encodeReal(value.y(), &buffer_);
+}
+
+void SnapshotWriter::writeVector2s(const std::vector<Vector2> &values) {
+  for (std::size_t i = 0U; i < values.size(); ++i) {
+    writeVector2(values[i]);
+
+    if (buffer_.size() >= RVO_SNAPSHOT_CHUNK_SIZE) {
+      flush();
+    }
+  }
+}
+} /* namespace RVO */
@@ -0,0 +1,272 @@
+/*
+ * Snapshot.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_SNAPSHOT_H_
+#define RVO_SNAPSHOT_H_
+
+/**
+ * @file  Snapshot.h
+ * @brief Declares the SnapshotReader and SnapshotWriter classes.
+ */
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+#include "Real.h"
+
+namespace RVO {
+class Vector2;
+
+/**
+ * @brief Defines a reader of the binary snapshot format. Integers are read as
+ *        eight little-endian bytes, reals as their little-endian IEEE 754
+ *        bytes, and booleans as one byte. Columns are read in bounded
+ *        chunks, so a corrupt count fails at the end of the stream rather
+ *        than allocating its memory up front. A failed read fails all
+ *        subsequent reads.
+ */
+class SnapshotReader {
+ private:
+  /**
+   * @brief     Constructs a snapshot reader instance.
+   * @param[in] stream The stream from which to read.
+   */
+  explicit SnapshotReader(std::istream *stream);
+
+  /**
+   * @brief Destroys this snapshot reader instance.
+   */
+  ~SnapshotReader();
+
+  /**
+   * @brief     Reads bytes into the buffer, replacing its contents.
+   * @param[in] count The count of bytes to be read.
+   * @return    Whether the bytes were read.
+   */
+  bool fill(std::size_t count);
+
+  /**
+   * @brief      Reads a boolean.
+   * @param[out] value The boolean read.
+   * @return     Whether the boolean was read.
+   */
+  bool readBool(bool *value);
+
+  /**
+   * @brief      Reads a column of booleans.
+   * @param[in]  count  The count of booleans to be read.
+   * @param[out] values The booleans read.
+   * @return     Whether the booleans were read.
+   */
+  bool readBools(std::size_t count, std::vector<bool> *values);
+
+  /**
+   * @brief      Reads raw bytes.
+   * @param[in]  count The count of bytes to be read.
+   * @param[out] bytes The bytes read.
+   * @return     Whether the bytes were read.
+   */
+  bool readBytes(std::size_t count, char *bytes);
+
+  /**
+   * @brief      Reads a real.
+   * @param[out] value The real read.
+   * @return     Whether the real was read.
+   */
+  bool readReal(Real *value);
+
+  /**
+   * @brief      Reads a column of reals.
+   * @param[in]  count  The count of reals to be read.
+   * @param[out] values The reals read.
+   * @return     Whether the reals were read.
+   */
+  bool readReals(std::size_t count, std::vector<Real> *values);
+
+  /**
+   * @brief  Reads the magic number and the version of the snapshot format,
+   *         and the count of bytes of a real.
+   * @return Whether the snapshot format is known and its reals are of the
+   *         precision of the library.
+   */
+  bool readHeader();
+
+  /**
+   * @brief      Reads a size. The largest eight-byte integer is read as the
+   *             largest size.
+   * @param[out] value The size read.
+   * @return     Whether the size was read and fits a size.
+   */
+  bool readSize(std::size_t *value);
+
+  /**
+   * @brief      Reads a column of sizes.
+   * @param[in]  count  The count of sizes to be read.
+   * @param[out] values The sizes read.
+   * @return     Whether the sizes were read and fit sizes.
+   */
+  bool readSizes(std::size_t count, std::vector<std::size_t> *values);
+
+  /**
+   * @brief      Reads a two-dimensional vector.
+   * @param[out] value The two-dimensional vector read.
+   * @return     Whether the two-dimensional vector was read.
+   */
+  bool readVector2(Vector2 *value);
+
+  /**
+   * @brief      Reads a column of two-dimensional vectors.
+   * @param[in]  count  The count of two-dimensional vectors to be read.
+   * @param[out] values The two-dimensional vectors read.
+   * @return     Whether the two-dimensional vectors were read.
+   */
+  bool readVector2s(std::size_t count, std::vector<Vector2> *values);
+
+  /* Not implemented. */
+  SnapshotReader(const SnapshotReader &other);
+
+  /* Not implemented. */
+  SnapshotReader &operator=(const SnapshotReader &other);
+
+  std::vector<unsigned char> buffer_;
+  std::istream *stream_;
+  bool good_;
+
+  friend class AgentStore;
+  friend class KdTree;
+  friend class RVOSimulator;
+};
+
+/**
+ * @brief Defines a writer of the binary snapshot format read by
+ *        SnapshotReader. The bytes are buffered and written in large blocks.
+ */
+class SnapshotWriter {
+ private:
+  /**
+   * @brief     Constructs a snapshot writer instance.
+   * @param[in] stream The stream to which to write.
+   */
+  explicit SnapshotWriter(std::ostream *stream);
+
+  /**
+   * @brief Destroys this snapshot writer instance.
+   */
+  ~SnapshotWriter();
+
+  /**
+   * @brief  Writes the buffered bytes to the stream.
+   * @return Whether all bytes were written.
+   */
+  bool flush();
+
+  /**
+   * @brief     Writes a boolean.
+   * @param[in] value The boolean to be written.
+   */
+  void writeBool(bool value);
+
+  /**
+   * @brief     Writes a column of booleans.
+   * @param[in] values The booleans to be written.
+   */
+  void writeBools(const std::vector<bool> &values);
+
+  /**
+   * @brief     Writes raw bytes.
+   * @param[in] count The count of bytes to be written.
+   * @param[in] bytes The bytes to be written.
+   */
+  void writeBytes(std::size_t count, const char *bytes);
+
+  /**
+   * @brief     Writes a real.
+   * @param[in] value The real to be written.
+   */
+  void writeReal(Real value);
+
+  /**
+   * @brief     Writes a column of reals.
+   * @param[in] values The reals to be written.
+   */
+  void writeReals(const std::vector<Real> &values);
+
+  /**
+   * @brief Writes the magic number and the version of the snapshot format,
+   *        and the count of bytes of a real.
+   */
+  void writeHeader();
+
+  /**
+   * @brief     Writes a size. The largest size is written as the largest
+   *            eight-byte integer.
+   * @param[in] value The size to be written.
+   */
+  void writeSize(std::size_t value);
+
+  /**
+   * @brief     Writes a column of sizes.
+   * @param[in] values The sizes to be written.
+   */
+  void writeSizes(const std::vector<std::size_t> &values);
+
+  /**
+   * @brief     Writes a two-dimensional vector.
+   * @param[in] value The two-dimensional vector to be written.
+   */
+  void writeVector2(const Vector2 &value);
+
+  /**
+   * @brief     Writes a column of two-dimensional vectors.
+   * @param[in] values The two-dimensional vectors to be written.
+   */
+  void writeVector2s(const std::vector<Vector2> &values);
+
+  /* Not implemented. */
+  SnapshotWriter(const SnapshotWriter &other);
+
+  /* Not implemented. */
+  SnapshotWriter &operator=(const SnapshotWriter &other);
+
+  std::vector<unsigned char> buffer_;
+  std::ostream *stream_;
+  bool good_;
+
+  friend class AgentStore;
+  friend class KdTree;
+  friend class RVOSimulator;
+};
+} /* namespace RVO */
+
+#endif /* RVO_SNAPSHOT_H_ */
@@ -0,0 +1,76 @@
+/*
+ * StepStatistics.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  StepStatistics.cc
+ * @brief Defines the StepStatistics class.
+ */
+
+#include "StepStatistics.h"
+
+#include <algorithm>
+
+namespace RVO {
+StepStatistics::StepStatistics()
+    : agentNeighborsTime(0.0),
+      agentTreeTime(0.0),
+      integrationTime(0.0),
+      linearProgram2Time(0.0),
+      linearProgram3Time(0.0),
+      maxAgentNeighbors(0U),
+      numAgentNeighbors(0U),
+      numAgentTreeNodesVisited(0U),
+      numLinearProgram3Calls(0U),
+      numObstacleNeighbors(0U),
+      obstacleNeighborsTime(0.0),
+      orcaLinesTime(0.0),
+      stepTime(0.0) {}
+
+StepStatistics &StepStatistics::operator+=(const StepStatistics &other) {
+  agentNeighborsTime += other.agentNeighborsTime;
+  agentTreeTime += other.agentTreeTime;
+  integrationTime += other.integrationTime;
+  linearProgram2Time += other.linearProgram2Time;
+  linearProgram3Time += other.linearProgram3Time;
+  maxAgentNeighbors = std::max(maxAgentNeighbors, other.maxAgentNeighbors);
+  numAgentNeighbors += other.numAgentNeighbors;
+  numAgentTreeNodesVisited += other.numAgentTreeNodesVisited;
+  numLinearProgram3Calls += other.numLinearProgram3Calls;
+  numObstacleNeighbors += other.numObstacleNeighbors;
+  obstacleNeighborsTime += other.obstacleNeighborsTime;
+  orcaLinesTime += other.orcaLinesTime;
+  stepTime += other.stepTime;
+
+  return *this;
+}
+} /* namespace RVO */
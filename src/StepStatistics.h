@@ -0,0 +1,143 @@
+/*
+ * StepStatistics.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_STEP_STATISTICS_H_
+#define RVO_STEP_STATISTICS_H_
+
+/**
+ * @file  StepStatistics.h
+ * @brief Declares the StepStatistics class.
+ */
+
+#include <cstddef>
+
+#include "Export.h"
+
+namespace RVO {
+/**
+ * @brief Defines the timings and counters of the phases of a simulation step.
+ *        They are recorded only if the library is built with
+ *        RVO_ENABLE_STATISTICS defined to one, and are zero otherwise. The
+ *        times are in seconds. The times of the phases that are computed per
+ *        agent are summed over the threads that compute them, so they may
+ *        exceed the time of the step. Recording them reads a clock several
+ *        times per agent, which slows the step noticeably.
+ */
+class RVO_EXPORT StepStatistics {
+ public:
+  /**
+   * @brief Constructs a step statistics instance with all timings and counters
+   *        zero.
+   */
+  StepStatistics();
+
+  /**
+   * @brief     Adds the timings and counters of other step statistics to those
+   *            of these step statistics. The maximum count of agent neighbors
+   *            becomes the greater of the two.
+   * @param[in] other The step statistics to be added.
+   * @return    A reference to these step statistics.
+   */
+  StepStatistics &operator+=(const StepStatistics &other);
+
+  /**
+   * @brief The time to search for the agent neighbors of the agents.
+   */
+  double agentNeighborsTime;
+
+  /**
+   * @brief The time to build or refit the agent k-D tree.
+   */
+  double agentTreeTime;
+
+  /**
+   * @brief The time to integrate the new velocities and positions of the
+   *        agents.
+   */
+  double integrationTime;
+
+  /**
+   * @brief The time spent in the second linear program.
+   */
+  double linearProgram2Time;
+
+  /**
+   * @brief The time spent in the third linear program, the fallback when the
+   *        second is infeasible.
+   */
+  double linearProgram3Time;
+
+  /**
+   * @brief The greatest count of agent neighbors of an agent.
+   */
+  std::size_t maxAgentNeighbors;
+
+  /**
+   * @brief The count of agent neighbors summed over the agents.
+   */
+  std::size_t numAgentNeighbors;
+
+  /**
+   * @brief The count of nodes of the agent k-D tree visited by the agent
+   *        neighbor searches.
+   */
+  std::size_t numAgentTreeNodesVisited;
+
+  /**
+   * @brief The count of agents for which the third linear program ran.
+   */
+  std::size_t numLinearProgram3Calls;
+
+  /**
+   * @brief The count of obstacle neighbors summed over the agents.
+   */
+  std::size_t numObstacleNeighbors;
+
+  /**
+   * @brief The time to search for the obstacle neighbors of the agents.
+   */
+  double obstacleNeighborsTime;
+
+  /**
+   * @brief The time to construct the ORCA lines of the agents.
+   */
+  double orcaLinesTime;
+
+  /**
+   * @brief The wall time of the step, from its start to its completion.
+   */
+  double stepTime;
+};
+} /* namespace RVO */
+
+#endif /* RVO_STEP_STATISTICS_H_ */
@@ -0,0 +1,615 @@
+/*
+ * TiledSimulator.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  TiledSimulator.cc
+ * @brief Defines the TiledSimulator class.
+ */
+
+#include "TiledSimulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Executor.h"
+#include "RVOSimulator.h"
+
+namespace RVO {
+namespace {
+/**
+ * @relates       TiledSimulator
+ * @brief         Moves a coordinate relative to the origin of a tile into the
+ *                tile that contains it along one axis.
+ * @param[in]     tileSize   The length of the sides of the tiles.
+ * @param[in,out] tile       The coordinate of the tile along the axis.
+ * @param[in,out] coordinate The coordinate relative to the origin of the
+ *                           tile.
+ */
+void rebaseCoordinate(Real tileSize, long *tile, Real *coordinate) {
+  const Real offset = std::floor(*coordinate / tileSize);
+
+  if (offset != 0.0F) {
+    /* The offset is a whole multiple of the tile size, so the subtraction
+     * loses no more precision than the coordinate has within its tile. */
+    *tile += static_cast<long>(offset);
+    *coordinate -= offset * tileSize;
+  }
+
+  /* The quotient or the difference may be rounded onto the boundary of the
+   * tile, e.g., a tiny negative coordinate becomes exactly the tile size. The
+   * coordinate is then moved one more tile, which is exact. */
+  if (*coordinate < 0.0F) {
+    --*tile;
+    *coordinate += tileSize;
+  } else if (*coordinate >= tileSize) {
+    ++*tile;
+    *coordinate -= tileSize;
+  }
+}
+
+/**
+ * @relates       TiledSimulator
+ * @brief         Moves a position relative to the origin of a tile into the
+ *                tile that contains it.
+ * @param[in]     tileSize The length of the sides of the tiles.
+ * @param[in,out] tileX    The x-coordinate of the tile.
+ * @param[in,out] tileY    The y-coordinate of the tile.
+ * @param[in,out] position The two-dimensional position relative to the origin
+ *                         of the tile.
+ */
+void rebase(Real tileSize, long *tileX, long *tileY, Vector2 *position) {
+  Real x = position->x();
+  Real y = position->y();
+  rebaseCoordinate(tileSize, tileX, &x);
+  rebaseCoordinate(tileSize, tileY, &y);
+  *position = Vector2(x, y);
+}
+
+/**
+ * @relates       TiledSimulator
+ * @brief         Records the number in the tiled simulation of an agent added
+ *                to the simulator of a tile, which may reuse the number of a
+ *                removed agent.
+ * @param[in]     localNo  The number of the agent in the simulator of the
+ *                         tile.
+ * @param[in]     agentNo  The number of the agent in the tiled simulation, or
+ *                         RVO::RVO_ERROR for a copy.
+ * @param[in,out] agentNos The numbers in the tiled simulation by the numbers
+ *                         in the simulator of the tile.
+ */
+void setAgentNo(std::size_t localNo, std::size_t agentNo,
+                std::vector<std::size_t> *agentNos) {
+  if (localNo < agentNos->size()) {
+    (*agentNos)[localNo] = agentNo;
+  } else {
+    agentNos->push_back(agentNo);
+  }
+}
+} /* namespace */
+
+/**
+ * @brief Defines a tile of a tiled simulation.
+ */
+class TiledSimulator::Tile {
+ public:
+  /**
+   * @brief     Constructs a tile instance with an empty simulator.
+   * @param[in] x The x-coordinate of the tile.
+   * @param[in] y The y-coordinate of the tile.
+   */
+  Tile(long x, long y);
+
+  /**
+   * @brief Destroys this tile instance and its simulator.
+   */
+  ~Tile();
+
+  /**
+   * @brief The numbers of the agents of the tiled simulation by their numbers
+   *        in the simulator of this tile, RVO::RVO_ERROR for the copies of the
+   *        agents of the neighboring tiles and for removed agents.
+   */
+  std::vector<std::size_t> agentNos;
+
+  /**
+   * @brief The numbers in the simulator of this tile of the copies of the
+   *        agents of the neighboring tiles within its halo. The copies past
+   *        the first numHaloCopies are parked for reuse.
+   */
+  std::vector<std::size_t> haloNos;
+
+  /**
+   * @brief The simulator of the agents and obstacles of this tile, in
+   *        coordinates relative to its origin.
+   */
+  RVOSimulator *simulator;
+
+  /**
+   * @brief The count of agents of the tiled simulation in this tile.
+   */
+  std::size_t numAgents;
+
+  /**
+   * @brief The count of copies of the agents of the neighboring tiles that
+   *        are within the halo of this tile.
+   */
+  std::size_t numHaloCopies;
+
+  /**
+   * @brief The x-coordinate of this tile.
+   */
+  long tileX;
+
+  /**
+   * @brief The y-coordinate of this tile.
+   */
+  long tileY;
+
+ private:
+  /* Not implemented. */
+  Tile(const Tile &other);
+
+  /* Not implemented. */
+  Tile &operator=(const Tile &other);
+};
+
+TiledSimulator::Tile::Tile(long x, long y)
+    : simulator(new RVOSimulator()),
+      numAgents(0U),
+      numHaloCopies(0U),
+      tileX(x),
+      tileY(y) {}
+
+TiledSimulator::Tile::~Tile() { delete simulator; }
+
+/**
+ * @brief Defines an obstacle of a tiled simulation.
+ */
+class TiledSimulator::TileObstacle {
+ public:
+  /**
+   * @brief Constructs an obstacle instance.
+   */
+  TileObstacle();
+
+  /**
+   * @brief The vertices of the obstacle relative to the origin of its tile.
+   */
+  std::vector<Vector2> vertices;
+
+  /**
+   * @brief The maximum x-coordinate of the tiles whose halos the obstacle
+   *        overlaps.
+   */
+  long maxTileX;
+
+  /**
+   * @brief The maximum y-coordinate of the tiles whose halos the obstacle
+   *        overlaps.
+   */
+  long maxTileY;
+
+  /**
+   * @brief The minimum x-coordinate of the tiles whose halos the obstacle
+   *        overlaps.
+   */
+  long minTileX;
+
+  /**
+   * @brief The minimum y-coordinate of the tiles whose halos the obstacle
+   *        overlaps.
+   */
+  long minTileY;
+
+  /**
+   * @brief The x-coordinate of the tile relative to which the vertices are
+   *        given.
+   */
+  long tileX;
+
+  /**
+   * @brief The y-coordinate of the tile relative to which the vertices are
+   *        given.
+   */
+  long tileY;
+};
+
+TiledSimulator::TileObstacle::TileObstacle()
+    : maxTileX(0L),
+      maxTileY(0L),
+      minTileX(0L),
+      minTileY(0L),
+      tileX(0L),
+      tileY(0L) {}
+
+TiledSimulator::TiledSimulator(Real tileSize, Real haloWidth, Real timeStep,
+                               Real neighborDist, std::size_t maxNeighbors,
+                               Real timeHorizon, Real timeHorizonObst,
+                               Real radius, Real maxSpeed)
+    : defaultAgent_(new RVOSimulator()),
+      defaultExecutor_(new DefaultExecutor()),
+      executor_(defaultExecutor_),
+      globalTime_(0.0F),
+      haloWidth_(haloWidth),
+      tileSize_(tileSize),
+      timeStep_(timeStep),
+      obstaclesProcessed_(false) {
+  defaultAgent_->addAgent(Vector2(), neighborDist, maxNeighbors, timeHorizon,
+                          timeHorizonObst, radius, maxSpeed);
+}
+
+TiledSimulator::~TiledSimulator() {
+  delete defaultAgent_;
+
+  for (std::map<std::pair<long, long>, Tile *>::iterator iter =
+           tiles_.begin();
+       iter != tiles_.end(); ++iter) {
+    delete iter->second;
+  }
+
+  delete defaultExecutor_;
+
+  for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
+    delete obstacles_[i];
+  }
+}
+
+std::size_t TiledSimulator::addAgent(long tileX, long tileY,
+                                     const Vector2 &position) {
+  return addAgent(tileX, tileY, position,
+                  defaultAgent_->getAgentNeighborDist(0U),
+                  defaultAgent_->getAgentMaxNeighbors(0U),
+                  defaultAgent_->getAgentTimeHorizon(0U),
+                  defaultAgent_->getAgentTimeHorizonObst(0U),
+                  defaultAgent_->getAgentRadius(0U),
+                  defaultAgent_->getAgentMaxSpeed(0U), Vector2());
+}
+
+std::size_t TiledSimulator::addAgent(long tileX, long tileY,
+                                     const Vector2 &position,
+                                     Real neighborDist,
+                                     std::size_t maxNeighbors,
+                                     Real timeHorizon, Real timeHorizonObst,
+                                     Real radius, Real maxSpeed,
+                                     const Vector2 &velocity) {
+  Vector2 localPosition = position;
+  rebase(tileSize_, &tileX, &tileY, &localPosition);
+
+  Tile *const tile = getTile(tileX, tileY);
+  const std::size_t agentNo = agentTiles_.size();
+
+  agentLocalNos_.push_back(tile->simulator->addAgent(
+      localPosition, neighborDist, maxNeighbors, timeHorizon, timeHorizonObst,
+      radius, maxSpeed, velocity));
+  agentTiles_.push_back(tile);
+  setAgentNo(agentLocalNos_.back(), agentNo, &tile->agentNos);
+  ++tile->numAgents;
+
+  return agentNo;
+}
+
+std::size_t TiledSimulator::addObstacle(long tileX, long tileY,
+                                        const std::vector<Vector2> &vertices) {
+  if (vertices.size() < 2U) {
+    return RVO_ERROR;
+  }
+
+  TileObstacle *const obstacle = new TileObstacle();
+  obstacle->vertices = vertices;
+  obstacle->tileX = tileX;
+  obstacle->tileY = tileY;
+
+  Real maxX = vertices[0U].x();
+  Real maxY = vertices[0U].y();
+  Real minX = vertices[0U].x();
+  Real minY = vertices[0U].y();
+
+  for (std::size_t i = 1U; i < vertices.size(); ++i) {
+    maxX = std::max(maxX, vertices[i].x());
+    maxY = std::max(maxY, vertices[i].y());
+    minX = std::min(minX, vertices[i].x());
+    minY = std::min(minY, vertices[i].y());
+  }
+
+  obstacle->maxTileX =
+      tileX + static_cast<long>(std::floor((maxX + haloWidth_) / tileSize_));
+  obstacle->maxTileY =
+      tileY + static_cast<long>(std::floor((maxY + haloWidth_) / tileSize_));
+  obstacle->minTileX =
+      tileX + static_cast<long>(std::floor((minX - haloWidth_) / tileSize_));
+  obstacle->minTileY =
+      tileY + static_cast<long>(std::floor((minY - haloWidth_) / tileSize_));
+
+  for (std::map<std::pair<long, long>, Tile *>::iterator iter =
+           tiles_.begin();
+       iter != tiles_.end(); ++iter) {
+    addObstacleToTile(obstacle, iter->second);
+  }
+
+  obstacles_.push_back(obstacle);
+
+  return obstacles_.size() - 1U;
+}
+
+void TiledSimulator::addObstacleToTile(const TileObstacle *obstacle,
+                                       Tile *tile) const {
+  if (tile->tileX < obstacle->minTileX || tile->tileX > obstacle->maxTileX ||
+      tile->tileY < obstacle->minTileY || tile->tileY > obstacle->maxTileY) {
+    return;
+  }
+
+  const Real offsetX =
+      static_cast<Real>(obstacle->tileX - tile->tileX) * tileSize_;
+  const Real offsetY =
+      static_cast<Real>(obstacle->tileY - tile->tileY) * tileSize_;
+  std::vector<Vector2> vertices(obstacle->vertices.size());
+
+  for (std::size_t i = 0U; i < vertices.size(); ++i) {
+    vertices[i] = Vector2(obstacle->vertices[i].x() + offsetX,
+                          obstacle->vertices[i].y() + offsetY);
+  }
+
+  tile->simulator->addObstacle(vertices);
+}
+
+void TiledSimulator::doStep() {
+  /* The halos are updated from the agents of the neighboring tiles before
+   * any tile is stepped, so every tile sees the same state. */
+  for (std::map<std::pair<long, long>, Tile *>::iterator iter =
+           tiles_.begin();
+       iter != tiles_.end(); ++iter) {
+    updateHalo(iter->second);
+  }
+
+  for (std::map<std::pair<long, long>, Tile *>::iterator iter =
+           tiles_.begin();
+       iter != tiles_.end(); ++iter) {
+    if (iter->second->numAgents > 0U) {
+      iter->second->simulator->doStep();
+    }
+  }
+
+  rebaseAgents();
+
+  globalTime_ += timeStep_;
+}
+
+const Vector2 &TiledSimulator::getAgentPosition(std::size_t agentNo) const {
+  return agentTiles_[agentNo]->simulator->getAgentPosition(
+      agentLocalNos_[agentNo]);
+}
+
+const Vector2 &TiledSimulator::getAgentPrefVelocity(
+    std::size_t agentNo) const {
+  return agentTiles_[agentNo]->simulator->getAgentPrefVelocity(
+      agentLocalNos_[agentNo]);
+}
+
+long TiledSimulator::getAgentTileX(std::size_t agentNo) const {
+  return agentTiles_[agentNo]->tileX;
+}
+
+long TiledSimulator::getAgentTileY(std::size_t agentNo) const {
+  return agentTiles_[agentNo]->tileY;
+}
+
+const Vector2 &TiledSimulator::getAgentVelocity(std::size_t agentNo) const {
+  return agentTiles_[agentNo]->simulator->getAgentVelocity(
+      agentLocalNos_[agentNo]);
+}
+
+TiledSimulator::Tile *TiledSimulator::getTile(long tileX, long tileY) {
+  const std::pair<long, long> key(tileX, tileY);
+  const std::map<std::pair<long, long>, Tile *>::iterator iter =
+      tiles_.find(key);
+
+  if (iter != tiles_.end()) {
+    return iter->second;
+  }
+
+  Tile *const tile = new Tile(tileX, tileY);
+  tile->simulator->setTimeStep(timeStep_);
+  tile->simulator->setExecutor(executor_);
+
+  for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
+    addObstacleToTile(obstacles_[i], tile);
+  }
+
+  if (obstaclesProcessed_) {
+    tile->simulator->processObstacles();
+  }
+
+  tiles_.insert(std::make_pair(key, tile));
+
+  return tile;
+}
+
+void TiledSimulator::moveAgent(std::size_t agentNo, long tileX, long tileY,
+                               const Vector2 &position) {
+  Tile *const oldTile = agentTiles_[agentNo];
+  RVOSimulator *const oldSimulator = oldTile->simulator;
+  const std::size_t oldNo = agentLocalNos_[agentNo];
+
+  Vector2 localPosition = position;
+  rebase(tileSize_, &tileX, &tileY, &localPosition);
+
+  Tile *const tile = getTile(tileX, tileY);
+  const std::size_t localNo = tile->simulator->addAgent(
+      localPosition, oldSimulator->getAgentNeighborDist(oldNo),
+      oldSimulator->getAgentMaxNeighbors(oldNo),
+      oldSimulator->getAgentTimeHorizon(oldNo),
+      oldSimulator->getAgentTimeHorizonObst(oldNo),
+      oldSimulator->getAgentRadius(oldNo),
+      oldSimulator->getAgentMaxSpeed(oldNo),
+      oldSimulator->getAgentVelocity(oldNo));
+  tile->simulator->setAgentPrefVelocity(
+      localNo, oldSimulator->getAgentPrefVelocity(oldNo));
+  setAgentNo(localNo, agentNo, &tile->agentNos);
+  ++tile->numAgents;
+
+  oldSimulator->removeAgent(oldNo);
+  oldTile->agentNos[oldNo] = RVO_ERROR;
+  --oldTile->numAgents;
+
+  agentTiles_[agentNo] = tile;
+  agentLocalNos_[agentNo] = localNo;
+}
+
+void TiledSimulator::processObstacles() {
+  for (std::map<std::pair<long, long>, Tile *>::iterator iter =
+           tiles_.begin();
+       iter != tiles_.end(); ++iter) {
+    iter->second->simulator->processObstacles();
+  }
+
+  obstaclesProcessed_ = true;
+}
+
+void TiledSimulator::rebaseAgents() {
+  std::vector<std::size_t> agentNos;
+
+  for (std::map<std::pair<long, long>, Tile *>::iterator iter =
+           tiles_.begin();
+       iter != tiles_.end(); ++iter) {
+    const RVOSimulator *const simulator = iter->second->simulator;
+    const Vector2 *const positions = simulator->getAgentPositionBuffer();
+
+    for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+      const std::size_t agentNo =
+          iter->second->agentNos[simulator->getAgentNo(i)];
+
+      if (agentNo != RVO_ERROR &&
+          (positions[i].x() < 0.0F || positions[i].x() >= tileSize_ ||
+           positions[i].y() < 0.0F || positions[i].y() >= tileSize_)) {
+        agentNos.push_back(agentNo);
+      }
+    }
+  }
+
+  for (std::size_t i = 0U; i < agentNos.size(); ++i) {
+    moveAgent(agentNos[i], agentTiles_[agentNos[i]]->tileX,
+              agentTiles_[agentNos[i]]->tileY, getAgentPosition(agentNos[i]));
+  }
+}
+
+void TiledSimulator::setAgentPrefVelocity(std::size_t agentNo,
+                                          const Vector2 &prefVelocity) {
+  agentTiles_[agentNo]->simulator->setAgentPrefVelocity(
+      agentLocalNos_[agentNo], prefVelocity);
+}
+
+void TiledSimulator::setExecutor(Executor *executor) {
+  executor_ = executor != NULL ? executor : defaultExecutor_;
+
+  for (std::map<std::pair<long, long>, Tile *>::iterator iter =
+           tiles_.begin();
+       iter != tiles_.end(); ++iter) {
+    iter->second->simulator->setExecutor(executor_);
+  }
+}
+
+void TiledSimulator::updateHalo(Tile *tile) {
+  RVOSimulator *const simulator = tile->simulator;
+  std::size_t numCopies = 0U;
+
+  /* A tile without agents needs no halo, since nothing in it avoids the
+   * copies. */
+  for (long y = -1L; tile->numAgents > 0U && y <= 1L; ++y) {
+    for (long x = -1L; x <= 1L; ++x) {
+      if (x == 0L && y == 0L) {
+        continue;
+      }
+
+      const std::map<std::pair<long, long>, Tile *>::const_iterator iter =
+          tiles_.find(std::make_pair(tile->tileX + x, tile->tileY + y));
+
+      if (iter == tiles_.end() || iter->second->numAgents == 0U) {
+        continue;
+      }
+
+      const Tile *const neighbor = iter->second;
+      const Vector2 *const positions =
+          neighbor->simulator->getAgentPositionBuffer();
+      const Vector2 *const velocities =
+          neighbor->simulator->getAgentVelocityBuffer();
+      const Real offsetX = static_cast<Real>(x) * tileSize_;
+      const Real offsetY = static_cast<Real>(y) * tileSize_;
+
+      for (std::size_t i = 0U; i < neighbor->simulator->getNumAgents(); ++i) {
+        const std::size_t localNo = neighbor->simulator->getAgentNo(i);
+        const Vector2 position(positions[i].x() + offsetX,
+                               positions[i].y() + offsetY);
+
+        if (neighbor->agentNos[localNo] == RVO_ERROR ||
+            position.x() < -haloWidth_ ||
+            position.x() >= tileSize_ + haloWidth_ ||
+            position.y() < -haloWidth_ ||
+            position.y() >= tileSize_ + haloWidth_) {
+          continue;
+        }
+
+        const Real radius = neighbor->simulator->getAgentRadius(localNo);
+
+        if (numCopies < tile->haloNos.size()) {
+          simulator->setAgentPosition(tile->haloNos[numCopies], position);
+          simulator->setAgentRadius(tile->haloNos[numCopies], radius);
+          simulator->setAgentVelocity(tile->haloNos[numCopies], velocities[i]);
+        } else {
+          /* A copy takes no neighbors and cannot move, so computing its own
+           * velocity costs little. It is replaced before the next step. */
+          tile->haloNos.push_back(simulator->addAgent(
+              position, 0.0F, 0U, 1.0F, 1.0F, radius, 0.0F, velocities[i]));
+          setAgentNo(tile->haloNos.back(), RVO_ERROR, &tile->agentNos);
+        }
+
+        ++numCopies;
+      }
+    }
+  }
+
+  /* Copies no longer needed are parked rather than removed, so that agents
+   * moving in and out of the halo do not add and remove agents every step.
+   * A parked copy is farther from the tile than the halo width, which bounds
+   * the neighbor distances of its agents. */
+  const Vector2 parkingPosition(-tileSize_ - 2.0F * haloWidth_,
+                                -tileSize_ - 2.0F * haloWidth_);
+
+  for (std::size_t i = numCopies; i < tile->numHaloCopies; ++i) {
+    simulator->setAgentPosition(tile->haloNos[i], parkingPosition);
+    simulator->setAgentRadius(tile->haloNos[i], 0.0F);
+    simulator->setAgentVelocity(tile->haloNos[i], Vector2());
+  }
+
+  tile->numHaloCopies = numCopies;
+}
+} /* namespace RVO */
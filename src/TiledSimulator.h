@@ -0,0 +1,370 @@
+/*
+ * TiledSimulator.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_TILED_SIMULATOR_H_
+#define RVO_TILED_SIMULATOR_H_
+
+/**
+ * @file  TiledSimulator.h
+ * @brief Declares the TiledSimulator class.
+ */
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Export.h"
+#include "Real.h"
+#include "Vector2.h"
+
+namespace RVO {
+class DefaultExecutor;
+class Executor;
+class RVOSimulator;
+
+/**
+ * @brief Defines a simulation of a world divided into square tiles, so that
+ *        maps far larger than the precision of RVO::Real allows may be
+ *        simulated. The agents and obstacles of each tile are simulated by an
+ *        RVOSimulator in coordinates relative to the origin of the tile, so
+ *        the k-D trees and ORCA computations run in tile-local coordinates.
+ *        Each tile also holds copies of the agents of the neighboring tiles
+ *        within a halo around it, with which its agents avoid agents across
+ *        the boundary. An agent that leaves its tile in a simulation step is
+ *        moved to the tile that it has entered and its position re-based.
+ * @note  A tile is created when an agent first enters it, and obstacles are
+ *        added to every tile whose halo they overlap.
+ */
+class RVO_EXPORT TiledSimulator {
+ public:
+  /**
+   * @brief     Constructs a tiled simulator instance and sets the default
+   *            properties for any new agent that is added.
+   * @param[in] tileSize        The length of the sides of the tiles. Must be
+   *                            positive.
+   * @param[in] haloWidth       The width of the halo around each tile within
+   *                            which agents and obstacles of the neighboring
+   *                            tiles are taken into account. Must be at least
+   *                            the neighbor distance and the time horizon with
+   *                            respect to obstacles times the maximum speed
+   *                            plus the radius of every agent, and at most the
+   *                            tile size.
+   * @param[in] timeStep        The time step of the simulation. Must be
+   *                            positive.
+   * @param[in] neighborDist    The default maximum distance center-point to
+   *                            center-point to other agents a new agent takes
+   *                            into account in the navigation. Must be
+   *                            non-negative.
+   * @param[in] maxNeighbors    The default maximum number of other agents a new
+   *                            agent takes into account in the navigation.
+   * @param[in] timeHorizon     The default minimal amount of time for which a
+   *                            new agent's velocities that are computed by the
+   *                            simulation are safe with respect to other
+   *                            agents. Must be positive.
+   * @param[in] timeHorizonObst The default minimal amount of time for which a
+   *                            new agent's velocities that are computed by the
+   *                            simulation are safe with respect to obstacles.
+   *                            Must be positive.
+   * @param[in] radius          The default radius of a new agent. Must be
+   *                            non-negative.
+   * @param[in] maxSpeed        The default maximum speed of a new agent. Must
+   *                            be non-negative.
+   */
+  TiledSimulator(Real tileSize, Real haloWidth, Real timeStep,
+                 Real neighborDist, std::size_t maxNeighbors, Real timeHorizon,
+                 Real timeHorizonObst, Real radius, Real maxSpeed);
+
+  /**
+   * @brief Destroys this tiled simulator instance.
+   */
+  ~TiledSimulator();
+
+  /**
+   * @brief     Adds a new agent with default properties to the simulation.
+   * @param[in] tileX    The x-coordinate of the tile relative to which the
+   *                     position is given.
+   * @param[in] tileY    The y-coordinate of the tile relative to which the
+   *                     position is given.
+   * @param[in] position The two-dimensional starting position of this agent
+   *                     relative to the origin of the tile. The agent is moved
+   *                     to another tile if the position is outside of it.
+   * @return    The number of the agent.
+   */
+  std::size_t addAgent(long tileX, long tileY, const Vector2 &position);
+
+  /**
+   * @brief     Adds a new agent to the simulation.
+   * @param[in] tileX           The x-coordinate of the tile relative to which
+   *                            the position is given.
+   * @param[in] tileY           The y-coordinate of the tile relative to which
+   *                            the position is given.
+   * @param[in] position        The two-dimensional starting position of this
+   *                            agent relative to the origin of the tile. The
+   *                            agent is moved to another tile if the position
+   *                            is outside of it.
+   * @param[in] neighborDist    The maximum distance center-point to
+   *                            center-point to other agents this agent takes
+   *                            into account in the navigation. Must be
+   *                            non-negative and at most the halo width.
+   * @param[in] maxNeighbors    The maximum number of other agents this agent
+   *                            takes into account in the navigation.
+   * @param[in] timeHorizon     The minimal amount of time for which this
+   *                            agent's velocities that are computed by the
+   *                            simulation are safe with respect to other
+   *                            agents. Must be positive.
+   * @param[in] timeHorizonObst The minimal amount of time for which this
+   *                            agent's velocities that are computed by the
+   *                            simulation are safe with respect to obstacles.
+   *                            Must be positive.
+   * @param[in] radius          The radius of this agent. Must be non-negative.
+   * @param[in] maxSpeed        The maximum speed of this agent. Must be
+   *                            non-negative.
+   * @param[in] velocity        The initial two-dimensional linear velocity of
+   *                            this agent.
+   * @return    The number of the agent.
+   */
+  std::size_t addAgent(long tileX, long tileY, const Vector2 &position,
+                       Real neighborDist, std::size_t maxNeighbors,
+                       Real timeHorizon, Real timeHorizonObst, Real radius,
+                       Real maxSpeed, const Vector2 &velocity);
+
+  /**
+   * @brief     Adds a new obstacle to the simulation.
+   * @param[in] tileX    The x-coordinate of the tile relative to which the
+   *                     vertices are given.
+   * @param[in] tileY    The y-coordinate of the tile relative to which the
+   *                     vertices are given.
+   * @param[in] vertices List of the vertices of the polygonal obstacle in
+   *                     counterclockwise order, relative to the origin of the
+   *                     tile.
+   * @return    The number of the obstacle, or RVO::RVO_ERROR when the number
+   *            of vertices is less than two.
+   * @note      The obstacle is accounted for in the simulation once
+   *            processObstacles() has been called.
+   */
+  std::size_t addObstacle(long tileX, long tileY,
+                          const std::vector<Vector2> &vertices);
+
+  /**
+   * @brief Lets the simulator perform a simulation step, updating the
+   *        two-dimensional position and two-dimensional velocity of each
+   *        agent, and moves the agents that have left their tiles to the
+   *        tiles that they have entered.
+   */
+  void doStep();
+
+  /**
+   * @brief     Returns the two-dimensional position of a specified agent
+   *            relative to the origin of its tile.
+   * @param[in] agentNo The number of the agent whose two-dimensional position
+   *                    is to be retrieved.
+   * @return    The present two-dimensional position of the center of the agent
+   *            relative to the origin of its tile. Each coordinate is at least
+   *            zero and less than the tile size.
+   */
+  const Vector2 &getAgentPosition(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the two-dimensional preferred velocity of a specified
+   *            agent.
+   * @param[in] agentNo The number of the agent whose two-dimensional preferred
+   *                    velocity is to be retrieved.
+   * @return    The present two-dimensional preferred velocity of the agent.
+   */
+  const Vector2 &getAgentPrefVelocity(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the x-coordinate of the tile of a specified agent.
+   * @param[in] agentNo The number of the agent whose tile is to be retrieved.
+   * @return    The x-coordinate of the tile of the agent, whose origin is at
+   *            the x-coordinate times the tile size.
+   */
+  long getAgentTileX(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the y-coordinate of the tile of a specified agent.
+   * @param[in] agentNo The number of the agent whose tile is to be retrieved.
+   * @return    The y-coordinate of the tile of the agent, whose origin is at
+   *            the y-coordinate times the tile size.
+   */
+  long getAgentTileY(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the two-dimensional linear velocity of a specified
+   *            agent.
+   * @param[in] agentNo The number of the agent whose two-dimensional linear
+   *                    velocity is to be retrieved.
+   * @return    The present two-dimensional linear velocity of the agent.
+   */
+  const Vector2 &getAgentVelocity(std::size_t agentNo) const;
+
+  /**
+   * @brief  Returns the global time of the simulation.
+   * @return The present global time of the simulation (zero initially).
+   */
+  Real getGlobalTime() const { return globalTime_; }
+
+  /**
+   * @brief  Returns the width of the halo around each tile.
+   * @return The width of the halo around each tile.
+   */
+  Real getHaloWidth() const { return haloWidth_; }
+
+  /**
+   * @brief  Returns the count of agents in the simulation.
+   * @return The count of agents in the simulation.
+   */
+  std::size_t getNumAgents() const { return agentTiles_.size(); }
+
+  /**
+   * @brief  Returns the count of tiles that have been entered by agents.
+   * @return The count of tiles that have been entered by agents.
+   */
+  std::size_t getNumTiles() const { return tiles_.size(); }
+
+  /**
+   * @brief  Returns the length of the sides of the tiles.
+   * @return The length of the sides of the tiles.
+   */
+  Real getTileSize() const { return tileSize_; }
+
+  /**
+   * @brief  Returns the time step of the simulation.
+   * @return The time step of the simulation.
+   */
+  Real getTimeStep() const { return timeStep_; }
+
+  /**
+   * @brief Processes the obstacles that have been added so that they are
+   *        accounted for in the simulation.
+   */
+  void processObstacles();
+
+  /**
+   * @brief     Sets the two-dimensional preferred velocity of a specified
+   *            agent.
+   * @param[in] agentNo      The number of the agent whose two-dimensional
+   *                         preferred velocity is to be modified.
+   * @param[in] prefVelocity The replacement of the two-dimensional preferred
+   *                         velocity.
+   */
+  void setAgentPrefVelocity(std::size_t agentNo, const Vector2 &prefVelocity);
+
+  /**
+   * @brief     Sets the executor that runs the tasks of each simulation step
+   *            of every tile.
+   * @param[in] executor A pointer to the executor, or NULL to restore the
+   *                     default executor shared by the tiles, whose threads
+   *                     are started once. The simulator does not take
+   *                     ownership of the executor, which must remain valid
+   *                     while it is set.
+   */
+  void setExecutor(Executor *executor);
+
+ private:
+  class Tile;
+  class TileObstacle;
+
+  /* Not implemented. */
+  TiledSimulator(const TiledSimulator &other);
+
+  /* Not implemented. */
+  TiledSimulator &operator=(const TiledSimulator &other);
+
+  /**
+   * @brief     Adds the vertices of an obstacle to a tile, relative to the
+   *            origin of the tile.
+   * @param[in] obstacle The obstacle to be added.
+   * @param[in] tile     The tile to which the obstacle is to be added.
+   */
+  void addObstacleToTile(const TileObstacle *obstacle, Tile *tile) const;
+
+  /**
+   * @brief     Returns the tile with the specified coordinates, creating it
+   *            with the obstacles that overlap its halo if it does not exist.
+   * @param[in] tileX The x-coordinate of the tile.
+   * @param[in] tileY The y-coordinate of the tile.
+   * @return    A pointer to the tile.
+   */
+  Tile *getTile(long tileX, long tileY);
+
+  /**
+   * @brief     Moves an agent to the tile that contains a position.
+   * @param[in] agentNo  The number of the agent to be moved.
+   * @param[in] tileX    The x-coordinate of the tile relative to which the
+   *                     position is given.
+   * @param[in] tileY    The y-coordinate of the tile relative to which the
+   *                     position is given.
+   * @param[in] position The two-dimensional position of the agent relative to
+   *                     the origin of the tile.
+   */
+  void moveAgent(std::size_t agentNo, long tileX, long tileY,
+                 const Vector2 &position);
+
+  /**
+   * @brief Moves the agents that have left their tiles to the tiles that they
+   *        have entered.
+   */
+  void rebaseAgents();
+
+  /**
+   * @brief     Replaces the copies of the agents of the neighboring tiles
+   *            within the halo of a tile.
+   * @param[in] tile The tile whose halo is to be updated.
+   */
+  void updateHalo(Tile *tile);
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif /* _MSC_VER */
+  std::map<std::pair<long, long>, Tile *> tiles_;
+  std::vector<Tile *> agentTiles_;
+  std::vector<std::size_t> agentLocalNos_;
+  std::vector<TileObstacle *> obstacles_;
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif /* _MSC_VER */
+  RVOSimulator *defaultAgent_;
+  DefaultExecutor *defaultExecutor_;
+  Executor *executor_;
+  Real globalTime_;
+  Real haloWidth_;
+  Real tileSize_;
+  Real timeStep_;
+  bool obstaclesProcessed_;
+};
+} /* namespace RVO */
+
+#endif /* RVO_TILED_SIMULATOR_H_ */
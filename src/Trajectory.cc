@@ -0,0 +1,1092 @@
+/*
+ * Trajectory.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  Trajectory.cc
+ * @brief Defines the TrajectoryReader and TrajectoryRecorder classes.
+ */
+
+#include "Trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+
+#include "RVOSimulator.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+namespace RVO {
+namespace {
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The magic number that begins a trajectory file.
+ */
+const char RVO_TRAJECTORY_MAGIC[] = {'R', 'V', 'O', '2', 'T', 'R', 'A', 'J'};
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The version of the trajectory file format.
+ */
+const std::size_t RVO_TRAJECTORY_VERSION = 1U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The count of bytes of the header of a trajectory file before the
+ *          quantum: the magic number, the version, and the flags.
+ */
+const std::size_t RVO_TRAJECTORY_HEADER_SIZE = 17U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The count of bytes of the header of a chunk: the count of bytes of
+ *          its steps and the count of its steps.
+ */
+const std::size_t RVO_TRAJECTORY_CHUNK_HEADER_SIZE = 16U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The flag of a trajectory file whose velocities are recorded.
+ */
+const unsigned char RVO_TRAJECTORY_VELOCITIES = 1U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The flag of a trajectory file whose quantum, global times, and
+ *          exact coordinates are recorded as doubles rather than floats, as
+ *          by a library built with RVO_USE_DOUBLE.
+ */
+const unsigned char RVO_TRAJECTORY_DOUBLES = 2U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The maximum count of steps of a chunk, which bounds the count of
+ *          steps decoded to read a step.
+ */
+const std::size_t RVO_TRAJECTORY_MAX_CHUNK_STEPS = 64U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The count of bytes of a chunk beyond which no more steps are added
+ *          to it.
+ */
+const std::size_t RVO_TRAJECTORY_MAX_CHUNK_SIZE = 16777216U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The maximum count of chunks waiting for the background thread.
+ */
+const std::size_t RVO_TRAJECTORY_MAX_QUEUED_CHUNKS = 4U;
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   The maximum magnitude of a quantized coordinate, so that the
+ *          difference of two fits a 32-bit integer.
+ */
+const float RVO_TRAJECTORY_MAX_QUANTIZED = 1073741823.0F;
+
+/**
+ * @relates   TrajectoryRecorder
+ * @brief     Appends a size to a buffer as eight little-endian bytes.
+ * @param[in] value  The size to be appended.
+ * @param[in] buffer The buffer to which to append.
+ */
+void appendSize(std::size_t value, std::vector<unsigned char> *buffer) {
+  for (std::size_t i = 0U; i < 8U; ++i) {
+    buffer->push_back(static_cast<unsigned char>(value & 0xFFU));
+    value >>= 8U;
+  }
+}
+
+/**
+ * @relates TrajectoryRecorder
+ * @brief   Returns whether reals are stored in little-endian byte order.
+ * @return  Whether reals are stored in little-endian byte order.
+ */
+bool isLittleEndian() {
+  const Real one = 1.0F;
+  unsigned char bytes[sizeof(Real)];
+  std::memcpy(bytes, &one, sizeof(Real));
+
+  /* The sign and high bits of the exponent of one are in the last byte. */
+  return bytes[sizeof(Real) - 1U] == 0x3FU;
+}
+
+/**
+ * @relates   TrajectoryRecorder
+ * @brief     Appends a real to a buffer as its little-endian IEEE 754 bytes.
+ * @param[in] value  The real to be appended.
+ * @param[in] buffer The buffer to which to append.
+ */
+void appendReal(Real value, std::vector<unsigned char> *buffer) {
+  unsigned char bytes[sizeof(Real)];
+  std::memcpy(bytes, &value, sizeof(Real));
+
+  if (!isLittleEndian()) {
+    std::reverse(bytes, bytes + sizeof(Real));
+  }
+
+  buffer->insert(buffer->end(), bytes, bytes + sizeof(Real));
+}
+
+/**
+ * @relates   TrajectoryRecorder
+ * @brief     Appends a size to a buffer as a variable-length integer of seven
+ *            bits per byte, the least significant first.
+ * @param[in] value  The size to be appended.
+ * @param[in] buffer The buffer to which to append.
+ */
+void appendVarint(std::size_t value, std::vector<unsigned char> *buffer) {
+  while (value >= 0x80U) {
+    buffer->push_back(static_cast<unsigned char>((value & 0x7FU) | 0x80U));
+    value >>= 7U;
+  }
+
+  buffer->push_back(static_cast<unsigned char>(value));
+}
+
+/**
+ * @relates   TrajectoryRecorder
+ * @brief     Maps a signed integer to an unsigned one, so that integers of
+ *            small magnitude have short variable-length encodings.
+ * @param[in] value The signed integer, of magnitude less than 2^31.
+ * @return    The unsigned integer.
+ */
+std::size_t zigzag(long value) {
+  return static_cast<std::size_t>(
+      value < 0L ? 2UL * static_cast<unsigned long>(-value) - 1UL
+                 : 2UL * static_cast<unsigned long>(value));
+}
+
+/**
+ * @relates   TrajectoryReader
+ * @brief     Maps an unsigned integer back to the signed one of zigzag().
+ * @param[in] value The unsigned integer, less than 2^32.
+ * @return    The signed integer.
+ */
+long unzigzag(std::size_t value) {
+  return (value & 1U) != 0U ? -static_cast<long>((value + 1U) / 2U)
+                            : static_cast<long>(value / 2U);
+}
+
+/**
+ * @relates   TrajectoryRecorder
+ * @brief     Rounds a coordinate to a multiple of a quantum.
+ * @param[in] value   The coordinate to be rounded.
+ * @param[in] quantum The quantum.
+ * @return    The coordinate in quanta.
+ */
+long quantize(Real value, Real quantum) {
+  const Real quanta = std::floor(value / quantum + 0.5F);
+
+  /* Also maps not-a-number to the minimum. */
+  if (!(quanta > -RVO_TRAJECTORY_MAX_QUANTIZED)) {
+    return -static_cast<long>(RVO_TRAJECTORY_MAX_QUANTIZED);
+  }
+
+  return static_cast<long>(
+      std::min<Real>(quanta, RVO_TRAJECTORY_MAX_QUANTIZED));
+}
+
+/**
+ * @relates    TrajectoryReader
+ * @brief      Reads a size of eight little-endian bytes.
+ * @param[in]  bytes The bytes to be read.
+ * @param[out] value The size read.
+ * @return     Whether the size fits a size.
+ */
+bool readSize(const unsigned char *bytes, std::size_t *value) {
+  std::size_t result = 0U;
+
+  for (std::size_t i = 8U; i-- > 0U;) {
+    if (result > (static_cast<std::size_t>(-1) >> 8U)) {
+      return false;
+    }
+
+    result = (result << 8U) | bytes[i];
+  }
+
+  *value = result;
+
+  return true;
+}
+
+/**
+ * @relates   TrajectoryReader
+ * @brief     Reads a real of four or eight little-endian IEEE 754 bytes.
+ * @param[in] bytes    The bytes to be read.
+ * @param[in] isDouble Whether the real is a double rather than a float.
+ * @return    The real read, rounded to the precision of the library.
+ */
+Real readReal(const unsigned char *bytes, bool isDouble) {
+  unsigned char copy[sizeof(double)];
+  const std::size_t size = isDouble ? sizeof(double) : sizeof(float);
+  std::memcpy(copy, bytes, size);
+
+  /* Floats and doubles are stored in the same byte order. */
+  if (!isLittleEndian()) {
+    std::reverse(copy, copy + size);
+  }
+
+  if (isDouble) {
+    double value = 0.0;
+    std::memcpy(&value, copy, sizeof(double));
+
+    return static_cast<Real>(value);
+  }
+
+  float value = 0.0F;
+  std::memcpy(&value, copy, sizeof(float));
+
+  return value;
+}
+
+/**
+ * @relates       TrajectoryReader
+ * @brief         Reads a variable-length integer written by appendVarint().
+ * @param[in,out] bytes The bytes to be read, advanced past the integer.
+ * @param[in]     end   The end of the bytes.
+ * @param[out]    value The integer read.
+ * @return        Whether the integer was read and fits a size.
+ */
+bool readVarint(const unsigned char **bytes, const unsigned char *end,
+                std::size_t *value) {
+  std::size_t result = 0U;
+
+  for (std::size_t shift = 0U; *bytes != end; shift += 7U) {
+    const std::size_t byte = *(*bytes)++;
+
+    if (shift >= 8U * sizeof(std::size_t) ||
+        ((byte & 0x7FU) << shift >> shift) != (byte & 0x7FU)) {
+      return false;
+    }
+
+    result |= (byte & 0x7FU) << shift;
+
+    if ((byte & 0x80U) == 0U) {
+      *value = result;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+} /* namespace */
+
+/**
+ * @brief Defines a read-only mapping of a file into memory.
+ */
+class TrajectoryReader::Mapping {
+ public:
+  /**
+   * @brief Constructs a mapping instance that maps no file.
+   */
+  Mapping();
+
+  /**
+   * @brief Destroys this mapping instance, unmapping its file.
+   */
+  ~Mapping();
+
+  /**
+   * @brief     Maps a file into memory.
+   * @param[in] path The path of the file.
+   * @return    Whether the file was mapped.
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief The bytes of the file.
+   */
+  const unsigned char *data;
+
+  /**
+   * @brief The count of bytes of the file.
+   */
+  std::size_t size;
+
+ private:
+  /* Not implemented. */
+  Mapping(const Mapping &other);
+
+  /* Not implemented. */
+  Mapping &operator=(const Mapping &other);
+
+#ifdef _WIN32
+  HANDLE file_;
+  HANDLE mapping_;
+#endif /* _WIN32 */
+};
+
+#ifdef _WIN32
+TrajectoryReader::Mapping::Mapping()
+    : data(NULL), size(0U), file_(INVALID_HANDLE_VALUE), mapping_(NULL) {}
+
+TrajectoryReader::Mapping::~Mapping() {
+  if (data != NULL) {
+    UnmapViewOfFile(data);
+  }
+
+  if (mapping_ != NULL) {
+    CloseHandle(mapping_);
+  }
+
+  if (file_ != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_);
+  }
+}
+
+bool TrajectoryReader::Mapping::open(const std::string &path) {
+  /* The file may still be being written by a trajectory recorder. */
+  file_ = CreateFileA(path.c_str(), GENERIC_READ,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER fileSize;
+
+  if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &fileSize) ||
+      fileSize.QuadPart <= 0) {
+    return false;
+  }
+
+  mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  if (mapping_ == NULL) {
+    return false;
+  }
+
+  data = static_cast<const unsigned char *>(
+      MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  size = static_cast<std::size_t>(fileSize.QuadPart);
+
+  return data != NULL;
+}
+#else
+TrajectoryReader::Mapping::Mapping() : data(NULL), size(0U) {}
+
+TrajectoryReader::Mapping::~Mapping() {
+  if (data != NULL) {
+    munmap(const_cast<unsigned char *>(data), size);
+  }
+}
+
+bool TrajectoryReader::Mapping::open(const std::string &path) {
+  const int file = ::open(path.c_str(), O_RDONLY);
+
+  if (file == -1) {
+    return false;
+  }
+
+  struct stat status;
+
+  if (fstat(file, &status) != 0 || status.st_size <= 0) {
+    ::close(file);
+
+    return false;
+  }
+
+  /* The mapping remains valid after the file is closed. */
+  void *const address = mmap(NULL, static_cast<std::size_t>(status.st_size),
+                             PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);
+
+  if (address == MAP_FAILED) {
+    return false;
+  }
+
+  data = static_cast<const unsigned char *>(address);
+  size = static_cast<std::size_t>(status.st_size);
+
+  return true;
+}
+#endif /* _WIN32 */
+
+/**
+ * @brief Defines the background thread that writes the chunks of a trajectory
+ *        recorder to its file in the order in which they are handed to it.
+ */
+class TrajectoryRecorder::Writer {
+ public:
+  /**
+   * @brief     Constructs a writer instance.
+   * @param[in] file The file to which to write, which the writer closes.
+   */
+  explicit Writer(std::FILE *file);
+
+  /**
+   * @brief Destroys this writer instance.
+   */
+  ~Writer();
+
+  /**
+   * @brief  Waits for the background thread to write every chunk, and closes
+   *         the file.
+   * @return Whether every chunk was written and the file was closed.
+   */
+  bool finish();
+
+  /**
+   * @brief  Returns whether every chunk has been written so far.
+   * @return Whether every chunk has been written so far.
+   */
+  bool isGood();
+
+  /**
+   * @brief         Hands a chunk to the background thread, waiting while too
+   *                many chunks are waiting for it.
+   * @param[in,out] bytes The bytes of the chunk, which are replaced by an empty
+   *                      buffer.
+   */
+  void push(std::vector<unsigned char> *bytes);
+
+  /**
+   * @brief  Starts the background thread.
+   * @return Whether the background thread was started.
+   */
+  bool start();
+
+ private:
+#ifdef _WIN32
+  /**
+   * @brief     Runs the background thread.
+   * @param[in] writer The writer instance.
+   * @return    Zero.
+   */
+  static DWORD WINAPI run(LPVOID writer);
+#else
+  /**
+   * @brief     Runs the background thread.
+   * @param[in] writer The writer instance.
+   * @return    NULL.
+   */
+  static void *run(void *writer);
+#endif /* _WIN32 */
+
+  /**
+   * @brief Locks the mutex of this writer.
+   */
+  void lock();
+
+  /**
+   * @brief Wakes the threads waiting for the condition of this writer.
+   */
+  void notify();
+
+  /**
+   * @brief Unlocks the mutex of this writer.
+   */
+  void unlock();
+
+  /**
+   * @brief Waits for the condition of this writer with its mutex locked.
+   */
+  void wait();
+
+  /**
+   * @brief Writes the chunks until the writer is finished.
+   */
+  void write();
+
+  /* Not implemented. */
+  Writer(const Writer &other);
+
+  /* Not implemented. */
+  Writer &operator=(const Writer &other);
+
+  std::deque<std::vector<unsigned char> > queue_;
+  std::vector<unsigned char> spare_;
+  std::FILE *file_;
+#ifdef _WIN32
+  CONDITION_VARIABLE condition_;
+  CRITICAL_SECTION mutex_;
+  HANDLE thread_;
+#else
+  pthread_cond_t condition_;
+  pthread_mutex_t mutex_;
+  pthread_t thread_;
+#endif /* _WIN32 */
+  bool isDone_;
+  bool isGood_;
+  bool isStarted_;
+};
+
+TrajectoryRecorder::Writer::Writer(std::FILE *file)
+    : file_(file), isDone_(false), isGood_(true), isStarted_(false) {
+#ifdef _WIN32
+  InitializeConditionVariable(&condition_);
+  InitializeCriticalSection(&mutex_);
+  thread_ = NULL;
+#else
+  pthread_cond_init(&condition_, NULL);
+  pthread_mutex_init(&mutex_, NULL);
+#endif /* _WIN32 */
+}
+
+TrajectoryRecorder::Writer::~Writer() {
+#ifdef _WIN32
+  DeleteCriticalSection(&mutex_);
+#else
+  pthread_cond_destroy(&condition_);
+  pthread_mutex_destroy(&mutex_);
+#endif /* _WIN32 */
+}
+
+bool TrajectoryRecorder::Writer::finish() {
+  lock();
+  isDone_ = true;
+  notify();
+  unlock();
+
+  if (isStarted_) {
+#ifdef _WIN32
+    WaitForSingleObject(thread_, INFINITE);
+    CloseHandle(thread_);
+#else
+    pthread_join(thread_, NULL);
+#endif /* _WIN32 */
+    isStarted_ = false;
+  } else {
+    /* No thread was started to write the chunks. */
+    isGood_ = isGood_ && queue_.empty();
+  }
+
+  const bool isClosed = std::fclose(file_) == 0;
+
+  return isGood_ && isClosed;
+}
+
+bool TrajectoryRecorder::Writer::isGood() {
+  lock();
+  const bool isGood = isGood_;
+  unlock();
+
+  return isGood;
+}
+
+void TrajectoryRecorder::Writer::lock() {
+#ifdef _WIN32
+  EnterCriticalSection(&mutex_);
+#else
+  pthread_mutex_lock(&mutex_);
+#endif /* _WIN32 */
+}
+
+void TrajectoryRecorder::Writer::notify() {
+#ifdef _WIN32
+  WakeAllConditionVariable(&condition_);
+#else
+  pthread_cond_broadcast(&condition_);
+#endif /* _WIN32 */
+}
+
+void TrajectoryRecorder::Writer::push(std::vector<unsigned char> *bytes) {
+  lock();
+
+  while (queue_.size() >= RVO_TRAJECTORY_MAX_QUEUED_CHUNKS) {
+    wait();
+  }
+
+  /* The buffer of a chunk that has been written is reused for the next one,
+   * so that its memory is not allocated again. */
+  queue_.push_back(std::vector<unsigned char>());
+  queue_.back().swap(*bytes);
+  bytes->swap(spare_);
+  notify();
+  unlock();
+}
+
+#ifdef _WIN32
+DWORD WINAPI TrajectoryRecorder::Writer::run(LPVOID writer) {
+  static_cast<Writer *>(writer)->write();
+
+  return 0U;
+}
+#else
+void *TrajectoryRecorder::Writer::run(void *writer) {
+  static_cast<Writer *>(writer)->write();
+
+  return NULL;
+}
+#endif /* _WIN32 */
+
+bool TrajectoryRecorder::Writer::start() {
+#ifdef _WIN32
+  thread_ = CreateThread(NULL, 0U, &Writer::run, this, 0U, NULL);
+  isStarted_ = thread_ != NULL;
+#else
+  isStarted_ = pthread_create(&thread_, NULL, &Writer::run, this) == 0;
+#endif /* _WIN32 */
+
+  return isStarted_;
+}
+
+void TrajectoryRecorder::Writer::unlock() {
+#ifdef _WIN32
+  LeaveCriticalSection(&mutex_);
+#else
+  pthread_mutex_unlock(&mutex_);
+#endif /* _WIN32 */
+}
+
+void TrajectoryRecorder::Writer::wait() {
+#ifdef _WIN32
+  SleepConditionVariableCS(&condition_, &mutex_, INFINITE);
+#else
+  pthread_cond_wait(&condition_, &mutex_);
+#endif /* _WIN32 */
+}
+
+void TrajectoryRecorder::Writer::write() {
+  lock();
+
+  while (true) {
+    while (queue_.empty() && !isDone_) {
+      wait();
+    }
+
+    if (queue_.empty()) {
+      break;
+    }
+
+    /* The chunk stays in the queue while it is written, so that it counts
+     * toward the chunks waiting. */
+    std::vector<unsigned char> &bytes = queue_.front();
+    unlock();
+
+    const bool isWritten =
+        bytes.empty() ||
+        std::fwrite(&bytes[0U], 1U, bytes.size(), file_) == bytes.size();
+
+    lock();
+    isGood_ = isGood_ && isWritten;
+    bytes.clear();
+    spare_.swap(bytes);
+    queue_.pop_front();
+    notify();
+  }
+
+  if (std::fflush(file_) != 0) {
+    isGood_ = false;
+  }
+
+  unlock();
+}
+
+TrajectoryReader::TrajectoryReader()
+    : mapping_(NULL),
+      chunkNo_(RVO_ERROR),
+      nextStepNo_(0U),
+      numSteps_(0U),
+      offset_(0U),
+      globalTime_(0.0F),
+      quantum_(0.0F),
+      hasDoubles_(false),
+      hasVelocities_(false) {}
+
+TrajectoryReader::~TrajectoryReader() { delete mapping_; }
+
+void TrajectoryReader::close() {
+  delete mapping_;
+  mapping_ = NULL;
+
+  positions_.clear();
+  velocities_.clear();
+  agentNos_.clear();
+  chunkOffsets_.clear();
+  chunkSteps_.clear();
+  quantized_.clear();
+  chunkNo_ = RVO_ERROR;
+  nextStepNo_ = 0U;
+  numSteps_ = 0U;
+  offset_ = 0U;
+  globalTime_ = 0.0F;
+  quantum_ = 0.0F;
+  hasDoubles_ = false;
+  hasVelocities_ = false;
+}
+
+bool TrajectoryReader::decodeStep() {
+  const unsigned char *bytes = mapping_->data + offset_;
+  const unsigned char *const end =
+      mapping_->data + chunkOffsets_[chunkNo_ + 1U];
+  const std::size_t numColumns = hasVelocities_ ? 4U : 2U;
+  const std::size_t realSize = hasDoubles_ ? sizeof(double) : sizeof(float);
+  std::size_t numAgents = 0U;
+
+  if (static_cast<std::size_t>(end - bytes) < realSize) {
+    return false;
+  }
+
+  const Real globalTime = readReal(bytes, hasDoubles_);
+  bytes += realSize;
+
+  if (!readVarint(&bytes, end, &numAgents) || bytes == end) {
+    return false;
+  }
+
+  const unsigned char isKeyStep = *bytes++;
+
+  /* Each value takes at least a byte, which bounds the count of agents. The
+   * first step of a chunk is stored in full. */
+  if (isKeyStep > 1U ||
+      numAgents > static_cast<std::size_t>(end - bytes) / numColumns ||
+      (isKeyStep == 0U && (nextStepNo_ == chunkSteps_[chunkNo_] ||
+                           numAgents != agentNos_.size()))) {
+    return false;
+  }
+
+  if (isKeyStep != 0U) {
+    agentNos_.resize(numAgents);
+
+    for (std::size_t i = 0U; i < numAgents; ++i) {
+      if (!readVarint(&bytes, end, &agentNos_[i])) {
+        return false;
+      }
+    }
+
+    positions_.assign(numAgents, Vector2());
+    velocities_.assign(numAgents, Vector2());
+    quantized_.assign(numColumns * numAgents, 0L);
+  }
+
+  const long maxQuantized = static_cast<long>(RVO_TRAJECTORY_MAX_QUANTIZED);
+
+  for (std::size_t column = 0U; column < numColumns; ++column) {
+    std::vector<Vector2> &vectors = column < 2U ? positions_ : velocities_;
+
+    for (std::size_t i = 0U; i < numAgents; ++i) {
+      Real value = 0.0F;
+
+      if (quantum_ > 0.0F) {
+        std::size_t difference = 0U;
+
+        if (!readVarint(&bytes, end, &difference) ||
+            difference / 2U >= 2147483647U) {
+          return false;
+        }
+
+        long &quantized = quantized_[column * numAgents + i];
+        const long delta = unzigzag(difference);
+
+        if ((delta > 0L && quantized > maxQuantized - delta) ||
+            (delta < 0L && quantized < -maxQuantized - delta)) {
+          return false;
+        }
+
+        quantized += delta;
+        value = static_cast<Real>(static_cast<double>(quantized) *
+                                  static_cast<double>(quantum_));
+      } else {
+        if (static_cast<std::size_t>(end - bytes) < realSize) {
+          return false;
+        }
+
+        value = readReal(bytes, hasDoubles_);
+        bytes += realSize;
+      }
+
+      /* The x-coordinates are decoded before the y-coordinates. */
+      vectors[i] = column % 2U == 0U ? Vector2(value, 0.0F)
+                                     : Vector2(vectors[i].x(), value);
+    }
+  }
+
+  globalTime_ = globalTime;
+  offset_ = static_cast<std::size_t>(bytes - mapping_->data);
+
+  return true;
+}
+
+std::size_t TrajectoryReader::getStepNo() const {
+  return chunkNo_ == RVO_ERROR ? RVO_ERROR : nextStepNo_ - 1U;
+}
+
+bool TrajectoryReader::open(const std::string &path) {
+  close();
+
+  Mapping *const mapping = new Mapping();
+  std::size_t version = 0U;
+
+  if (!mapping->open(path) || mapping->size < RVO_TRAJECTORY_HEADER_SIZE ||
+      std::memcmp(mapping->data, RVO_TRAJECTORY_MAGIC,
+                  sizeof(RVO_TRAJECTORY_MAGIC)) != 0 ||
+      !readSize(mapping->data + 8U, &version) ||
+      version != RVO_TRAJECTORY_VERSION ||
+      (mapping->data[16U] &
+       ~(RVO_TRAJECTORY_VELOCITIES | RVO_TRAJECTORY_DOUBLES)) != 0U) {
+    delete mapping;
+
+    return false;
+  }
+
+  const bool hasDoubles = (mapping->data[16U] & RVO_TRAJECTORY_DOUBLES) != 0U;
+  const std::size_t realSize = hasDoubles ? sizeof(double) : sizeof(float);
+
+  if (mapping->size < RVO_TRAJECTORY_HEADER_SIZE + realSize ||
+      !(readReal(mapping->data + RVO_TRAJECTORY_HEADER_SIZE, hasDoubles) >=
+        0.0F)) {
+    delete mapping;
+
+    return false;
+  }
+
+  mapping_ = mapping;
+  hasDoubles_ = hasDoubles;
+  hasVelocities_ = (mapping->data[16U] & RVO_TRAJECTORY_VELOCITIES) != 0U;
+  quantum_ = readReal(mapping->data + RVO_TRAJECTORY_HEADER_SIZE, hasDoubles);
+
+  /* Index the complete chunks. A chunk that is still being written ends the
+   * file early. */
+  std::size_t offset = RVO_TRAJECTORY_HEADER_SIZE + realSize;
+
+  while (mapping->size - offset >= RVO_TRAJECTORY_CHUNK_HEADER_SIZE) {
+    std::size_t chunkSize = 0U;
+    std::size_t numChunkSteps = 0U;
+
+    if (!readSize(mapping->data + offset, &chunkSize) ||
+        !readSize(mapping->data + offset + 8U, &numChunkSteps) ||
+        chunkSize >
+            mapping->size - offset - RVO_TRAJECTORY_CHUNK_HEADER_SIZE ||
+        numChunkSteps == 0U || numChunkSteps > chunkSize) {
+      break;
+    }
+
+    chunkOffsets_.push_back(offset + RVO_TRAJECTORY_CHUNK_HEADER_SIZE);
+    chunkSteps_.push_back(numSteps_);
+    numSteps_ += numChunkSteps;
+    offset += RVO_TRAJECTORY_CHUNK_HEADER_SIZE + chunkSize;
+  }
+
+  /* The end of the last chunk and the count of steps bound the chunks. */
+  chunkOffsets_.push_back(offset);
+  chunkSteps_.push_back(numSteps_);
+
+  return true;
+}
+
+bool TrajectoryReader::readStep(std::size_t stepNo) {
+  if (mapping_ == NULL || stepNo >= numSteps_) {
+    return false;
+  }
+
+  const std::size_t chunkNo =
+      static_cast<std::size_t>(std::upper_bound(chunkSteps_.begin(),
+                                                chunkSteps_.end(), stepNo) -
+                               chunkSteps_.begin()) -
+      1U;
+
+  if (chunkNo == chunkNo_ && stepNo + 1U == nextStepNo_) {
+    return true;
+  }
+
+  /* The steps of a chunk are stored as differences from the step before, so
+   * the chunk is decoded from its beginning unless the step follows the step
+   * read last. */
+  if (chunkNo != chunkNo_ || stepNo < nextStepNo_) {
+    chunkNo_ = chunkNo;
+    nextStepNo_ = chunkSteps_[chunkNo];
+    offset_ = chunkOffsets_[chunkNo];
+  }
+
+  while (nextStepNo_ <= stepNo) {
+    if (!decodeStep()) {
+      chunkNo_ = RVO_ERROR;
+      positions_.clear();
+      velocities_.clear();
+      agentNos_.clear();
+
+      return false;
+    }
+
+    ++nextStepNo_;
+  }
+
+  return true;
+}
+
+TrajectoryRecorder::TrajectoryRecorder()
+    : writer_(NULL),
+      numChunkSteps_(0U),
+      numSteps_(0U),
+      quantum_(0.0F),
+      recordVelocities_(false) {}
+
+TrajectoryRecorder::~TrajectoryRecorder() { close(); }
+
+bool TrajectoryRecorder::close() {
+  if (writer_ == NULL) {
+    return true;
+  }
+
+  if (numChunkSteps_ != 0U) {
+    finishChunk();
+  }
+
+  const bool isWritten = writer_->finish();
+  delete writer_;
+  writer_ = NULL;
+
+  return isWritten;
+}
+
+void TrajectoryRecorder::finishChunk() {
+  std::vector<unsigned char> header;
+  appendSize(chunk_.size() - RVO_TRAJECTORY_CHUNK_HEADER_SIZE, &header);
+  appendSize(numChunkSteps_, &header);
+  std::copy(header.begin(), header.end(), chunk_.begin());
+
+  writer_->push(&chunk_);
+  numChunkSteps_ = 0U;
+}
+
+bool TrajectoryRecorder::open(const std::string &path) {
+  return open(path, 0.0F, true);
+}
+
+bool TrajectoryRecorder::open(const std::string &path, Real quantum,
+                              bool recordVelocities) {
+  close();
+
+  if (!(quantum >= 0.0F)) {
+    return false;
+  }
+
+  std::FILE *const file = std::fopen(path.c_str(), "wb");
+
+  if (file == NULL) {
+    return false;
+  }
+
+  Writer *const writer = new Writer(file);
+
+  if (!writer->start()) {
+    writer->finish();
+    delete writer;
+
+    return false;
+  }
+
+  std::vector<unsigned char> header(
+      RVO_TRAJECTORY_MAGIC,
+      RVO_TRAJECTORY_MAGIC + sizeof(RVO_TRAJECTORY_MAGIC));
+  appendSize(RVO_TRAJECTORY_VERSION, &header);
+  header.push_back(static_cast<unsigned char>(
+      (recordVelocities ? RVO_TRAJECTORY_VELOCITIES : 0U) |
+      (sizeof(Real) == sizeof(double) ? RVO_TRAJECTORY_DOUBLES : 0U)));
+  appendReal(quantum, &header);
+  writer->push(&header);
+
+  writer_ = writer;
+  numChunkSteps_ = 0U;
+  numSteps_ = 0U;
+  quantum_ = quantum;
+  recordVelocities_ = recordVelocities;
+
+  return true;
+}
+
+bool TrajectoryRecorder::record(const RVOSimulator &simulator) {
+  if (writer_ == NULL || !writer_->isGood()) {
+    return false;
+  }
+
+  const std::size_t numAgents = simulator.getNumAgents();
+  const std::size_t numColumns = recordVelocities_ ? 4U : 2U;
+  const Vector2 *const positions = simulator.getAgentPositionBuffer();
+  const Vector2 *const velocities = simulator.getAgentVelocityBuffer();
+
+  if (numChunkSteps_ == 0U) {
+    chunk_.assign(RVO_TRAJECTORY_CHUNK_HEADER_SIZE, 0U);
+  }
+
+  /* A step is stored in full if it begins a chunk or if the agents or their
+   * order have changed, and as differences from the step before otherwise. */
+  bool isKeyStep = numChunkSteps_ == 0U || numAgents != agentNos_.size();
+
+  for (std::size_t i = 0U; i < numAgents && !isKeyStep; ++i) {
+    isKeyStep = simulator.getAgentNo(i) != agentNos_[i];
+  }
+
+  appendReal(simulator.getGlobalTime(), &chunk_);
+  appendVarint(numAgents, &chunk_);
+  chunk_.push_back(isKeyStep ? 1U : 0U);
+
+  if (isKeyStep) {
+    agentNos_.resize(numAgents);
+
+    for (std::size_t i = 0U; i < numAgents; ++i) {
+      agentNos_[i] = simulator.getAgentNo(i);
+      appendVarint(agentNos_[i], &chunk_);
+    }
+
+    quantized_.assign(numColumns * numAgents, 0L);
+  }
+
+  for (std::size_t column = 0U; column < numColumns; ++column) {
+    const Vector2 *const vectors = column < 2U ? positions : velocities;
+
+    for (std::size_t i = 0U; i < numAgents; ++i) {
+      const Real value = column % 2U == 0U ? vectors[i].x() : vectors[i].y();
+
+      if (quantum_ > 0.0F) {
+        long &quantized = quantized_[column * numAgents + i];
+        const long newQuantized = quantize(value, quantum_);
+        appendVarint(zigzag(newQuantized - quantized), &chunk_);
+        quantized = newQuantized;
+      } else {
+        appendReal(value, &chunk_);
+      }
+    }
+  }
+
+  ++numChunkSteps_;
+  ++numSteps_;
+
+  if (numChunkSteps_ == RVO_TRAJECTORY_MAX_CHUNK_STEPS ||
+      chunk_.size() >= RVO_TRAJECTORY_MAX_CHUNK_SIZE) {
+    finishChunk();
+  }
+
+  return true;
+}
+} /* namespace RVO */
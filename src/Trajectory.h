@@ -0,0 +1,318 @@
+/*
+ * Trajectory.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_TRAJECTORY_H_
+#define RVO_TRAJECTORY_H_
+
+/**
+ * @file  Trajectory.h
+ * @brief Declares the TrajectoryReader and TrajectoryRecorder classes.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Export.h"
+#include "Real.h"
+#include "Vector2.h"
+
+namespace RVO {
+class RVOSimulator;
+
+/**
+ * @brief Defines a reader of the trajectory files written by
+ *        TrajectoryRecorder. The file is mapped into memory, and the recorded
+ *        steps may be read in any order. Reading a step decodes at most the
+ *        steps before it in its chunk, so reading the steps in order decodes
+ *        each step once. Files recorded by a library of either precision may
+ *        be read.
+ */
+class RVO_EXPORT TrajectoryReader {
+ public:
+  /**
+   * @brief Constructs a trajectory reader instance that has no file open.
+   */
+  TrajectoryReader();
+
+  /**
+   * @brief Destroys this trajectory reader instance, closing its file.
+   */
+  ~TrajectoryReader();
+
+  /**
+   * @brief Closes the file of this trajectory reader, if any.
+   */
+  void close();
+
+  /**
+   * @brief     Returns the number of an agent in the step that was read last.
+   * @param[in] index The index of the agent, less than getNumAgents().
+   * @return    The number of the agent, as returned by
+   *            RVOSimulator::addAgent().
+   */
+  std::size_t getAgentNo(std::size_t index) const { return agentNos_[index]; }
+
+  /**
+   * @brief     Returns the two-dimensional position of an agent in the step
+   *            that was read last.
+   * @param[in] index The index of the agent, less than getNumAgents().
+   * @return    The two-dimensional position of the agent.
+   */
+  const Vector2 &getAgentPosition(std::size_t index) const {
+    return positions_[index];
+  }
+
+  /**
+   * @brief     Returns the two-dimensional linear velocity of an agent in the
+   *            step that was read last.
+   * @param[in] index The index of the agent, less than getNumAgents().
+   * @return    The two-dimensional linear velocity of the agent, or the zero
+   *            vector if the velocities were not recorded.
+   */
+  const Vector2 &getAgentVelocity(std::size_t index) const {
+    return velocities_[index];
+  }
+
+  /**
+   * @brief  Returns the global time of the step that was read last.
+   * @return The global time of the step.
+   */
+  Real getGlobalTime() const { return globalTime_; }
+
+  /**
+   * @brief  Returns the count of agents in the step that was read last.
+   * @return The count of agents in the step.
+   */
+  std::size_t getNumAgents() const { return agentNos_.size(); }
+
+  /**
+   * @brief  Returns the count of complete steps in the open file. Steps that
+   *         were still being written when the file was opened are not
+   *         counted.
+   * @return The count of steps in the file.
+   */
+  std::size_t getNumSteps() const { return numSteps_; }
+
+  /**
+   * @brief  Returns the quantum to which the positions and velocities were
+   *         rounded when they were recorded.
+   * @return The quantum, or zero if they were recorded exactly.
+   */
+  Real getQuantum() const { return quantum_; }
+
+  /**
+   * @brief  Returns the number of the step that was read last.
+   * @return The number of the step, counted from zero in the order in which
+   *         the steps were recorded, or RVO_ERROR if no step has been read.
+   */
+  std::size_t getStepNo() const;
+
+  /**
+   * @brief  Returns whether the velocities of the agents were recorded.
+   * @return True if the velocities were recorded; false otherwise.
+   */
+  bool hasVelocities() const { return hasVelocities_; }
+
+  /**
+   * @brief  Returns whether this trajectory reader has a file open.
+   * @return True if a file is open; false otherwise.
+   */
+  bool isOpen() const { return mapping_ != NULL; }
+
+  /**
+   * @brief     Opens a trajectory file, closing the file that is open, if any.
+   *            The file may still be being recorded.
+   * @param[in] path The path of the file.
+   * @return    True if the file was opened; false if it cannot be mapped into
+   *            memory or is not a trajectory file.
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief     Reads a step of the open file.
+   * @param[in] stepNo The number of the step, less than getNumSteps().
+   * @return    True if the step was read; false if there is no such step or
+   *            the file is corrupt.
+   */
+  bool readStep(std::size_t stepNo);
+
+ private:
+  class Mapping;
+
+  /**
+   * @brief  Decodes the next step of the current chunk.
+   * @return Whether the step was decoded.
+   */
+  bool decodeStep();
+
+  /* Not implemented. */
+  TrajectoryReader(const TrajectoryReader &other);
+
+  /* Not implemented. */
+  TrajectoryReader &operator=(const TrajectoryReader &other);
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif /* _MSC_VER */
+  std::vector<Vector2> positions_;
+  std::vector<Vector2> velocities_;
+  std::vector<std::size_t> agentNos_;
+  std::vector<std::size_t> chunkOffsets_;
+  std::vector<std::size_t> chunkSteps_;
+  std::vector<long> quantized_;
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif /* _MSC_VER */
+  Mapping *mapping_;
+  std::size_t chunkNo_;
+  std::size_t nextStepNo_;
+  std::size_t numSteps_;
+  std::size_t offset_;
+  Real globalTime_;
+  Real quantum_;
+  bool hasDoubles_;
+  bool hasVelocities_;
+};
+
+/**
+ * @brief Defines a recorder of the trajectories of the agents to a binary file.
+ *        Each recorded step holds the global time and the numbers, positions,
+ *        and optionally velocities of the agents. The steps are grouped in
+ *        chunks that are written by a background thread, so that recording
+ *        does not wait for the file. Within a step each property is stored as
+ *        a column. The positions and velocities may be rounded to a quantum
+ *        and stored as differences from the previous step, which shrinks the
+ *        file several times. Each chunk begins with a step stored in full, so
+ *        that it may be decoded on its own.
+ * @note  Recording a large simulation this way is far faster than printing
+ *        the positions of the agents as text, as the examples do.
+ */
+class RVO_EXPORT TrajectoryRecorder {
+ public:
+  /**
+   * @brief Constructs a trajectory recorder instance that has no file open.
+   */
+  TrajectoryRecorder();
+
+  /**
+   * @brief Destroys this trajectory recorder instance, closing its file.
+   */
+  ~TrajectoryRecorder();
+
+  /**
+   * @brief  Writes the steps that have been recorded and closes the file of
+   *         this trajectory recorder, if any. Waits for the background thread
+   *         to finish writing.
+   * @return True if every step was written; false otherwise.
+   */
+  bool close();
+
+  /**
+   * @brief  Returns the count of steps recorded to the open file.
+   * @return The count of steps recorded.
+   */
+  std::size_t getNumSteps() const { return numSteps_; }
+
+  /**
+   * @brief  Returns whether this trajectory recorder has a file open.
+   * @return True if a file is open; false otherwise.
+   */
+  bool isOpen() const { return writer_ != NULL; }
+
+  /**
+   * @brief     Opens a trajectory file for recording the exact positions and
+   *            velocities of the agents, closing the file that is open, if
+   *            any.
+   * @param[in] path The path of the file, which is replaced.
+   * @return    True if the file was opened; false otherwise.
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief     Opens a trajectory file for recording, closing the file that is
+   *            open, if any.
+   * @param[in] path             The path of the file, which is replaced.
+   * @param[in] quantum          The quantum to which the positions and
+   *                             velocities are rounded, or zero to record them
+   *                             exactly. Coordinates are limited to about one
+   *                             billion quanta from the origin.
+   * @param[in] recordVelocities Whether the velocities are recorded.
+   * @return    True if the file was opened; false otherwise.
+   */
+  bool open(const std::string &path, Real quantum, bool recordVelocities);
+
+  /**
+   * @brief     Records the present state of the agents of a simulation as the
+   *            next step. Waits only if the background thread has fallen
+   *            several chunks behind.
+   * @param[in] simulator The simulation, whose step is to be complete.
+   * @return    True if the step was recorded; false if no file is open or
+   *            writing the file has failed.
+   */
+  bool record(const RVOSimulator &simulator);
+
+ private:
+  class Writer;
+
+  /**
+   * @brief Hands the current chunk to the background thread.
+   */
+  void finishChunk();
+
+  /* Not implemented. */
+  TrajectoryRecorder(const TrajectoryRecorder &other);
+
+  /* Not implemented. */
+  TrajectoryRecorder &operator=(const TrajectoryRecorder &other);
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif /* _MSC_VER */
+  std::vector<std::size_t> agentNos_;
+  std::vector<long> quantized_;
+  std::vector<unsigned char> chunk_;
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif /* _MSC_VER */
+  Writer *writer_;
+  std::size_t numChunkSteps_;
+  std::size_t numSteps_;
+  Real quantum_;
+  bool recordVelocities_;
+};
+} /* namespace RVO */
+
+#endif /* RVO_TRAJECTORY_H_ */
@@ -42,24 +42,24 @@
 #include <ostream>
 
 namespace RVO {
-const float RVO_EPSILON = 0.00001F;
+const Real RVO_EPSILON = static_cast<Real>(0.00001);
 
 Vector2::Vector2() : x_(0.0F), y_(0.0F) {}
 
-Vector2::Vector2(float x, float y) : x_(x), y_(y) {}
+Vector2::Vector2(Real x, Real y) : x_(x), y_(y) {}
 
 Vector2 Vector2::operator-() const { return Vector2(-x_, -y_); }
 
-float Vector2::operator*(const Vector2 &vector) const {
+Real Vector2::operator*(const Vector2 &vector) const {
   return x_ * vector.x_ + y_ * vector.y_;
 }
 
-Vector2 Vector2::operator*(float scalar) const {
+Vector2 Vector2::operator*(Real scalar) const {
   return Vector2(x_ * scalar, y_ * scalar);
 }
 
-Vector2 Vector2::operator/(float scalar) const {
-  const float invScalar = 1.0F / scalar;
+Vector2 Vector2::operator/(Real scalar) const {
+  const Real invScalar = 1.0F / scalar;
 
   return Vector2(x_ * invScalar, y_ * invScalar);
 }
@@ -80,15 +80,15 @@ bool Vector2::operator!=(const Vector2 &vector) const {
   return x_ != vector.x_ || y_ != vector.y_;
 }
 
-Vector2 &Vector2::operator*=(float scalar) {
+Vector2 &Vector2::operator*=(Real scalar) {
   x_ *= scalar;
   y_ *= scalar;
 
   return *this;
 }
 
-Vector2 &Vector2::operator/=(float scalar) {
-  const float invScalar = 1.0F / scalar;
+Vector2 &Vector2::operator/=(Real scalar) {
+  const Real invScalar = 1.0F / scalar;
   x_ *= invScalar;
   y_ *= invScalar;
 
@@ -109,7 +109,7 @@ Vector2 &Vector2::operator-=(const Vector2 &vector) {
   return *this;
 }
 
-Vector2 operator*(float scalar, const Vector2 &vector) {
+Vector2 operator*(Real scalar, const Vector2 &vector) {
   return Vector2(scalar * vector.x(), scalar * vector.y());
 }
 
@@ -119,15 +119,15 @@ std::ostream &operator<<(std::ostream &stream, const Vector2 &vector) {
   return stream;
 }
 
-float abs(const Vector2 &vector) { return std::sqrt(vector * vector); }
+Real abs(const Vector2 &vector) { return std::sqrt(vector * vector); }
 
-float absSq(const Vector2 &vector) { return vector * vector; }
+Real absSq(const Vector2 &vector) { return vector * vector; }
 
-float det(const Vector2 &vector1, const Vector2 &vector2) {
+Real det(const Vector2 &vector1, const Vector2 &vector2) {
   return vector1.x() * vector2.y() - vector1.y() * vector2.x();
 }
 
-float leftOf(const Vector2 &vector1, const Vector2 &vector2,
+Real leftOf(const Vector2 &vector1, const Vector2 &vector2,
              const Vector2 &vector3) {
   return det(vector1 - vector3, vector2 - vector1);
 }
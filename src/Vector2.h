@@ -42,12 +42,13 @@
 #include <iosfwd>
 
 #include "Export.h"
+#include "Real.h"
 
 namespace RVO {
 /**
  * @brief A sufficiently small positive number.
  */
-RVO_EXPORT extern const float RVO_EPSILON;
+RVO_EXPORT extern const Real RVO_EPSILON;
 
 /**
  * @brief Defines a two-dimensional vector.
@@ -66,19 +67,19 @@ class RVO_EXPORT Vector2 {
    * @param[in] x The x-coordinate of the two-dimensional vector.
    * @param[in] y The y-coordinate of the two-dimensional vector.
    */
-  Vector2(float x, float y);
+  Vector2(Real x, Real y);
 
   /**
    * @brief  Returns the x-coordinate of this two-dimensional vector.
    * @return The x-coordinate of the two-dimensional vector.
    */
-  float x() const { return x_; }
+  Real x() const { return x_; }
 
   /**
    * @brief  Returns the y-coordinate of this two-dimensional vector.
    * @return The y-coordinate of the two-dimensional vector.
    */
-  float y() const { return y_; }
+  Real y() const { return y_; }
 
   /**
    * @brief  Computes the negation of this two-dimensional vector.
@@ -94,7 +95,7 @@ class RVO_EXPORT Vector2 {
    * @return    The dot product of this two-dimensional vector with a specified
    *            two-dimensional vector.
    */
-  float operator*(const Vector2 &vector) const;
+  Real operator*(const Vector2 &vector) const;
 
   /**
    * @brief     Computes the scalar multiplication of this two-dimensional
@@ -104,7 +105,7 @@ class RVO_EXPORT Vector2 {
    * @return    The scalar multiplication of this two-dimensional vector with a
    *            specified scalar value.
    */
-  Vector2 operator*(float scalar) const;
+  Vector2 operator*(Real scalar) const;
 
   /**
    * @brief     Computes the scalar division of this two-dimensional vector with
@@ -114,7 +115,7 @@ class RVO_EXPORT Vector2 {
    * @return    The scalar division of this two-dimensional vector with a
    *            specified scalar value.
    */
-  Vector2 operator/(float scalar) const;
+  Vector2 operator/(Real scalar) const;
 
   /**
    * @brief     Computes the vector sum of this two-dimensional vector with the
@@ -161,7 +162,7 @@ class RVO_EXPORT Vector2 {
    *                   should be computed.
    * @return    A reference to this two-dimensional vector.
    */
-  Vector2 &operator*=(float scalar);
+  Vector2 &operator*=(Real scalar);
 
   /**
    * @brief     Sets the value of this two-dimensional vector to the scalar
@@ -170,7 +171,7 @@ class RVO_EXPORT Vector2 {
    *                   computed.
    * @return    A reference to this two-dimensional vector.
    */
-  Vector2 &operator/=(float scalar);
+  Vector2 &operator/=(Real scalar);
 
   /**
    * @brief     Sets the value of this two-dimensional vector to the vector sum
@@ -191,8 +192,8 @@ class RVO_EXPORT Vector2 {
   Vector2 &operator-=(const Vector2 &vector);
 
  private:
-  float x_;
-  float y_;
+  Real x_;
+  Real y_;
 };
 
 /**
@@ -206,7 +207,7 @@ class RVO_EXPORT Vector2 {
  * @return    The scalar multiplication of the two-dimensional vector with the
  *            scalar value.
  */
-RVO_EXPORT Vector2 operator*(float scalar, const Vector2 &vector);
+RVO_EXPORT Vector2 operator*(Real scalar, const Vector2 &vector);
 
 /**
  * @relates        Vector2
@@ -227,7 +228,7 @@ RVO_EXPORT std::ostream &operator<<(std::ostream &stream,
  * @param[in] vector The two-dimensional vector whose length is to be computed.
  * @return    The length of the two-dimensional vector.
  */
-RVO_EXPORT float abs(const Vector2 &vector);
+RVO_EXPORT Real abs(const Vector2 &vector);
 
 /**
  * @relates   Vector2
@@ -236,7 +237,7 @@ RVO_EXPORT float abs(const Vector2 &vector);
  *                   computed.
  * @return    The squared length of the two-dimensional vector.
  */
-RVO_EXPORT float absSq(const Vector2 &vector);
+RVO_EXPORT Real absSq(const Vector2 &vector);
 
 /**
  * @relates   Vector2
@@ -246,7 +247,7 @@ RVO_EXPORT float absSq(const Vector2 &vector);
  * @param[in] vector2 The bottom row of the two-dimensional square matrix.
  * @return    The determinant of the two-dimensional square matrix.
  */
-RVO_EXPORT float det(const Vector2 &vector1, const Vector2 &vector2);
+RVO_EXPORT Real det(const Vector2 &vector1, const Vector2 &vector2);
 
 /**
  * @brief     Computes the signed distance from a line connecting th specified
@@ -258,7 +259,7 @@ RVO_EXPORT float det(const Vector2 &vector1, const Vector2 &vector2);
  * @return    Positive when the point vector3 lies to the left of the line
  *            vector1-vector2.
  */
-RVO_EXPORT float leftOf(const Vector2 &vector1, const Vector2 &vector2,
+RVO_EXPORT Real leftOf(const Vector2 &vector1, const Vector2 &vector2,
                         const Vector2 &vector3);
 
 /**
@@ -0,0 +1,152 @@
+/*
+ * Allocations.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/*
+ * @file  Allocations.cc
+ * @brief Test that counts the calls to operator new and checks that a
+ *        simulation step of a warmed-up scene allocates no memory.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "RVO.h"
+
+namespace {
+const RVO::Real RVO_TWO_PI = static_cast<RVO::Real>(6.283185307179586);
+
+/* The count of calls to operator new. Increments from threads that race may
+ * be lost, but the count never stays at zero once memory is allocated. */
+std::size_t numAllocations = 0U;
+
+void *allocate(std::size_t size) {
+  ++numAllocations;
+
+  void *pointer = std::malloc(size == 0U ? 1U : size);
+
+  if (pointer == NULL) {
+    throw std::bad_alloc();
+  }
+
+  return pointer;
+}
+
+void setupScenario(RVO::RVOSimulator *simulator) {
+  simulator->setTimeStep(0.25F);
+  simulator->setAgentDefaults(15.0F, 10U, 5.0F, 5.0F, 1.0F, 2.0F);
+
+  /* Agents on two rings around four blocks. */
+  for (std::size_t i = 0U; i < 200U; ++i) {
+    const RVO::Real angle = static_cast<RVO::Real>(i) * RVO_TWO_PI * 0.01F;
+    const RVO::Real radius = i % 2U == 0U ? 40.0F : 44.0F;
+    simulator->addAgent(radius *
+                        RVO::Vector2(std::cos(angle), std::sin(angle)));
+  }
+
+  for (RVO::Real x = -1.0F; x <= 1.0F; x += 2.0F) {
+    for (RVO::Real y = -1.0F; y <= 1.0F; y += 2.0F) {
+      std::vector<RVO::Vector2> vertices;
+      vertices.push_back(RVO::Vector2(x * 5.0F, y * 5.0F));
+      vertices.push_back(RVO::Vector2(x * 30.0F, y * 5.0F));
+      vertices.push_back(RVO::Vector2(x * 30.0F, y * 30.0F));
+      vertices.push_back(RVO::Vector2(x * 5.0F, y * 30.0F));
+
+      if (x * y < 0.0F) {
+        /* Keep the vertices in counterclockwise order. */
+        std::swap(vertices[1U], vertices[3U]);
+      }
+
+      simulator->addObstacle(vertices);
+    }
+  }
+
+  simulator->processObstacles();
+}
+
+/* Steers the agents counterclockwise around the rings, so that the scene
+ * repeats itself without end. */
+void setPreferredVelocities(RVO::RVOSimulator *simulator) {
+  for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+    const RVO::Vector2 position = simulator->getAgentPosition(i);
+    const RVO::Real radius = i % 2U == 0U ? 40.0F : 44.0F;
+    const RVO::Real distance = RVO::abs(position);
+    const RVO::Vector2 tangent(-position.y() / distance,
+                               position.x() / distance);
+
+    simulator->setAgentPrefVelocity(
+        i, 1.5F * tangent +
+               (radius - distance) * 0.5F * (position / distance));
+  }
+}
+
+void doSteps(RVO::RVOSimulator *simulator, std::size_t numSteps) {
+  for (std::size_t i = 0U; i < numSteps; ++i) {
+    setPreferredVelocities(simulator);
+    simulator->doStep();
+  }
+}
+} /* namespace */
+
+void *operator new(std::size_t size) throw(std::bad_alloc) {
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size) throw(std::bad_alloc) {
+  return allocate(size);
+}
+
+void operator delete(void *pointer) throw() { std::free(pointer); }
+
+void operator delete[](void *pointer) throw() { std::free(pointer); }
+
+int main() {
+  RVO::RVOSimulator simulator;
+  setupScenario(&simulator);
+
+  /* The scratch space of the agents and of the k-D trees grows to its
+   * high-water mark in the first laps around the rings. */
+  doSteps(&simulator, 1000U);
+
+  const std::size_t numWarmupAllocations = numAllocations;
+  doSteps(&simulator, 1000U);
+  const std::size_t numStepAllocations = numAllocations - numWarmupAllocations;
+
+  std::cout << numStepAllocations << " allocations after warm-up" << std::endl;
+
+  return numStepAllocations == 0U ? EXIT_SUCCESS : EXIT_FAILURE;
+}